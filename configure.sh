@@ -8,6 +8,7 @@ Usage: ./configure.sh [options]
   -m, --mode TYPE       Debug|Release|RelWithDebInfo (default: Debug)
   -t, --tests           BUILD_TESTS=ON
   -e, --examples        BUILD_EXAMPLES=ON
+      --tools           BUILD_TOOLS=ON
       --asan            ENABLE_ASAN=ON
       --tsan            ENABLE_TSAN=ON
       --flame           ENABLE_FP=ON
@@ -24,7 +25,7 @@ to_preset(){ case "$1" in Debug) echo debug;; Release) echo release;; RelWithDeb
 
 command -v cmake >/dev/null 2>&1 || die "cmake not found in PATH"
 
-MODE="debug" BUILD_EXAMPLES=OFF BUILD_TESTS=OFF
+MODE="debug" BUILD_EXAMPLES=OFF BUILD_TESTS=OFF BUILD_TOOLS=OFF
 ENABLE_ASAN=OFF ENABLE_TSAN=OFF ENABLE_FP=OFF
 RUN_BUILD=OFF RUN_INSTALL=OFF JOBS=""
 PYTHON_UDL_INTERFACE_PREFIX="${PYTHON_UDL_INTERFACE_PREFIX:-/usr/local}"
@@ -34,6 +35,7 @@ while [[ $# -gt 0 ]]; do
         -m|--mode) [[ $# -lt 2 ]] && die "missing value for $1"; MODE="$2"; shift ;;
         -t|--tests) BUILD_TESTS=ON ;;
         -e|--examples) BUILD_EXAMPLES=ON ;;
+        --tools) BUILD_TOOLS=ON ;;
         --asan) ENABLE_ASAN=ON ;;
         --tsan) ENABLE_TSAN=ON ;;
         --flame) ENABLE_FP=ON ;;
@@ -61,6 +63,7 @@ cmake --preset "$MODE" \
     --install-prefix "$PYTHON_UDL_INTERFACE_PREFIX" \
     -DBUILD_EXAMPLES="$BUILD_EXAMPLES" \
     -DBUILD_TESTS="$BUILD_TESTS" \
+    -DBUILD_TOOLS="$BUILD_TOOLS" \
     -DENABLE_ASAN="$ENABLE_ASAN" \
     -DENABLE_TSAN="$ENABLE_TSAN" \
     -DENABLE_FP="$ENABLE_FP" \
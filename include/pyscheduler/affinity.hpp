@@ -0,0 +1,44 @@
+#pragma once
+#include <pthread.h>
+#include <vector>
+
+namespace pyscheduler {
+
+/// @brief Where a thread may run and, optionally, where the memory it allocates is placed.
+/// The default leaves the thread to the OS scheduler.
+struct ThreadAffinity {
+	/// CPUs the thread may run on. Empty pins to the CPUs of numa_node, if set.
+	std::vector<int> cpus;
+	/// NUMA node the thread belongs to; -1 for none.
+	int numa_node = -1;
+	/// Prefer numa_node for the thread's allocations (set_mempolicy MPOL_PREFERRED), so
+	/// objects committed on the thread live on the node that consumes them.
+	bool numa_local_memory = false;
+
+	bool empty() const {
+		return cpus.empty() && numa_node < 0;
+	}
+};
+
+/// @brief CPUs of a NUMA node, read from sysfs; empty if the node does not exist.
+std::vector<int> numaNodeCpus(int node);
+
+/// @brief CPUs an affinity pins to: its cpus, else the CPUs of its numa_node, else none.
+/// @throws std::invalid_argument for a negative CPU id, an unknown NUMA node, or
+/// numa_local_memory without a numa_node.
+std::vector<int> resolveAffinityCpus(const ThreadAffinity& affinity);
+
+/// @brief Applies an affinity to the calling thread: CPU set and, if requested, the NUMA
+/// memory policy.
+/// @throws std::invalid_argument as resolveAffinityCpus; std::system_error if the kernel
+/// rejects the CPU set or memory policy.
+void applyThreadAffinity(const ThreadAffinity& affinity);
+
+/// @brief Restricts another thread to cpus. Memory policy is per thread and can only be set
+/// by the thread itself, so this covers the CPU set only.
+/// @throws std::system_error if the kernel rejects the CPU set.
+void setThreadCpus(pthread_t thread, const std::vector<int>& cpus);
+
+} // namespace pyscheduler
+
+#include "pyscheduler/details/affinity_impl.hpp"
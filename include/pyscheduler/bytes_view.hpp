@@ -0,0 +1,31 @@
+#pragma once
+#include <pybind11/pybind11.h>
+
+#include <string_view>
+#include <type_traits>
+
+namespace pyscheduler {
+
+/// @brief Hands an owned byte container (std::string, std::vector<uint8_t>, ...) to Python
+/// as a read-only memoryview without copying its bytes.
+///
+/// The container is moved into a Python object that exports it through the buffer protocol
+/// and is destroyed when the last view of it is released, so the cost is independent of the
+/// payload size. Meant for commit functions; requires the GIL.
+///
+/// @tparam Container Contiguous container of 1-byte elements with data() and size(), passed
+/// as an rvalue.
+template <typename Container>
+pybind11::memoryview makeBytesView(Container&& bytes);
+
+/// @brief Read-only view of the bytes of a Python bytes, bytearray or C-contiguous memoryview,
+/// without copying. Meant for callbacks; requires the GIL.
+///
+/// The view is valid while obj is alive and unmodified; copy it before the callback returns
+/// if it must outlive the result.
+/// @throws std::invalid_argument for any other object.
+std::string_view bytesView(pybind11::handle obj);
+
+} // namespace pyscheduler
+
+#include "pyscheduler/details/bytes_view_impl.hpp"
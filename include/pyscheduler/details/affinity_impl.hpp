@@ -0,0 +1,103 @@
+#ifdef __INTELLISENSE__
+#	include "pyscheduler/affinity.hpp"
+#endif
+
+#include <cerrno>
+#include <fstream>
+#include <sched.h>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <sys/syscall.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace pyscheduler {
+
+namespace details {
+
+/// Kernel ABI value of MPOL_PREFERRED (linux/mempolicy.h); avoids a libnuma dependency.
+constexpr int kMpolPreferred = 1;
+
+inline cpu_set_t toCpuSet(const std::vector<int>& cpus) {
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for(int cpu : cpus) {
+		if(cpu < 0 || cpu >= CPU_SETSIZE) {
+			throw std::invalid_argument("CPU id out of range: " + std::to_string(cpu));
+		}
+		CPU_SET(cpu, &set);
+	}
+	return set;
+}
+
+} // namespace details
+
+inline std::vector<int> numaNodeCpus(int node) {
+	std::vector<int> cpus;
+	if(node < 0) return cpus;
+
+	// cpulist is a comma-separated list of ids and ranges, e.g. "0-3,8-11"
+	std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+	std::string list;
+	if(!std::getline(file, list)) return cpus;
+	std::stringstream ranges(list);
+	std::string range;
+	while(std::getline(ranges, range, ',')) {
+		if(range.empty()) continue;
+		auto dash = range.find('-');
+		int first = std::stoi(range.substr(0, dash));
+		int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+		for(int cpu = first; cpu <= last; cpu++) {
+			cpus.push_back(cpu);
+		}
+	}
+	return cpus;
+}
+
+inline std::vector<int> resolveAffinityCpus(const ThreadAffinity& affinity) {
+	if(affinity.numa_local_memory && affinity.numa_node < 0) {
+		throw std::invalid_argument("numa_local_memory requires a numa_node");
+	}
+	for(int cpu : affinity.cpus) {
+		if(cpu < 0 || cpu >= CPU_SETSIZE) {
+			throw std::invalid_argument("CPU id out of range: " + std::to_string(cpu));
+		}
+	}
+	if(affinity.numa_node < 0) return affinity.cpus;
+
+	std::vector<int> node_cpus = numaNodeCpus(affinity.numa_node);
+	if(node_cpus.empty()) {
+		throw std::invalid_argument("Unknown NUMA node: " + std::to_string(affinity.numa_node));
+	}
+	return affinity.cpus.empty() ? node_cpus : affinity.cpus;
+}
+
+inline void setThreadCpus(pthread_t thread, const std::vector<int>& cpus) {
+	if(cpus.empty()) return;
+	cpu_set_t set = details::toCpuSet(cpus);
+	int err = pthread_setaffinity_np(thread, sizeof(set), &set);
+	if(err != 0) {
+		throw std::system_error(err, std::generic_category(), "pthread_setaffinity_np failed");
+	}
+}
+
+inline void applyThreadAffinity(const ThreadAffinity& affinity) {
+	setThreadCpus(pthread_self(), resolveAffinityCpus(affinity));
+
+	if(affinity.numa_local_memory) {
+		// The kernel reads maxnode - 1 bits of the mask
+		constexpr size_t kBitsPerWord = sizeof(unsigned long) * 8;
+		const auto node = static_cast<size_t>(affinity.numa_node);
+		std::vector<unsigned long> mask(node / kBitsPerWord + 1, 0);
+		mask[node / kBitsPerWord] |= 1UL << (node % kBitsPerWord);
+		if(syscall(SYS_set_mempolicy,
+				   details::kMpolPreferred,
+				   mask.data(),
+				   static_cast<unsigned long>(mask.size() * kBitsPerWord + 1)) != 0) {
+			throw std::system_error(errno, std::generic_category(), "set_mempolicy failed");
+		}
+	}
+}
+
+} // namespace pyscheduler
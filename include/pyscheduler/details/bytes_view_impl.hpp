@@ -0,0 +1,107 @@
+#ifdef __INTELLISENSE__
+#	include "pyscheduler/bytes_view.hpp"
+#endif
+
+#include <stdexcept>
+#include <utility>
+
+namespace pyscheduler {
+
+namespace details {
+
+/// @brief Python object owning a type-erased C++ byte container and exporting it read-only.
+struct OwnedBufferObject {
+	PyObject_HEAD
+	void* storage;
+	void (*destroy)(void*);
+	char* data;
+	Py_ssize_t size;
+};
+
+inline int ownedBufferGet(PyObject* self, Py_buffer* view, int flags) {
+	auto* owned = reinterpret_cast<OwnedBufferObject*>(self);
+	// Read-only: fails with BufferError if the consumer asks for a writable buffer
+	return PyBuffer_FillInfo(view, self, owned->data, owned->size, 1, flags);
+}
+
+inline void ownedBufferDealloc(PyObject* self) {
+	auto* owned = reinterpret_cast<OwnedBufferObject*>(self);
+	if(owned->destroy != nullptr) owned->destroy(owned->storage);
+	PyTypeObject* type = Py_TYPE(self);
+	type->tp_free(self);
+	Py_DECREF(type);
+}
+
+/// @brief The OwnedBuffer type of the current interpreter, created on first use and cached
+/// in the interpreter's state dict, so subinterpreters each get their own. Requires the GIL.
+inline PyTypeObject* ownedBufferType() {
+	constexpr const char* kKey = "pyscheduler.OwnedBuffer";
+	PyObject* dict = PyInterpreterState_GetDict(PyInterpreterState_Get());
+	if(dict == nullptr) {
+		throw std::runtime_error("Interpreter has no state dict");
+	}
+	if(PyObject* cached = PyDict_GetItemString(dict, kKey)) {
+		return reinterpret_cast<PyTypeObject*>(cached);
+	}
+
+	static PyType_Slot slots[] = {
+		{ Py_bf_getbuffer, reinterpret_cast<void*>(&ownedBufferGet) },
+		{ Py_tp_dealloc, reinterpret_cast<void*>(&ownedBufferDealloc) },
+		{ 0, nullptr },
+	};
+	static PyType_Spec spec = {
+		kKey, sizeof(OwnedBufferObject), 0, Py_TPFLAGS_DEFAULT, slots
+	};
+	auto type = pybind11::reinterpret_steal<pybind11::object>(PyType_FromSpec(&spec));
+	if(!type || PyDict_SetItemString(dict, kKey, type.ptr()) != 0) {
+		throw pybind11::error_already_set();
+	}
+	// The state dict keeps the type alive for the interpreter's lifetime
+	return reinterpret_cast<PyTypeObject*>(type.ptr());
+}
+
+} // namespace details
+
+template <typename Container>
+pybind11::memoryview makeBytesView(Container&& bytes) {
+	using Stored = std::remove_cvref_t<Container>;
+	static_assert(!std::is_lvalue_reference_v<Container>,
+				  "makeBytesView takes ownership; std::move the container in.");
+	static_assert(sizeof(*std::declval<Stored&>().data()) == 1,
+				  "makeBytesView needs a container of 1-byte elements.");
+
+	PyTypeObject* type = details::ownedBufferType();
+	auto exporter = pybind11::reinterpret_steal<pybind11::object>(type->tp_alloc(type, 0));
+	if(!exporter) throw pybind11::error_already_set();
+
+	auto* owned = reinterpret_cast<details::OwnedBufferObject*>(exporter.ptr());
+	auto* storage = new Stored(std::move(bytes));
+	owned->storage = storage;
+	owned->destroy = [](void* p) { delete static_cast<Stored*>(p); };
+	owned->data = const_cast<char*>(reinterpret_cast<const char*>(storage->data()));
+	owned->size = static_cast<Py_ssize_t>(storage->size());
+
+	auto view = pybind11::reinterpret_steal<pybind11::memoryview>(
+		PyMemoryView_FromObject(exporter.ptr()));
+	if(!view) throw pybind11::error_already_set();
+	return view;
+}
+
+inline std::string_view bytesView(pybind11::handle obj) {
+	PyObject* ptr = obj.ptr();
+	if(PyBytes_Check(ptr)) {
+		return { PyBytes_AS_STRING(ptr), static_cast<size_t>(PyBytes_GET_SIZE(ptr)) };
+	}
+	if(PyByteArray_Check(ptr)) {
+		return { PyByteArray_AS_STRING(ptr), static_cast<size_t>(PyByteArray_GET_SIZE(ptr)) };
+	}
+	if(PyMemoryView_Check(ptr)) {
+		const Py_buffer* buffer = PyMemoryView_GET_BUFFER(ptr);
+		if(buffer->buf != nullptr && PyBuffer_IsContiguous(buffer, 'C')) {
+			return { static_cast<const char*>(buffer->buf), static_cast<size_t>(buffer->len) };
+		}
+	}
+	throw std::invalid_argument("Expected bytes, bytearray or a C-contiguous memoryview");
+}
+
+} // namespace pyscheduler
@@ -0,0 +1,92 @@
+#ifdef __INTELLISENSE__
+#	include "pyscheduler/fixed_ring.hpp"
+#endif
+
+#include <utility>
+
+namespace pyscheduler {
+
+namespace details {
+
+template <typename T>
+FixedRing<T>::FixedRing(size_t capacity)
+	: _slots(std::make_unique<T[]>(capacity))
+	, _capacity(capacity) {}
+
+template <typename T>
+void FixedRing<T>::push_back(T&& value) {
+	_slots[slot(_size)] = std::move(value);
+	_size++;
+}
+
+template <typename T>
+void FixedRing<T>::pop_front() {
+	_slots[_head] = T();
+	_head = _head + 1 == _capacity ? 0 : _head + 1;
+	_size--;
+}
+
+template <typename T>
+void FixedRing<T>::clear() {
+	while(_size > 0) {
+		pop_front();
+	}
+	_head = 0;
+}
+
+template <typename T>
+T& FixedRing<T>::front() {
+	return _slots[_head];
+}
+
+template <typename T>
+const T& FixedRing<T>::front() const {
+	return _slots[_head];
+}
+
+template <typename T>
+T& FixedRing<T>::operator[](size_t index) {
+	return _slots[slot(index)];
+}
+
+template <typename T>
+const T& FixedRing<T>::operator[](size_t index) const {
+	return _slots[slot(index)];
+}
+
+template <typename T>
+void FixedRing<T>::move_forward(size_t index, size_t to) {
+	for(size_t i = index; i > to; i--) {
+		std::swap(_slots[slot(i)], _slots[slot(i - 1)]);
+	}
+}
+
+template <typename T>
+size_t FixedRing<T>::size() const {
+	return _size;
+}
+
+template <typename T>
+size_t FixedRing<T>::capacity() const {
+	return _capacity;
+}
+
+template <typename T>
+bool FixedRing<T>::empty() const {
+	return _size == 0;
+}
+
+template <typename T>
+bool FixedRing<T>::full() const {
+	return _size == _capacity;
+}
+
+template <typename T>
+size_t FixedRing<T>::slot(size_t index) const {
+	const size_t position = _head + index;
+	return position < _capacity ? position : position - _capacity;
+}
+
+} // namespace details
+
+} // namespace pyscheduler
@@ -0,0 +1,171 @@
+#ifdef __INTELLISENSE__
+#	include "pyscheduler/frame_profiler.hpp"
+#endif
+
+#include <algorithm>
+#include <chrono>
+
+namespace pyscheduler {
+
+namespace details {
+/// @brief Makes a label safe for the folded format, where ';' separates frames and lines
+/// end in newlines.
+inline std::string foldedLabel(std::string label) {
+	std::replace(label.begin(), label.end(), ';', ':');
+	std::replace(label.begin(), label.end(), '\n', ' ');
+	return label;
+}
+
+inline std::int64_t profilerNowNs() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			   std::chrono::steady_clock::now().time_since_epoch())
+		.count();
+}
+} // namespace details
+
+inline FrameProfiler::FrameProfiler(std::string root) {
+	_labels.push_back(details::foldedLabel(std::move(root)));
+	_nodes.emplace_back();
+	_self = pybind11::reinterpret_steal<pybind11::capsule>(
+		PyCapsule_New(this, "pyscheduler.FrameProfiler", nullptr));
+	if(!_self) throw pybind11::error_already_set();
+}
+
+inline FrameProfiler::~FrameProfiler() {
+	if(_attached) detach();
+}
+
+inline void FrameProfiler::attach() {
+	PyEval_SetProfile(&FrameProfiler::hook, _self.ptr());
+	_attached = true;
+}
+
+inline void FrameProfiler::detach() {
+	PyEval_SetProfile(nullptr, nullptr);
+	_stack.clear();
+	_attached = false;
+}
+
+inline int FrameProfiler::hook(PyObject* self, PyFrameObject* frame, int what, PyObject* arg) {
+	auto* profiler =
+		static_cast<FrameProfiler*>(PyCapsule_GetPointer(self, "pyscheduler.FrameProfiler"));
+	if(profiler == nullptr) {
+		PyErr_Clear();
+		return 0;
+	}
+	const std::int64_t now = details::profilerNowNs();
+	switch(what) {
+	case PyTrace_CALL: profiler->enter(profiler->codeLabel(frame), now); break;
+	case PyTrace_C_CALL: profiler->enter(profiler->builtinLabel(arg), now); break;
+	case PyTrace_RETURN:
+	case PyTrace_C_RETURN:
+	case PyTrace_C_EXCEPTION: profiler->leave(now); break;
+	default: break;
+	}
+	return 0;
+}
+
+inline void FrameProfiler::enter(uint32_t label, std::int64_t now_ns) {
+	const uint32_t parent = _stack.empty() ? 0 : _stack.back().node;
+	uint32_t node = 0;
+	auto found = _nodes[parent].children.find(label);
+	if(found != _nodes[parent].children.end()) {
+		node = found->second;
+	} else {
+		node = static_cast<uint32_t>(_nodes.size());
+		_nodes[parent].children.emplace(label, node);
+		Node created;
+		created.parent = parent;
+		created.label = label;
+		_nodes.push_back(std::move(created));
+	}
+	_stack.push_back(Frame{ node, now_ns, 0 });
+}
+
+inline void FrameProfiler::leave(std::int64_t now_ns) {
+	// Frames that were already running when the profiler attached return unmatched
+	if(_stack.empty()) return;
+	Frame frame = _stack.back();
+	_stack.pop_back();
+	const auto total =
+		static_cast<uint64_t>(std::max<std::int64_t>(now_ns - frame.start_ns, 0));
+	_nodes[frame.node].self_ns += total - std::min(frame.child_ns, total);
+	if(!_stack.empty()) _stack.back().child_ns += total;
+}
+
+inline uint32_t FrameProfiler::intern(const void* key, std::string label) {
+	const auto id = static_cast<uint32_t>(_labels.size());
+	_labels.push_back(details::foldedLabel(std::move(label)));
+	_label_ids.emplace(key, id);
+	return id;
+}
+
+inline uint32_t FrameProfiler::codeLabel(PyFrameObject* frame) {
+	auto code = pybind11::reinterpret_steal<pybind11::object>(
+		reinterpret_cast<PyObject*>(PyFrame_GetCode(frame)));
+	if(auto it = _label_ids.find(code.ptr()); it != _label_ids.end()) return it->second;
+
+	std::string label = "<unknown>";
+	try {
+		const char* name_attr = pybind11::hasattr(code, "co_qualname") ? "co_qualname" : "co_name";
+		label = pybind11::str(code.attr(name_attr)).cast<std::string>() + " (" +
+				pybind11::str(code.attr("co_filename")).cast<std::string>() + ":" +
+				std::to_string(code.attr("co_firstlineno").cast<long>()) + ")";
+	} catch(...) {
+		PyErr_Clear();
+	}
+	const void* key = code.ptr();
+	_keep_alive.push_back(std::move(code));
+	return intern(key, std::move(label));
+}
+
+inline uint32_t FrameProfiler::builtinLabel(PyObject* callable) {
+	// Bound builtins are created per call; their PyMethodDef is the stable identity
+	const bool is_function = PyCFunction_Check(callable);
+	const void* key = is_function
+						  ? static_cast<const void*>(
+								reinterpret_cast<PyCFunctionObject*>(callable)->m_ml)
+						  : static_cast<const void*>(Py_TYPE(callable));
+	if(auto it = _label_ids.find(key); it != _label_ids.end()) return it->second;
+
+	std::string label = Py_TYPE(callable)->tp_name;
+	if(is_function) {
+		try {
+			pybind11::handle function(callable);
+			label = pybind11::str(function.attr("__qualname__")).cast<std::string>();
+			pybind11::object module = pybind11::getattr(function, "__module__", pybind11::none());
+			if(pybind11::isinstance<pybind11::str>(module)) {
+				label = module.cast<std::string>() + "." + label;
+			}
+		} catch(...) {
+			PyErr_Clear();
+		}
+	} else {
+		_keep_alive.push_back(pybind11::reinterpret_borrow<pybind11::object>(
+			reinterpret_cast<PyObject*>(Py_TYPE(callable))));
+	}
+	return intern(key, "<built-in> " + label);
+}
+
+inline std::string FrameProfiler::folded() const {
+	std::string out;
+	std::vector<uint32_t> path;
+	for(size_t i = 1; i < _nodes.size(); i++) {
+		if(_nodes[i].self_ns == 0) continue;
+		path.clear();
+		for(uint32_t node = static_cast<uint32_t>(i); node != 0; node = _nodes[node].parent) {
+			path.push_back(_nodes[node].label);
+		}
+		out += _labels[0];
+		for(auto it = path.rbegin(); it != path.rend(); ++it) {
+			out += ';';
+			out += _labels[*it];
+		}
+		out += ' ';
+		out += std::to_string(_nodes[i].self_ns);
+		out += '\n';
+	}
+	return out;
+}
+
+} // namespace pyscheduler
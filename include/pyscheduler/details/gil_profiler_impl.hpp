@@ -0,0 +1,73 @@
+#ifdef __INTELLISENSE__
+#	include "pyscheduler/gil_profiler.hpp"
+#endif
+
+#include <algorithm>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace pyscheduler {
+
+inline void GilCounters::record(uint64_t wait_ns, uint64_t scope_ns, uint64_t scope_cpu_ns) {
+	_acquisitions.fetch_add(1, std::memory_order_relaxed);
+	_scope_ns.fetch_add(scope_ns, std::memory_order_relaxed);
+	_scope_cpu_ns.fetch_add(scope_cpu_ns, std::memory_order_relaxed);
+	_wait_ns.record(wait_ns);
+}
+
+inline GilStats GilCounters::snapshot() const {
+	GilStats stats;
+	stats.acquisitions = _acquisitions.load(std::memory_order_relaxed);
+	stats.scope_ns = _scope_ns.load(std::memory_order_relaxed);
+	stats.scope_cpu_ns = _scope_cpu_ns.load(std::memory_order_relaxed);
+	stats.wait_ns = _wait_ns.snapshot();
+	return stats;
+}
+
+inline void GilProfiler::set_enabled(bool enabled) {
+	_state.enabled.store(enabled, std::memory_order_relaxed);
+}
+
+inline uint64_t GilProfiler::thread_cpu_ns() {
+	timespec ts{ };
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+inline GilProfiler::ThreadCounters& GilProfiler::localCounters() {
+	thread_local std::shared_ptr<ThreadCounters> counters = [] {
+		auto created = std::make_shared<ThreadCounters>();
+		created->tid = static_cast<uint32_t>(::syscall(SYS_gettid));
+		std::lock_guard<std::mutex> lock(_state.threads_mutex);
+		auto& threads = _state.threads;
+		// Only the registry still references the counters of a thread that has exited.
+		threads.erase(std::remove_if(threads.begin(),
+									 threads.end(),
+									 [](const auto& entry) { return entry.use_count() == 1; }),
+					  threads.end());
+		threads.push_back(created);
+		return created;
+	}();
+	return *counters;
+}
+
+inline void GilProfiler::record(GilCounters* handler,
+								uint64_t wait_ns,
+								uint64_t scope_ns,
+								uint64_t scope_cpu_ns) {
+	localCounters().counters.record(wait_ns, scope_ns, scope_cpu_ns);
+	if(handler != nullptr) handler->record(wait_ns, scope_ns, scope_cpu_ns);
+}
+
+inline std::vector<ThreadGilStats> GilProfiler::thread_stats() {
+	std::vector<ThreadGilStats> stats;
+	std::lock_guard<std::mutex> lock(_state.threads_mutex);
+	for(const auto& entry : _state.threads) {
+		if(entry.use_count() == 1) continue;
+		stats.push_back(ThreadGilStats{ entry->tid, entry->counters.snapshot() });
+	}
+	return stats;
+}
+
+} // namespace pyscheduler
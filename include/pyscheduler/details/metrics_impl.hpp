@@ -0,0 +1,283 @@
+#ifdef __INTELLISENSE__
+#	include "pyscheduler/metrics.hpp"
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string_view>
+
+namespace pyscheduler {
+
+inline uint64_t HistogramSnapshot::percentile(double q) const {
+	if(count == 0) return 0;
+	q = std::clamp(q, 0.0, 1.0);
+	const uint64_t rank =
+		std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(count))));
+	uint64_t seen = 0;
+	for(size_t i = 0; i < buckets.size(); i++) {
+		seen += buckets[i];
+		if(seen >= rank) return std::min(LatencyHistogram::bucket_upper_bound(i), max);
+	}
+	return max;
+}
+
+inline double HistogramSnapshot::mean() const {
+	return count == 0 ? 0.0 : static_cast<double>(sum) / static_cast<double>(count);
+}
+
+inline double GilStats::scope_cpu_ratio() const {
+	return scope_ns == 0 ? 0.0 : static_cast<double>(scope_cpu_ns) / static_cast<double>(scope_ns);
+}
+
+inline size_t LatencyHistogram::bucket_index(uint64_t value) {
+	if(value < kSubBuckets) return static_cast<size_t>(value);
+	// value >= kSubBuckets here, so it is non-zero
+	const unsigned exponent =
+		63u - static_cast<unsigned>(__builtin_clzll(static_cast<unsigned long long>(value)));
+	const unsigned shift = exponent - kSubBucketBits;
+	const size_t sub = static_cast<size_t>(value >> shift) - kSubBuckets;
+	return (exponent - kSubBucketBits + 1) * kSubBuckets + sub;
+}
+
+inline uint64_t LatencyHistogram::bucket_lower_bound(size_t index) {
+	if(index < kSubBuckets) return index;
+	const unsigned shift = static_cast<unsigned>(index / kSubBuckets) - 1;
+	return static_cast<uint64_t>(kSubBuckets + index % kSubBuckets) << shift;
+}
+
+inline uint64_t LatencyHistogram::bucket_upper_bound(size_t index) {
+	if(index < kSubBuckets) return index;
+	const unsigned shift = static_cast<unsigned>(index / kSubBuckets) - 1;
+	return bucket_lower_bound(index) + ((uint64_t{ 1 } << shift) - 1);
+}
+
+inline void LatencyHistogram::record(uint64_t value) {
+	_buckets[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+	_count.fetch_add(1, std::memory_order_relaxed);
+	_sum.fetch_add(value, std::memory_order_relaxed);
+	uint64_t current = _max.load(std::memory_order_relaxed);
+	while(value > current &&
+		  !_max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+	}
+}
+
+inline HistogramSnapshot LatencyHistogram::snapshot() const {
+	HistogramSnapshot out;
+	out.buckets.resize(kBucketCount);
+	// Count is derived from the copied buckets so percentiles stay self-consistent while
+	// other threads keep recording.
+	for(size_t i = 0; i < kBucketCount; i++) {
+		out.buckets[i] = _buckets[i].load(std::memory_order_relaxed);
+		out.count += out.buckets[i];
+	}
+	out.sum = _sum.load(std::memory_order_relaxed);
+	out.max = _max.load(std::memory_order_relaxed);
+	return out;
+}
+
+namespace details {
+inline void appendLabelValue(std::string& out, std::string_view value) {
+	for(char c : value) {
+		switch(c) {
+		case '\\': out += "\\\\"; break;
+		case '"': out += "\\\""; break;
+		case '\n': out += "\\n"; break;
+		default: out += c;
+		}
+	}
+}
+
+inline std::string handlerLabels(const HandlerMetricsSnapshot& handler) {
+	std::string labels = "handler=\"";
+	appendLabelValue(labels, handler.handler);
+	labels += "\",id=\"" + std::to_string(handler.id) + "\"";
+	return labels;
+}
+
+inline void appendNumber(std::string& out, double value) {
+	char buffer[32];
+	std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+	out += buffer;
+}
+
+/// @tparam Getter Callable: (const HandlerMetricsSnapshot&) -> const HistogramSnapshot&
+template <typename Getter>
+inline void appendSummary(std::string& out,
+						  const char* name,
+						  const char* unit,
+						  const char* help,
+						  double scale,
+						  const MetricsSnapshot& snapshot,
+						  Getter&& get) {
+	constexpr double kQuantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+	out += "# TYPE " + std::string(name) + " summary\n";
+	if(unit != nullptr) out += "# UNIT " + std::string(name) + " " + unit + "\n";
+	out += "# HELP " + std::string(name) + " " + help + "\n";
+	for(const HandlerMetricsSnapshot& handler : snapshot.handlers) {
+		const HistogramSnapshot& histogram = get(handler);
+		const std::string labels = handlerLabels(handler);
+		for(double q : kQuantiles) {
+			out += std::string(name) + "{" + labels + ",quantile=\"";
+			appendNumber(out, q);
+			out += "\"} ";
+			appendNumber(out, static_cast<double>(histogram.percentile(q)) * scale);
+			out += "\n";
+		}
+		out += std::string(name) + "_sum{" + labels + "} ";
+		appendNumber(out, static_cast<double>(histogram.sum) * scale);
+		out += "\n" + std::string(name) + "_count{" + labels + "} " +
+			   std::to_string(histogram.count) + "\n";
+	}
+}
+
+inline void appendSummary(std::string& out,
+						  const char* name,
+						  const char* unit,
+						  const char* help,
+						  double scale,
+						  const MetricsSnapshot& snapshot,
+						  HistogramSnapshot HandlerMetricsSnapshot::*member) {
+	appendSummary(out,
+				  name,
+				  unit,
+				  help,
+				  scale,
+				  snapshot,
+				  [member](const HandlerMetricsSnapshot& handler) -> const HistogramSnapshot& {
+					  return handler.*member;
+				  });
+}
+
+template <typename Getter>
+inline void appendScalar(std::string& out,
+						 const char* name,
+						 const char* type,
+						 const char* help,
+						 const MetricsSnapshot& snapshot,
+						 Getter&& get) {
+	// OpenMetrics counter samples carry a _total suffix that the family name omits.
+	const std::string sample =
+		std::string(name) + (std::string_view(type) == "counter" ? "_total" : "");
+	out += "# TYPE " + std::string(name) + " " + type + "\n";
+	out += "# HELP " + std::string(name) + " " + help + "\n";
+	for(const HandlerMetricsSnapshot& handler : snapshot.handlers) {
+		out += sample + "{" + handlerLabels(handler) + "} ";
+		appendNumber(out, static_cast<double>(get(handler)));
+		out += "\n";
+	}
+}
+} // namespace details
+
+inline std::string renderOpenMetrics(const MetricsSnapshot& snapshot) {
+	constexpr double kNsToSeconds = 1e-9;
+	std::string out;
+
+	details::appendScalar(out,
+						 "pyscheduler_enqueued",
+						 "counter",
+						 "Items enqueued with queue_invoke.",
+						 snapshot,
+						 [](const HandlerMetricsSnapshot& h) { return h.total_enqueued; });
+	details::appendScalar(out,
+						 "pyscheduler_commit_queue_size",
+						 "gauge",
+						 "Items waiting to be committed.",
+						 snapshot,
+						 [](const HandlerMetricsSnapshot& h) { return h.commit_queue_size; });
+	details::appendScalar(out,
+						 "pyscheduler_execute_queue_size",
+						 "gauge",
+						 "Committed items waiting to be executed.",
+						 snapshot,
+						 [](const HandlerMetricsSnapshot& h) { return h.execute_queue_size; });
+	details::appendScalar(out,
+						 "pyscheduler_oldest_item_age_seconds",
+						 "gauge",
+						 "Age of the oldest item not yet handed to Python.",
+						 snapshot,
+						 [](const HandlerMetricsSnapshot& h) {
+							 return static_cast<double>(h.oldest_item_age_ns) * kNsToSeconds;
+						 });
+
+	details::appendSummary(out,
+						   "pyscheduler_queue_wait_seconds",
+						   "seconds",
+						   "Time from queue_invoke until commit starts.",
+						   kNsToSeconds,
+						   snapshot,
+						   &HandlerMetricsSnapshot::queue_wait_ns);
+	details::appendSummary(out,
+						   "pyscheduler_commit_seconds",
+						   "seconds",
+						   "Duration of each commit function.",
+						   kNsToSeconds,
+						   snapshot,
+						   &HandlerMetricsSnapshot::commit_ns);
+	details::appendSummary(out,
+						   "pyscheduler_hold_seconds",
+						   "seconds",
+						   "Time from commit until the batch starts executing.",
+						   kNsToSeconds,
+						   snapshot,
+						   &HandlerMetricsSnapshot::hold_ns);
+	details::appendSummary(out,
+						   "pyscheduler_execute_batch_seconds",
+						   "seconds",
+						   "Duration of each batched Python call.",
+						   kNsToSeconds,
+						   snapshot,
+						   &HandlerMetricsSnapshot::execute_batch_ns);
+	details::appendSummary(out,
+						   "pyscheduler_execute_item_seconds",
+						   "seconds",
+						   "Batch execute time per item.",
+						   kNsToSeconds,
+						   snapshot,
+						   &HandlerMetricsSnapshot::execute_item_ns);
+	details::appendSummary(out,
+						   "pyscheduler_fanout_seconds",
+						   "seconds",
+						   "Time spent dispatching a batch's results to callbacks.",
+						   kNsToSeconds,
+						   snapshot,
+						   &HandlerMetricsSnapshot::fanout_ns);
+	details::appendSummary(out,
+						   "pyscheduler_batch_size",
+						   nullptr,
+						   "Items per executed batch.",
+						   1.0,
+						   snapshot,
+						   &HandlerMetricsSnapshot::batch_size);
+
+	details::appendSummary(out,
+						   "pyscheduler_gil_wait_seconds",
+						   "seconds",
+						   "Time spent waiting to acquire the GIL.",
+						   kNsToSeconds,
+						   snapshot,
+						   [](const HandlerMetricsSnapshot& h) -> const HistogramSnapshot& {
+							   return h.gil.wait_ns;
+						   });
+	details::appendScalar(out,
+						  "pyscheduler_gil_scope_seconds",
+						  "counter",
+						  "Wall time of GIL scopes, including Python code that released the GIL.",
+						  snapshot,
+						  [](const HandlerMetricsSnapshot& h) {
+							  return static_cast<double>(h.gil.scope_ns) * kNsToSeconds;
+						  });
+	details::appendScalar(out,
+						  "pyscheduler_gil_scope_cpu_seconds",
+						  "counter",
+						  "Thread CPU time spent inside GIL scopes.",
+						  snapshot,
+						  [](const HandlerMetricsSnapshot& h) {
+							  return static_cast<double>(h.gil.scope_cpu_ns) * kNsToSeconds;
+						  });
+
+	out += "# EOF\n";
+	return out;
+}
+
+} // namespace pyscheduler
@@ -0,0 +1,190 @@
+#ifdef __INTELLISENSE__
+#	include "pyscheduler/output_buffer.hpp"
+#endif
+
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace pyscheduler {
+
+inline CompletionGroup::CompletionGroup()
+	: _state(std::make_shared<State>()) {}
+
+inline void CompletionGroup::wait() {
+	std::unique_lock<std::mutex> lock(_state->mutex);
+	_state->idle.wait(lock, [this] { return _state->pending == 0; });
+	rethrowError(lock);
+}
+
+template <typename Rep, typename Period>
+bool CompletionGroup::wait_for(std::chrono::duration<Rep, Period> timeout) {
+	std::unique_lock<std::mutex> lock(_state->mutex);
+	if(!_state->idle.wait_for(lock, timeout, [this] { return _state->pending == 0; })) {
+		return false;
+	}
+	rethrowError(lock);
+	return true;
+}
+
+inline size_t CompletionGroup::pending() const {
+	std::lock_guard<std::mutex> lock(_state->mutex);
+	return _state->pending;
+}
+
+inline void CompletionGroup::add() {
+	std::lock_guard<std::mutex> lock(_state->mutex);
+	_state->pending++;
+}
+
+inline void CompletionGroup::done(std::exception_ptr error) {
+	std::lock_guard<std::mutex> lock(_state->mutex);
+	if(error && !_state->error) _state->error = std::move(error);
+	if(--_state->pending == 0) _state->idle.notify_all();
+}
+
+inline void CompletionGroup::rethrowError(std::unique_lock<std::mutex>& lock) {
+	std::exception_ptr error = std::exchange(_state->error, nullptr);
+	lock.unlock();
+	if(error) std::rethrow_exception(error);
+}
+
+namespace details {
+
+inline void checkElementCount(size_t actual, size_t expected) {
+	if(actual != expected) {
+		throw std::invalid_argument("Result has " + std::to_string(actual) +
+									" elements, destination holds " + std::to_string(expected));
+	}
+}
+
+/// @brief Kind of a single-item struct-module format: 'i' signed, 'u' unsigned, 'f'
+/// floating point, '?' bool, or 0 if unsupported. Only native byte order is accepted.
+inline char formatKind(std::string_view format) {
+	constexpr char kNativeOrder = std::endian::native == std::endian::little ? '<' : '>';
+	if(!format.empty() &&
+	   (format.front() == '@' || format.front() == '=' || format.front() == kNativeOrder)) {
+		format.remove_prefix(1);
+	}
+	if(format.size() != 1) return 0;
+	switch(format.front()) {
+	case 'b':
+	case 'h':
+	case 'i':
+	case 'l':
+	case 'q':
+	case 'n':
+		return 'i';
+	case 'B':
+	case 'H':
+	case 'I':
+	case 'L':
+	case 'Q':
+	case 'N':
+		return 'u';
+	case 'e':
+	case 'f':
+	case 'd':
+		return 'f';
+	case '?':
+		return '?';
+	default:
+		return 0;
+	}
+}
+
+/// @throws std::invalid_argument if a buffer of format cannot be copied bitwise into T.
+/// Widths are checked separately; single-byte integers accept either signedness.
+template <typename T>
+void checkFormat(const char* format) {
+	if constexpr(std::is_arithmetic_v<T>) {
+		// A null format means unsigned bytes
+		const std::string_view actual = format != nullptr ? format : "B";
+		const char expected = formatKind(pybind11::format_descriptor<T>::format());
+		const char kind = formatKind(actual);
+		const bool bytes = sizeof(T) == 1 && expected != '?' && (kind == 'i' || kind == 'u');
+		if(kind != expected && !bytes) {
+			throw std::invalid_argument("Result format '" + std::string(actual) +
+										"' does not match the destination's '" +
+										pybind11::format_descriptor<T>::format() + "'");
+		}
+	}
+}
+
+} // namespace details
+
+template <typename T>
+void copyResultInto(pybind11::handle result, std::span<T> destination) {
+	PyObject* obj = result.ptr();
+
+	if(PyObject_CheckBuffer(obj)) {
+		Py_buffer view;
+		if(PyObject_GetBuffer(obj, &view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) != 0) {
+			throw pybind11::error_already_set();
+		}
+		struct Release {
+			Py_buffer* view;
+			~Release() { PyBuffer_Release(view); }
+		} release{ &view };
+		if(static_cast<size_t>(view.itemsize) != sizeof(T)) {
+			throw std::invalid_argument("Result items are " + std::to_string(view.itemsize) +
+										" bytes wide, destination items " +
+										std::to_string(sizeof(T)));
+		}
+		details::checkFormat<T>(view.format);
+		details::checkElementCount(static_cast<size_t>(view.len) / sizeof(T),
+								   destination.size());
+		std::memcpy(destination.data(), view.buf, destination.size_bytes());
+		return;
+	}
+
+	if constexpr(requires { DLPackTypeTraits<T>::dtype; }) {
+		if(PyObject_HasAttrString(obj, "__dlpack__")) {
+			// The capsule stays unconsumed, so its destructor frees the producer's tensor
+			pybind11::object capsule = result.attr("__dlpack__")();
+			auto* managed = static_cast<DLManagedTensor*>(
+				PyCapsule_GetPointer(capsule.ptr(), "dltensor"));
+			if(managed == nullptr) throw pybind11::error_already_set();
+			const DLTensor& tensor = managed->dl_tensor;
+			constexpr DLDataType dtype = DLPackTypeTraits<T>::dtype;
+			if(tensor.device.device_type != kDLCPU && tensor.device.device_type != kDLCUDAHost) {
+				throw std::invalid_argument("DLPack result is not in host memory");
+			}
+			if(tensor.dtype.code != dtype.code || tensor.dtype.bits != dtype.bits ||
+			   tensor.dtype.lanes != dtype.lanes) {
+				throw std::invalid_argument("DLPack result dtype does not match the destination");
+			}
+			size_t count = 1;
+			int64_t expected_stride = 1;
+			for(int32_t dim = tensor.ndim - 1; dim >= 0; dim--) {
+				if(tensor.strides != nullptr && tensor.shape[dim] > 1 &&
+				   tensor.strides[dim] != expected_stride) {
+					throw std::invalid_argument("DLPack result is not C-contiguous");
+				}
+				expected_stride *= tensor.shape[dim];
+				count *= static_cast<size_t>(tensor.shape[dim]);
+			}
+			details::checkElementCount(count, destination.size());
+			std::memcpy(destination.data(),
+						static_cast<const char*>(tensor.data) + tensor.byte_offset,
+						destination.size_bytes());
+			return;
+		}
+	}
+
+	pybind11::object items =
+		pybind11::reinterpret_steal<pybind11::object>(PySequence_Fast(obj, "Unsupported result"));
+	if(!items) throw pybind11::error_already_set();
+	const auto count = static_cast<size_t>(PySequence_Fast_GET_SIZE(items.ptr()));
+	details::checkElementCount(count, destination.size());
+	PyObject** values = PySequence_Fast_ITEMS(items.ptr());
+	for(size_t i = 0; i < count; i++) {
+		destination[i] = pybind11::handle(values[i]).cast<T>();
+	}
+}
+
+} // namespace pyscheduler
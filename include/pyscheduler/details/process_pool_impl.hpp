@@ -0,0 +1,365 @@
+#ifdef __INTELLISENSE__
+#	include "pyscheduler/process_pool.hpp"
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <poll.h>
+#include <spawn.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace pyscheduler {
+
+namespace details {
+/// @brief Worker process body, run with `python -c`. Mirrors the ShmRing record layout.
+inline constexpr const char* kProcessWorkerBootstrap = R"PY(
+import importlib, mmap, os, pickle, struct, sys, time
+
+HEAD, TAIL, CAPACITY, DATA, RECORD = 0, 64, 128, 192, 16
+OK, ERROR, READY = 0, 1, 2
+
+
+class Ring:
+    def __init__(self, fd):
+        self.mm = mmap.mmap(fd, os.fstat(fd).st_size)
+        self.cap = struct.unpack_from("=Q", self.mm, CAPACITY)[0]
+
+    def _cursor(self, offset):
+        return struct.unpack_from("=Q", self.mm, offset)[0]
+
+    def _read(self, pos, n):
+        start = pos % self.cap
+        first = min(n, self.cap - start)
+        out = self.mm[DATA + start:DATA + start + first]
+        return out + self.mm[DATA:DATA + n - first] if first < n else out
+
+    def _write(self, pos, data):
+        start = pos % self.cap
+        first = min(len(data), self.cap - start)
+        self.mm[DATA + start:DATA + start + first] = data[:first]
+        if first < len(data):
+            self.mm[DATA:DATA + len(data) - first] = data[first:]
+
+    def pop(self):
+        tail = self._cursor(TAIL)
+        if self._cursor(HEAD) == tail:
+            return None
+        tag, status, length = struct.unpack("=QII", self._read(tail, RECORD))
+        payload = self._read(tail + RECORD, length)
+        struct.pack_into("=Q", self.mm, TAIL, tail + ((RECORD + length + 7) & ~7))
+        return tag, status, payload
+
+    def push(self, tag, status, payload):
+        if RECORD + len(payload) > self.cap:
+            status, payload = ERROR, b"result exceeds worker_ring_bytes"
+        need = (RECORD + len(payload) + 7) & ~7
+        head = self._cursor(HEAD)
+        while self.cap - (head - self._cursor(TAIL)) < need:
+            time.sleep(0.0002)
+        self._write(head, struct.pack("=QII", tag, status, len(payload)))
+        self._write(head + RECORD, payload)
+        struct.pack_into("=Q", self.mm, HEAD, head + need)
+
+
+def main(module_name, entry_point, request_fd, response_fd, bell_fd, version, path=""):
+    for entry in path.split("\n"):
+        if entry and entry not in sys.path:
+            sys.path.append(entry)
+    requests, responses, bell = Ring(int(request_fd)), Ring(int(response_fd)), int(bell_fd)
+
+    running = "%d.%d" % sys.version_info[:2]
+    if version and version != running:
+        message = f"{sys.executable} runs Python {running}, the host embeds Python {version}"
+        responses.push(0, ERROR, message.encode())
+        os.write(bell, b"\x01")
+        return
+
+    try:
+        fn = getattr(importlib.import_module(module_name), entry_point)
+    except BaseException as e:
+        responses.push(0, ERROR, f"{type(e).__name__}: {e}".encode())
+        os.write(bell, b"\x01")
+        return
+    responses.push(0, READY, b"")
+    os.write(bell, b"\x01")
+
+    while True:
+        record = requests.pop()
+        if record is None:
+            if not os.read(bell, 4096):
+                return
+            continue
+        tag, _, payload = record
+        try:
+            out = pickle.dumps(list(fn(pickle.loads(payload))), pickle.HIGHEST_PROTOCOL)
+            status = OK
+        except BaseException as e:
+            out, status = f"{type(e).__name__}: {e}".encode(), ERROR
+        responses.push(tag, status, out)
+        os.write(bell, b"\x01")
+
+
+main(*sys.argv[1:])
+)PY";
+} // namespace details
+
+inline ProcessPool::ProcessPool(const Options& options)
+	: _shutdown_grace(options.shutdown_grace) {
+	if(options.processes == 0) {
+		throw std::invalid_argument("ProcessPool needs at least one worker process");
+	}
+	if(options.python_executable.empty()) {
+		throw std::invalid_argument("ProcessPool needs a python_executable");
+	}
+
+	_workers.reserve(options.processes);
+	try {
+		for(size_t i = 0; i < options.processes; i++) {
+			_workers.push_back(Worker{ -1,
+									   ShmRing(options.ring_bytes),
+									   ShmRing(options.ring_bytes),
+									   -1,
+									   { },
+									   true });
+			spawn(_workers.back(), options);
+		}
+
+		auto deadline = std::chrono::steady_clock::now() + options.startup_timeout;
+		for(Worker& worker : _workers) {
+			await_ready(worker, deadline);
+		}
+	} catch(...) {
+		// A worker stuck in its import would otherwise outlast startup_timeout
+		shutdown(std::chrono::milliseconds(0));
+		throw;
+	}
+}
+
+inline ProcessPool::~ProcessPool() {
+	shutdown(_shutdown_grace);
+}
+
+inline void ProcessPool::spawn(Worker& worker, const Options& options) {
+	int bell[2];
+	if(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, bell) != 0) {
+		throw std::system_error(errno, std::generic_category(), "socketpair failed");
+	}
+	worker.bell = bell[0];
+
+	std::string path;
+	for(const std::string& entry : options.sys_path) {
+		path += entry;
+		path += '\n';
+	}
+	std::string request_fd = std::to_string(worker.requests.fd());
+	std::string response_fd = std::to_string(worker.responses.fd());
+	std::string bell_fd = std::to_string(bell[1]);
+
+	std::vector<char*> argv = { const_cast<char*>(options.python_executable.c_str()),
+								const_cast<char*>("-c"),
+								const_cast<char*>(details::kProcessWorkerBootstrap),
+								const_cast<char*>(options.module_name.c_str()),
+								const_cast<char*>(options.entry_point.c_str()),
+								request_fd.data(),
+								response_fd.data(),
+								bell_fd.data(),
+								const_cast<char*>(options.python_version.c_str()),
+								path.data(),
+								nullptr };
+
+	// dup2 onto the same descriptor clears FD_CLOEXEC in the child only, so the rings and
+	// doorbell are inherited by the worker but not by unrelated children of the host.
+	posix_spawn_file_actions_t actions;
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_adddup2(&actions, worker.requests.fd(), worker.requests.fd());
+	posix_spawn_file_actions_adddup2(&actions, worker.responses.fd(), worker.responses.fd());
+	posix_spawn_file_actions_adddup2(&actions, bell[1], bell[1]);
+
+	pid_t pid = -1;
+	int err = posix_spawnp(
+		&pid, options.python_executable.c_str(), &actions, nullptr, argv.data(), environ);
+	posix_spawn_file_actions_destroy(&actions);
+	close(bell[1]);
+	if(err != 0) {
+		throw std::system_error(err,
+								std::generic_category(),
+								"Could not spawn worker '" + options.python_executable + "'");
+	}
+	worker.pid = pid;
+}
+
+inline void ProcessPool::await_ready(Worker& worker,
+									 std::chrono::steady_clock::time_point deadline) {
+	uint64_t tag = 0;
+	uint32_t status = 0;
+	bool closed = false;
+	while(!worker.responses.try_pop(tag, status, _scratch)) {
+		if(closed) {
+			worker.alive = false;
+			throw std::runtime_error("Worker process exited during startup");
+		}
+		auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+			deadline - std::chrono::steady_clock::now());
+		if(remaining.count() <= 0) {
+			throw std::runtime_error("Timed out waiting for worker process to start");
+		}
+		pollfd fd{ worker.bell, POLLIN, 0 };
+		(void)::poll(&fd, 1, static_cast<int>(remaining.count()));
+		closed = drain_bell(worker.bell);
+	}
+	if(status == kError) {
+		throw std::invalid_argument("Worker process could not load entry point: " + _scratch);
+	}
+}
+
+inline bool ProcessPool::has_capacity() const {
+	return std::any_of(_workers.begin(), _workers.end(), [](const Worker& worker) {
+		return worker.alive && worker.inflight.size() < kMaxInflightPerWorker;
+	});
+}
+
+inline bool ProcessPool::fits(size_t payload_bytes) const {
+	return !_workers.empty() &&
+		   ShmRing::record_size(payload_bytes) <= _workers.front().requests.capacity();
+}
+
+inline bool ProcessPool::try_submit(uint64_t batch_id, const void* data, size_t size) {
+	Worker* target = nullptr;
+	const size_t needed = ShmRing::record_size(size);
+	for(Worker& worker : _workers) {
+		if(!worker.alive || worker.inflight.size() >= kMaxInflightPerWorker) continue;
+		if(worker.requests.free_bytes() < needed) continue;
+		if(target == nullptr || worker.inflight.size() < target->inflight.size()) {
+			target = &worker;
+		}
+	}
+	if(target == nullptr) return false;
+
+	if(!target->requests.try_push(batch_id, kOk, data, size)) return false;
+	target->inflight.push_back(batch_id);
+	const char byte = 1;
+	(void)::send(target->bell, &byte, 1, MSG_NOSIGNAL | MSG_DONTWAIT);
+	return true;
+}
+
+template <typename OnComplete>
+size_t ProcessPool::poll(OnComplete&& on_complete) {
+	size_t completed = 0;
+	uint64_t tag = 0;
+	uint32_t status = 0;
+	for(Worker& worker : _workers) {
+		if(!worker.alive) continue;
+
+		const bool closed = drain_bell(worker.bell);
+		while(worker.responses.try_pop(tag, status, _scratch)) {
+			auto it = std::find(worker.inflight.begin(), worker.inflight.end(), tag);
+			if(it == worker.inflight.end()) continue;
+			worker.inflight.erase(it);
+			on_complete(tag, static_cast<Status>(status), std::string_view(_scratch));
+			completed++;
+		}
+
+		if(closed) {
+			worker.alive = false;
+			for(uint64_t lost : worker.inflight) {
+				on_complete(lost, kWorkerLost, std::string_view("worker process exited"));
+				completed++;
+			}
+			worker.inflight.clear();
+			if(waitpid(worker.pid, nullptr, WNOHANG) == worker.pid) worker.pid = -1;
+		}
+	}
+	return completed;
+}
+
+inline void ProcessPool::wait(std::chrono::milliseconds timeout) const {
+	std::vector<pollfd> fds;
+	fds.reserve(_workers.size());
+	for(const Worker& worker : _workers) {
+		if(worker.alive) fds.push_back(pollfd{ worker.bell, POLLIN, 0 });
+	}
+	if(fds.empty()) return;
+	(void)::poll(fds.data(), fds.size(), static_cast<int>(timeout.count()));
+}
+
+inline size_t ProcessPool::inflight() const {
+	size_t total = 0;
+	for(const Worker& worker : _workers) total += worker.inflight.size();
+	return total;
+}
+
+inline size_t ProcessPool::live_workers() const {
+	return static_cast<size_t>(std::count_if(
+		_workers.begin(), _workers.end(), [](const Worker& worker) { return worker.alive; }));
+}
+
+inline bool ProcessPool::drain_bell(int bell) {
+	char buffer[256];
+	while(true) {
+		ssize_t n = ::recv(bell, buffer, sizeof(buffer), MSG_DONTWAIT);
+		if(n > 0) continue;
+		if(n == 0) return true;
+		if(errno == EINTR) continue;
+		return errno != EAGAIN && errno != EWOULDBLOCK;
+	}
+}
+
+inline void ProcessPool::shutdown(std::chrono::milliseconds grace) {
+	// Half-closing the doorbell makes each worker's blocking read return EOF once its request
+	// ring is drained, after which it exits on its own.
+	for(Worker& worker : _workers) {
+		if(worker.bell >= 0) ::shutdown(worker.bell, SHUT_WR);
+		worker.alive = false;
+	}
+
+	// Reaps exited workers until none is left or deadline passes; true once all are reaped
+	auto reap = [this](std::chrono::steady_clock::time_point deadline) {
+		while(true) {
+			bool running = false;
+			for(Worker& worker : _workers) {
+				if(worker.pid <= 0) continue;
+				const pid_t reaped = waitpid(worker.pid, nullptr, WNOHANG);
+				if(reaped == worker.pid || (reaped < 0 && errno == ECHILD)) {
+					worker.pid = -1;
+				} else {
+					running = true;
+				}
+			}
+			if(!running) return true;
+			if(std::chrono::steady_clock::now() >= deadline) return false;
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	};
+	auto signal = [this](int sig) {
+		for(const Worker& worker : _workers) {
+			if(worker.pid > 0) (void)::kill(worker.pid, sig);
+		}
+	};
+
+	// A worker can hang in the entry point, or in push when nobody drains its responses
+	constexpr auto kTerminateGrace = std::chrono::milliseconds(1000);
+	if(grace.count() > 0 && !reap(std::chrono::steady_clock::now() + grace)) {
+		signal(SIGTERM);
+		(void)reap(std::chrono::steady_clock::now() + kTerminateGrace);
+	}
+	signal(SIGKILL);
+	(void)reap(std::chrono::steady_clock::time_point::max());
+
+	for(Worker& worker : _workers) {
+		if(worker.bell >= 0) {
+			close(worker.bell);
+			worker.bell = -1;
+		}
+	}
+}
+
+} // namespace pyscheduler
@@ -2,7 +2,9 @@
 #	include "pyscheduler/pyscheduler.hpp"
 #endif
 
+#include "pyscheduler/bytes_view.hpp"
 #include "pyscheduler/move_only.hpp"
+#include <algorithm>
 #include <chrono>
 #include <cstdlib>
 #include <deque>
@@ -10,9 +12,72 @@
 #include <stdexcept>
 #include <string_view>
 #include <thread>
+#include <tuple>
 
 namespace pyscheduler {
 
+namespace details {
+/// @brief steady_clock time point as nanoseconds since the clock's epoch.
+inline std::int64_t steadyNs(std::chrono::steady_clock::time_point time) {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+/// @brief Nanoseconds from start to end, clamped at zero.
+inline uint64_t elapsedNs(std::chrono::steady_clock::time_point start,
+						  std::chrono::steady_clock::time_point end) {
+	if(end <= start) return 0;
+	return static_cast<uint64_t>(
+		std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+}
+
+/// @brief Result slot of a synchronous invoke routed through the worker. Lives on the
+/// caller's stack: the worker signals under the lock, so the caller cannot return and
+/// destroy it while the worker still touches it.
+template <typename T>
+class SyncWaiter {
+public:
+	template <typename... Value>
+	void set_value(Value&&... value) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		if constexpr(!std::is_void_v<T>) _value.emplace(std::forward<Value>(value)...);
+		_done = true;
+		_cv.notify_one();
+	}
+
+	void set_error(std::exception_ptr error) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		_error = std::move(error);
+		_done = true;
+		_cv.notify_one();
+	}
+
+	T get() {
+		std::unique_lock<std::mutex> lock(_mutex);
+		_cv.wait(lock, [this] { return _done; });
+		if(_error) std::rethrow_exception(_error);
+		if constexpr(!std::is_void_v<T>) return std::move(*_value);
+	}
+
+private:
+	std::mutex _mutex;
+	std::condition_variable _cv;
+	bool _done = false;
+	std::exception_ptr _error;
+	std::optional<std::conditional_t<std::is_void_v<T>, char, T>> _value;
+};
+
+/// @brief The batch item for a synchronous invoke's arguments: a single argument cast to
+/// Python, several packed into a tuple.
+template <typename... Args>
+pybind11::object packArguments(Args&&... args) {
+	if constexpr(sizeof...(Args) == 1) {
+		return pybind11::cast(std::forward<Args>(args)...);
+	} else {
+		return pybind11::make_tuple(std::forward<Args>(args)...);
+	}
+}
+} // namespace details
+
 ///////////////////////////////////////////////////////////////////////////////
 // Impl InvokeHandler
 ///////////////////////////////////////////////////////////////////////////////
@@ -20,25 +85,95 @@ namespace pyscheduler {
 PyManager::InvokeHandler::InvokeHandler(size_t /*id*/,
 										std::shared_ptr<pybind11::object> resource,
 										std::unique_ptr<PyManager> manager,
-										size_t batch_size,
-										size_t prefetch_depth)
+										const HandlerOptions& options,
+										const std::string& module_name,
+										std::optional<SubinterpreterSpec> isolation,
+										std::unique_ptr<ProcessPool> process_pool)
 	: _manager(std::move(manager))
 	, _resource(std::move(resource))
-	, _batch_size(batch_size)
-	, _prefetch_depth(prefetch_depth)
+	, _batch_size(options.batch_size)
+	, _prefetch_depth(options.prefetch_depth)
+	, _isolated(isolation.has_value())
 	, _active(std::make_shared<std::atomic<bool>>(true))
-	, _state(std::make_shared<WorkerState>())
-	, _worker(
-		  &InvokeHandler::workerLoop, _state, _resource, _batch_size, _prefetch_depth, _active) { }
+	, _state(std::make_shared<WorkerState>()) {
+	_state->affinity = options.worker_affinity;
+	if(_state->affinity.empty() && !_state->affinity.numa_local_memory) {
+		std::lock_guard<std::mutex> lock(shared().affinity_mutex);
+		_state->affinity = shared().default_worker_affinity;
+	}
+	_state->name = options.name;
+	_state->id = shared().next_handler_id.fetch_add(1, std::memory_order_relaxed);
+	_state->module_name = module_name;
+	_state->warmup_function = options.warmup_function;
+	_state->warmup_batch = options.warmup_batch;
+	_state->warmup_batch_sizes = options.warmup_batch_sizes;
+	_state->ready = _state->warmup_done.get_future().share();
+	_state->max_inflight_batches = options.max_inflight_batches;
+	_state->active = _active;
+	_state->isolated = _isolated;
+	_state->bisect_failed_batches = options.bisect_failed_batches;
+	_state->invoke_via_worker = options.invoke_via_worker;
+	_state->batch_key = options.batch_key;
+	_state->batch_key_max_wait = options.batch_key_max_wait;
+	_state->keyed.store(static_cast<bool>(options.batch_key), std::memory_order_relaxed);
+	if(_state->warmup_function.empty() && !_state->warmup_batch) {
+		_state->warmup_done.set_value(WarmupReport{ });
+	}
+	{
+		std::lock_guard<std::mutex> lock(shared().metrics_mutex);
+		auto& states = shared().handler_states;
+		states.erase(std::remove_if(states.begin(),
+									states.end(),
+									[](const auto& weak) { return weak.expired(); }),
+					 states.end());
+		states.push_back(_state);
+	}
+
+	if(process_pool) {
+		_state->process_pool = std::move(process_pool);
+		_worker = std::thread(
+			&InvokeHandler::processWorkerLoop, _state, _batch_size, _prefetch_depth, _active);
+		return;
+	}
+
+	if(!isolation) {
+		_worker = std::thread(
+			&InvokeHandler::workerLoop, _state, _resource, _batch_size, _prefetch_depth, _active);
+		return;
+	}
+
+	// The worker owns the subinterpreter, so wait for it to import the module before
+	// handing out the handler; import errors surface here like they do for shared handlers.
+	std::promise<void> ready;
+	std::future<void> ready_future = ready.get_future();
+	_worker = std::thread(&InvokeHandler::isolatedWorkerMain,
+						  _state,
+						  std::move(*isolation),
+						  _batch_size,
+						  _prefetch_depth,
+						  _active,
+						  std::move(ready));
+	try {
+		ready_future.get();
+	} catch(...) {
+		_active->store(false);
+		_worker.join();
+		throw;
+	}
+}
 
 PyManager::InvokeHandler::~InvokeHandler() {
 	if(_active) {
 		_active->store(false);
 	}
 	if(_worker.joinable()) _worker.join();
-	if(_state) {
-		pybind11::gil_scoped_acquire gil;
+	// Reaping worker processes can take the whole shutdown grace; do it without the GIL
+	if(_state) _state->process_pool.reset();
+	// A pipeline callable has no other owner, so its last reference must drop under the GIL
+	if(_state || _resource) {
+		ScopedGil gil(nullptr);
 		_state.reset();
+		_resource.reset();
 	}
 }
 
@@ -47,6 +182,7 @@ PyManager::InvokeHandler::InvokeHandler(InvokeHandler&& other) noexcept
 	, _resource(std::move(other._resource))
 	, _batch_size(other._batch_size)
 	, _prefetch_depth(other._prefetch_depth)
+	, _isolated(other._isolated)
 	, _active(std::move(other._active))
 	, _state(std::move(other._state))
 	, _worker(std::move(other._worker)) {
@@ -62,15 +198,18 @@ PyManager::InvokeHandler& PyManager::InvokeHandler::operator=(InvokeHandler&& ot
 			_active->store(false);
 		}
 		if(_worker.joinable()) _worker.join();
-		if(_state) {
-			pybind11::gil_scoped_acquire gil;
+		if(_state) _state->process_pool.reset();
+		if(_state || _resource) {
+			ScopedGil gil(nullptr);
 			_state.reset();
+			_resource.reset();
 		}
 
 		_manager = std::move(other._manager);
 		_resource = std::move(other._resource);
 		_batch_size = other._batch_size;
 		_prefetch_depth = other._prefetch_depth;
+		_isolated = other._isolated;
 		_active = std::move(other._active);
 		_state = std::move(other._state);
 		_worker = std::move(other._worker);
@@ -80,7 +219,15 @@ PyManager::InvokeHandler& PyManager::InvokeHandler::operator=(InvokeHandler&& ot
 
 template <typename ReturnType, typename... Args>
 ReturnType PyManager::InvokeHandler::invoke(Args&&... args) {
-	pybind11::gil_scoped_acquire gil;
+	if(_state->invoke_via_worker) {
+		return invokeOnWorker(
+			[](const pybind11::object& result) { return result.cast<ReturnType>(); },
+			std::forward<Args>(args)...);
+	}
+	if(_isolated) {
+		throw std::logic_error("Synchronous invoke is not supported on isolated handlers");
+	}
+	ScopedGil gil(nullptr, &_state->gil);
 	pybind11::object result = (*_resource.get())(std::forward<Args>(args)...);
 	return result.cast<ReturnType>();
 }
@@ -88,37 +235,98 @@ ReturnType PyManager::InvokeHandler::invoke(Args&&... args) {
 template <typename Callback, typename... Args>
 auto PyManager::InvokeHandler::invoke(Callback&& callback, Args&&... args)
 	-> std::invoke_result_t<Callback, pybind11::object> {
-	pybind11::gil_scoped_acquire gil;
+	if(_state->invoke_via_worker) {
+		return invokeOnWorker(std::forward<Callback>(callback), std::forward<Args>(args)...);
+	}
+	if(_isolated) {
+		throw std::logic_error("Synchronous invoke is not supported on isolated handlers");
+	}
+	ScopedGil gil(nullptr, &_state->gil);
 	pybind11::object result = (*_resource.get())(std::forward<Args>(args)...);
 	return callback(std::move(result));
 }
 
+template <typename Callback, typename... Args>
+auto PyManager::InvokeHandler::invokeOnWorker(Callback&& callback, Args&&... args)
+	-> std::invoke_result_t<Callback, pybind11::object> {
+	using ReturnType = std::invoke_result_t<Callback, pybind11::object>;
+
+	static_assert(
+		!std::is_same_v<ReturnType, pybind11::object>,
+		"ReturnType must not be pybind11::object; convert to a pure C++ type in the callback.");
+
+	// No promise: the caller blocks on a waiter on its own stack
+	details::SyncWaiter<ReturnType> waiter;
+	QueueEntry entry;
+	entry.commit = makeCommit(
+		[](auto&&... unpacked) {
+			return details::packArguments(std::forward<decltype(unpacked)>(unpacked)...);
+		},
+		std::forward<Args>(args)...);
+	entry.on_result = [cb = std::forward<Callback>(callback),
+					   &waiter](pybind11::object result) mutable {
+		try {
+			if constexpr(std::is_void_v<ReturnType>) {
+				std::invoke(cb, std::move(result));
+				waiter.set_value();
+			} else {
+				waiter.set_value(std::invoke(cb, std::move(result)));
+			}
+		} catch(...) {
+			waiter.set_error(std::current_exception());
+		}
+	};
+	entry.on_error = [&waiter](std::exception_ptr eptr) { waiter.set_error(eptr); };
+	submitTo(*_state, std::move(entry), true);
+	if(PyGILState_Check()) {
+		// The worker needs the GIL to serve the call
+		pybind11::gil_scoped_release release;
+		return waiter.get();
+	}
+	return waiter.get();
+}
+
 template <typename CommitFn, typename Callback, typename... Args>
 auto PyManager::InvokeHandler::queue_invoke(CommitFn&& commit_fn,
 											Callback&& callback,
 											Args&&... args)
 	-> std::future<std::invoke_result_t<Callback, pybind11::object>> {
+	return enqueue(std::nullopt,
+				   std::forward<CommitFn>(commit_fn),
+				   std::forward<Callback>(callback),
+				   std::forward<Args>(args)...);
+}
+
+template <typename CommitFn, typename Callback, typename... Args>
+auto PyManager::InvokeHandler::queue_invoke_keyed(uint64_t key,
+												  CommitFn&& commit_fn,
+												  Callback&& callback,
+												  Args&&... args)
+	-> std::future<std::invoke_result_t<Callback, pybind11::object>> {
+	if(!_state->keyed.load(std::memory_order_relaxed)) {
+		_state->keyed.store(true, std::memory_order_relaxed);
+	}
+	return enqueue(key,
+				   std::forward<CommitFn>(commit_fn),
+				   std::forward<Callback>(callback),
+				   std::forward<Args>(args)...);
+}
+
+template <typename CommitFn, typename Callback, typename... Args>
+auto PyManager::InvokeHandler::enqueue(std::optional<uint64_t> key,
+									   CommitFn&& commit_fn,
+									   Callback&& callback,
+									   Args&&... args)
+	-> std::future<std::invoke_result_t<Callback, pybind11::object>> {
 	using ReturnType = std::invoke_result_t<Callback, pybind11::object>;
 
 	static_assert(
 		!std::is_same_v<ReturnType, pybind11::object>,
 		"ReturnType must not be pybind11::object; convert to a pure C++ type in the callback.");
 
-	auto args_tuple = std::make_tuple(std::forward<Args>(args)...);
-
 	auto promise = std::make_shared<std::promise<ReturnType>>();
 	auto future = promise->get_future();
 
-	// Type-erase commit: captures commit_fn + args, returns pybind11::object
-	auto commit = [commit_fn = std::forward<CommitFn>(commit_fn),
-				   args = std::move(args_tuple)]() mutable -> pybind11::object {
-		return std::apply(
-			[&commit_fn](auto&&... unpacked) -> pybind11::object {
-				return commit_fn(std::forward<decltype(unpacked)>(unpacked)...);
-			},
-			std::move(args));
-	};
-
 	// Type-erase callback: captures callback + promise, processes one result
 	auto on_result = [cb = std::forward<Callback>(callback),
 					  promise](pybind11::object result) mutable {
@@ -138,19 +346,144 @@ auto PyManager::InvokeHandler::queue_invoke(CommitFn&& commit_fn,
 	// Error path: propagates exception to the future
 	auto on_error = [promise](std::exception_ptr eptr) { promise->set_exception(eptr); };
 
-	_state->commit_queue.enqueue(
-		QueueEntry{ std::move(commit), std::move(on_result), std::move(on_error) });
-	_state->total_enqueued.fetch_add(1, std::memory_order_relaxed);
-
+	QueueEntry entry;
+	entry.commit = makeCommit(std::forward<CommitFn>(commit_fn), std::forward<Args>(args)...);
+	entry.on_result = std::move(on_result);
+	entry.on_error = std::move(on_error);
+	entry.key = key.value_or(0);
+	entry.has_key = key.has_value();
+	submit(std::move(entry));
 	return future;
 }
 
+template <typename CommitFn, typename PartialFn, typename... Args>
+auto PyManager::InvokeHandler::queue_invoke_stream(CommitFn&& commit_fn,
+												   PartialFn&& on_partial,
+												   Args&&... args)
+	-> ResultStream<std::invoke_result_t<PartialFn, pybind11::object>> {
+	using ValueType = std::invoke_result_t<PartialFn, pybind11::object>;
+
+	static_assert(!std::is_void_v<ValueType> && !std::is_same_v<ValueType, pybind11::object>,
+				  "on_partial must convert each partial result to a pure C++ value.");
+
+	if(_state->process_pool) {
+		throw std::logic_error("Streaming is not supported on out-of-process handlers");
+	}
+
+	auto channel = std::make_shared<details::StreamChannel<ValueType>>();
+
+	QueueEntry entry;
+	entry.commit = makeCommit(std::forward<CommitFn>(commit_fn), std::forward<Args>(args)...);
+	entry.on_partial = [fn = std::forward<PartialFn>(on_partial),
+						channel](pybind11::object partial) mutable {
+		try {
+			channel->push(std::invoke(fn, std::move(partial)));
+		} catch(...) {
+			channel->close(std::current_exception());
+		}
+	};
+	entry.on_result = [channel](pybind11::object) { channel->close(); };
+	entry.on_error = [channel](std::exception_ptr eptr) { channel->close(eptr); };
+	submit(std::move(entry));
+	return ResultStream<ValueType>(std::move(channel));
+}
+
+template <typename T, typename CommitFn, typename... Args>
+void PyManager::InvokeHandler::queue_invoke_into(CommitFn&& commit_fn,
+												 std::span<T> destination,
+												 CompletionGroup& group,
+												 Args&&... args) {
+	group.add();
+	QueueEntry entry;
+	entry.commit = makeCommit(std::forward<CommitFn>(commit_fn), std::forward<Args>(args)...);
+	entry.on_result = [destination, group](pybind11::object result) mutable {
+		try {
+			copyResultInto(result, destination);
+			group.done();
+		} catch(...) {
+			group.done(std::current_exception());
+		}
+	};
+	entry.on_error = [group](std::exception_ptr eptr) mutable { group.done(eptr); };
+	submit(std::move(entry));
+}
+
+template <typename CommitFn, typename... Args>
+MoveOnlyFunction<pybind11::object()> PyManager::InvokeHandler::makeCommit(CommitFn&& commit_fn,
+																		  Args&&... args) {
+	// Captures commit_fn + args, returns pybind11::object
+	return [commit_fn = std::forward<CommitFn>(commit_fn),
+			args = std::make_tuple(std::forward<Args>(args)...)]() mutable -> pybind11::object {
+		return std::apply(
+			[&commit_fn](auto&&... unpacked) -> pybind11::object {
+				return commit_fn(std::forward<decltype(unpacked)>(unpacked)...);
+			},
+			std::move(args));
+	};
+}
+
+inline void PyManager::InvokeHandler::submit(QueueEntry entry) {
+	submitTo(*_state, std::move(entry));
+}
+
+inline void PyManager::InvokeHandler::submitTo(WorkerState& state,
+												QueueEntry entry,
+												bool priority) {
+	// Mark the queue as non-empty before publishing the entry, so a worker that drains it
+	// and clears the mark cannot be overtaken by a stale timestamp.
+	const auto enqueued = std::chrono::steady_clock::now();
+	std::int64_t no_pending = 0;
+	state.oldest_pending_ns.compare_exchange_strong(
+		no_pending, details::steadyNs(enqueued), std::memory_order_relaxed);
+
+	uint64_t trace_id = 0;
+	if(Tracer::enabled()) {
+		trace_id = Tracer::next_request_id();
+		Tracer::record(Tracer::Phase::kEnqueue, trace_id, 0, state.id, enqueued);
+	}
+
+	entry.enqueued = enqueued;
+	entry.trace_id = trace_id;
+	if(priority) {
+		state.priority_queue.enqueue(std::move(entry));
+		state.total_enqueued.fetch_add(1, std::memory_order_relaxed);
+		// Taking the lock orders the enqueue before an idle worker's check of the lane
+		{ std::lock_guard<std::mutex> lock(state.wake_mutex); }
+		state.wake.notify_one();
+		return;
+	}
+	state.commit_queue.enqueue(std::move(entry));
+	state.total_enqueued.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline void PyManager::InvokeHandler::closeQueues(WorkerState& state) {
+	{
+		std::lock_guard<std::mutex> lock(state.submit_mutex);
+		state.closed = true;
+	}
+	std::exception_ptr error = std::make_exception_ptr(
+		std::runtime_error("Handler " + state.name + " shut down before running the item"));
+	QueueEntry entry;
+	while(state.priority_queue.try_dequeue(entry) || state.commit_queue.try_dequeue(entry)) {
+		try {
+			entry.on_error(error);
+		} catch(...) {
+		}
+		state.total_completed.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
 inline PyManager::InvokeHandler::QueueStats
 PyManager::InvokeHandler::get_queue_stats() const {
 	QueueStats stats;
-	stats.commit_queue_size = _state->commit_queue.size_approx();
+	stats.commit_queue_size = _state->queued();
 	stats.execute_queue_size = _state->execute_queue_size.load(std::memory_order_relaxed);
 	stats.total_enqueued = _state->total_enqueued.load(std::memory_order_relaxed);
+	stats.total_completed = _state->total_completed.load(std::memory_order_relaxed);
+	stats.bisected_batches = _state->bisected_batches.load(std::memory_order_relaxed);
+	stats.bisect_retries = _state->bisect_retries.load(std::memory_order_relaxed);
+	stats.bisect_python_ns = _state->bisect_python_ns.load(std::memory_order_relaxed);
+	stats.bisect_failed_items = _state->bisect_failed_items.load(std::memory_order_relaxed);
 	{
 		std::lock_guard<std::mutex> lock(_state->stats_mutex);
 		stats.commit_batch_size_ema = _state->commit_batch_size_ema;
@@ -161,239 +494,1804 @@ PyManager::InvokeHandler::get_queue_stats() const {
 	return stats;
 }
 
-///////////////////////////////////////////////////////////////////////////////
-// InvokeHandler Worker Loop
-///////////////////////////////////////////////////////////////////////////////
-
-inline void PyManager::InvokeHandler::workerLoop(std::shared_ptr<WorkerState> state,
-												 std::shared_ptr<pybind11::object> resource,
-												 size_t batch_size,
-												 size_t prefetch_depth,
-												 std::shared_ptr<std::atomic<bool>> active) {
-	std::deque<CommittedEntry> prefetch_buffer;
-	const size_t buffer_capacity = batch_size * prefetch_depth;
-	constexpr double kEmaAlpha = 0.1;
-
-	auto blend = [](double ema, double sample, bool first) {
-		return first ? sample : kEmaAlpha * sample + (1.0 - kEmaAlpha) * ema;
-	};
-
-	while(active->load() || state->commit_queue.size_approx() > 0 || !prefetch_buffer.empty()) {
-
-		// Block-wait only when prefetch buffer is empty and queue is empty
-		if(prefetch_buffer.empty() && state->commit_queue.size_approx() == 0) {
-			std::this_thread::sleep_for(std::chrono::milliseconds(5));
-			continue;
-		}
+inline size_t PyManager::InvokeHandler::outstanding() const {
+	auto pending = _state->total_enqueued.load(std::memory_order_relaxed) -
+				   _state->total_completed.load(std::memory_order_relaxed);
+	return pending > 0 ? static_cast<size_t>(pending) : 0;
+}
 
-		{ // GIL scope
-			pybind11::gil_scoped_acquire gil;
+inline HandlerMetricsSnapshot PyManager::InvokeHandler::get_metrics() const {
+	return snapshotMetrics(*_state);
+}
 
-			// Phase 1: Refill prefetch buffer up to batch_size * prefetch_depth
-			size_t commit_count = 0;
-			auto commit_start = std::chrono::steady_clock::now();
-			while(prefetch_buffer.size() < buffer_capacity) {
-				QueueEntry entry;
-				if(!state->commit_queue.try_dequeue(entry)) break;
+inline GilStats PyManager::InvokeHandler::get_gil_stats() const {
+	return _state->gil.snapshot();
+}
 
-				try {
-					pybind11::object committed = entry.commit();
-					prefetch_buffer.push_back(CommittedEntry{ std::move(committed),
-														  std::move(entry.on_result),
-														  std::move(entry.on_error) });
-					commit_count++;
-				} catch(...) {
-					try {
-						entry.on_error(std::current_exception());
-					} catch(...) {
-					}
-				}
-			}
-			auto commit_end = std::chrono::steady_clock::now();
+inline std::shared_future<PyManager::WarmupReport> PyManager::InvokeHandler::ready() const {
+	return _state->ready;
+}
 
-			if(commit_count > 0) {
-				double commit_ns =
-					static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
-											commit_end - commit_start)
-											.count());
-				std::lock_guard<std::mutex> lock(state->stats_mutex);
-				const bool first = !state->has_commit_sample;
-				state->commit_batch_size_ema = blend(
-					state->commit_batch_size_ema, static_cast<double>(commit_count), first);
-				state->commit_ns_per_batch_ema =
-					blend(state->commit_ns_per_batch_ema, commit_ns, first);
-				state->has_commit_sample = true;
-			}
-			state->execute_queue_size.store(prefetch_buffer.size(), std::memory_order_relaxed);
+inline std::future<std::string> PyManager::InvokeHandler::profile_python(size_t batches) {
+	if(batches == 0) {
+		throw std::invalid_argument("profile_python needs at least one batch");
+	}
+	if(_state->process_pool) {
+		throw std::logic_error("Python profiling is not supported on out-of-process handlers");
+	}
+	std::lock_guard<std::mutex> lock(_state->profile_mutex);
+	if(_state->profile_busy.load(std::memory_order_relaxed)) {
+		throw std::logic_error("A Python profile is already running on this handler");
+	}
+	_state->profile_batches = batches;
+	_state->profile_result = std::promise<std::string>();
+	auto future = _state->profile_result.get_future();
+	_state->profile_busy.store(true, std::memory_order_release);
+	return future;
+}
 
-			// Phase 2: Execute batch — consume up to batch_size items (opportunistic)
-			size_t batch_target = std::min(batch_size, prefetch_buffer.size());
+inline void PyManager::InvokeHandler::start_recording(
+	std::shared_ptr<TrafficRecorder> recorder,
+	std::function<std::string(pybind11::handle)> serialize) {
+	if(!recorder) {
+		throw std::invalid_argument("start_recording needs a recorder");
+	}
+	if(_state->process_pool) {
+		throw std::logic_error("Traffic recording is not supported on out-of-process handlers");
+	}
+	if(!serialize) serialize = details::picklePayload;
+	auto target = std::make_shared<const details::RecordingTarget>(
+		details::RecordingTarget{ std::move(recorder), std::move(serialize) });
+	std::lock_guard<std::mutex> lock(_state->recording_mutex);
+	_state->recording = std::move(target);
+	_state->recording_on.store(true, std::memory_order_release);
+}
 
-			if(batch_target > 0) {
-				pybind11::list batch;
-				std::vector<MoveOnlyFunction<void(pybind11::object)>> result_callbacks;
-				std::vector<MoveOnlyFunction<void(std::exception_ptr)>> error_callbacks;
-				result_callbacks.reserve(batch_target);
-				error_callbacks.reserve(batch_target);
+inline void PyManager::InvokeHandler::stop_recording() {
+	std::shared_ptr<const details::RecordingTarget> stopped;
+	std::lock_guard<std::mutex> lock(_state->recording_mutex);
+	_state->recording_on.store(false, std::memory_order_release);
+	// Released outside the lock; in-flight items keep their own reference
+	stopped = std::move(_state->recording);
+}
 
-				for(size_t i = 0; i < batch_target; i++) {
-					batch.append(std::move(prefetch_buffer.front().committed_obj));
-					result_callbacks.push_back(std::move(prefetch_buffer.front().on_result));
-					error_callbacks.push_back(std::move(prefetch_buffer.front().on_error));
-					prefetch_buffer.pop_front();
-				}
-				state->execute_queue_size.store(prefetch_buffer.size(),
-												std::memory_order_relaxed);
+inline void PyManager::InvokeHandler::pinWorker(const WorkerState& state) {
+	try {
+		applyThreadAffinity(state.affinity);
+	} catch(const std::exception& e) {
+		std::cerr << "Could not apply the affinity of handler " << state.name << ": " << e.what()
+				  << std::endl;
+	}
+}
 
-				auto execute_start = std::chrono::steady_clock::now();
-				try {
-					pybind11::object results = (*resource)(batch);
+inline HandlerMetricsSnapshot
+PyManager::InvokeHandler::snapshotMetrics(const WorkerState& state) {
+	HandlerMetricsSnapshot metrics;
+	metrics.handler = state.name;
+	metrics.id = state.id;
+	metrics.commit_queue_size = state.queued();
+	metrics.execute_queue_size = state.execute_queue_size.load(std::memory_order_relaxed);
+	metrics.total_enqueued = state.total_enqueued.load(std::memory_order_relaxed);
+
+	const std::int64_t oldest = state.oldest_pending_ns.load(std::memory_order_relaxed);
+	const std::int64_t now = details::steadyNs(std::chrono::steady_clock::now());
+	if(oldest != 0 && now > oldest) {
+		metrics.oldest_item_age_ns = static_cast<uint64_t>(now - oldest);
+	}
 
-					// Phase 3: Fan-out — dispatch each result to its callback
-					for(size_t i = 0; i < result_callbacks.size(); i++) {
-						try {
-							result_callbacks[i](results[pybind11::int_(i)]);
-						} catch(...) {
-						}
-					}
-				} catch(...) {
-					auto eptr = std::current_exception();
-					for(size_t i = 0; i < error_callbacks.size(); i++) {
-						try {
-							error_callbacks[i](eptr);
-						} catch(...) {
-						}
-					}
-				}
-				auto execute_end = std::chrono::steady_clock::now();
+	metrics.queue_wait_ns = state.histograms.queue_wait_ns.snapshot();
+	metrics.commit_ns = state.histograms.commit_ns.snapshot();
+	metrics.hold_ns = state.histograms.hold_ns.snapshot();
+	metrics.execute_batch_ns = state.histograms.execute_batch_ns.snapshot();
+	metrics.execute_item_ns = state.histograms.execute_item_ns.snapshot();
+	metrics.fanout_ns = state.histograms.fanout_ns.snapshot();
+	metrics.batch_size = state.histograms.batch_size.snapshot();
+	metrics.gil = state.gil.snapshot();
+	return metrics;
+}
 
-				double execute_ns =
-					static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
-											execute_end - execute_start)
-											.count());
-				std::lock_guard<std::mutex> lock(state->stats_mutex);
-				const bool first = !state->has_execute_sample;
-				state->execute_batch_size_ema = blend(
-					state->execute_batch_size_ema, static_cast<double>(batch_target), first);
-				state->execute_ns_per_batch_ema =
-					blend(state->execute_ns_per_batch_ema, execute_ns, first);
-				state->has_execute_sample = true;
-			}
-		} // GIL released
+inline PyManager::InvokeHandler::ScopedGil::ScopedGil(PyThreadState* tstate,
+													   GilCounters* counters)
+	: _tstate(tstate)
+	, _counters(counters) {
+	// A nested acquisition on a thread that already holds the GIL neither waits nor ends a scope
+	_profiled = GilProfiler::enabled() && (_tstate != nullptr || !PyGILState_Check());
+	const auto wait_start =
+		_profiled ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{ };
+	if(_tstate != nullptr) {
+		PyEval_RestoreThread(_tstate);
+	} else {
+		_main.emplace();
 	}
+	if(_profiled) {
+		_acquired = std::chrono::steady_clock::now();
+		_wait_ns = details::elapsedNs(wait_start, _acquired);
+		_cpu_start_ns = GilProfiler::thread_cpu_ns();
+	}
+}
 
-	// Clean up any remaining pybind11 objects with GIL held
-	if(!prefetch_buffer.empty()) {
-		pybind11::gil_scoped_acquire gil;
-		prefetch_buffer.clear();
+inline PyManager::InvokeHandler::ScopedGil::~ScopedGil() {
+	if(_profiled) {
+		const uint64_t cpu_ns = GilProfiler::thread_cpu_ns() - _cpu_start_ns;
+		const uint64_t scope_ns = details::elapsedNs(_acquired, std::chrono::steady_clock::now());
+		GilProfiler::record(_counters, _wait_ns, scope_ns, cpu_ns);
+	}
+	if(_tstate != nullptr) {
+		(void)PyEval_SaveThread();
 	}
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// Impl PyManager
+// InvokeHandler Worker Loop
 ///////////////////////////////////////////////////////////////////////////////
 
-PyManager::PyManager() {
-	shared().arc.fetch_add(1, std::memory_order_acq_rel);
-
-	// The Python interpreter is initialized exactly once per process and the
-	// owning thread is parked forever. This keeps a valid PyThreadState alive
-	// for the lifetime of the process so that static destructors in libraries
-	// such as libtorch_python (which decref Python objects at exit) can safely
-	// acquire the GIL.
-	std::call_once(shared().init_flag, [] {
-		std::thread([] { PyManager::mainLoop(); }).detach();
-		while(!shared().interpreter_initialized.load(std::memory_order_acquire))
-			continue;
-
-		// Release any cached pybind11 handles before static destructors run,
-		// so dec_ref happens with the GIL held.
-		std::atexit([] {
-			if(!shared().interpreter_initialized.load(std::memory_order_acquire)) return;
-			pybind11::gil_scoped_acquire gil;
-			shared().py_invoke_handler_map.clear();
-		});
-	});
+namespace details {
+/// @brief results[index] of an entry point's result list. Lists and tuples are indexed in
+/// place; other sequences go through __getitem__. Requires the GIL.
+inline pybind11::object sequenceItem(const pybind11::object& results, size_t index) {
+	PyObject* seq = results.ptr();
+	const auto i = static_cast<Py_ssize_t>(index);
+	if(PyList_CheckExact(seq) && i < PyList_GET_SIZE(seq)) {
+		return pybind11::reinterpret_borrow<pybind11::object>(PyList_GET_ITEM(seq, i));
+	}
+	if(PyTuple_CheckExact(seq) && i < PyTuple_GET_SIZE(seq)) {
+		return pybind11::reinterpret_borrow<pybind11::object>(PyTuple_GET_ITEM(seq, i));
+	}
+	return results[pybind11::int_(index)];
 }
 
-PyManager::~PyManager() {
-	shared().arc.fetch_sub(1, std::memory_order_acq_rel);
-	// Interpreter is intentionally not finalized; see PyManager() for rationale.
+/// @brief The exception being handled, as an exception_ptr that may be rethrown on any
+/// thread. In an isolated handler a pybind11::error_already_set is reduced to its text: it
+/// holds the subinterpreter's objects, and releasing or formatting it elsewhere would take
+/// the main interpreter's GIL. Call from a catch block, with the worker's GIL held.
+inline std::exception_ptr workerError(bool isolated) {
+	if(isolated) {
+		try {
+			throw;
+		} catch(const pybind11::error_already_set& e) {
+			return std::make_exception_ptr(std::runtime_error(e.what()));
+		} catch(...) {
+		}
+	}
+	return std::current_exception();
 }
 
-PyManager::InvokeHandler PyManager::loadPythonModule(const std::string& module_name,
-													 const std::string& entry_point,
-													 size_t batch_size,
-													 size_t prefetch_depth) {
+/// @brief Folds a sample into an exponential moving average; the first sample seeds it.
+inline double blendEma(double ema, double sample, bool first) {
+	constexpr double kEmaAlpha = 0.1;
+	return first ? sample : kEmaAlpha * sample + (1.0 - kEmaAlpha) * ema;
+}
 
-	if(!shared().interpreter_initialized) {
-		throw std::runtime_error("Python interpreter not initialized");
+/// @brief Tracer bookkeeping for one batch. Inert unless tracing was enabled when the
+/// batch was assembled.
+class BatchTrace {
+public:
+	void begin(uint64_t handler_id, size_t capacity) {
+		if(!Tracer::enabled()) return;
+		_handler_id = handler_id;
+		_batch_id = Tracer::next_batch_id();
+		_request_ids.reserve(capacity);
 	}
 
-	SharedState& state = shared();
+	void add(uint64_t request_id, std::chrono::steady_clock::time_point assembled) {
+		if(_batch_id == 0) return;
+		_request_ids.push_back(request_id);
+		if(request_id != 0) {
+			Tracer::record(
+				Tracer::Phase::kBatchAssembled, request_id, _batch_id, _handler_id, assembled);
+		}
+	}
 
-	pybind11::gil_scoped_acquire gil;
+	void execute(Tracer::Phase phase, std::chrono::steady_clock::time_point ts) {
+		if(_batch_id == 0) return;
+		Tracer::record(
+			phase, 0, _batch_id, _handler_id, ts, static_cast<uint32_t>(_request_ids.size()));
+	}
 
-	auto module_it = state.py_invoke_handler_map.find(module_name);
-	if(module_it == state.py_invoke_handler_map.end()) {
-		pybind11::module_ mod;
-		try {
-			mod = pybind11::module_::import(module_name.c_str());
-		} catch(pybind11::error_already_set& e) {
-			throw std::invalid_argument("Could not import module '" + module_name +
-										"': " + std::string(e.what()));
-		}
+	void callback_done(size_t index) {
+		if(_batch_id == 0 || _request_ids[index] == 0) return;
+		Tracer::record(Tracer::Phase::kCallbackEnd,
+					   _request_ids[index],
+					   _batch_id,
+					   _handler_id,
+					   std::chrono::steady_clock::now());
+	}
 
-		auto [inserted_it, successful] =
-			state.py_invoke_handler_map.emplace(module_name, PyInvokeHandlerEntry{ mod, { } });
-		module_it = inserted_it;
+private:
+	uint64_t _handler_id = 0;
+	uint64_t _batch_id = 0;
+	std::vector<uint64_t> _request_ids;
+};
+
+/// @brief TrafficRecorder bookkeeping for one batch. Inert unless some of its items were
+/// committed while recording; keeps its capacity across clear().
+class BatchRecording {
+public:
+	void clear() {
+		_items.clear();
+		_next = 0;
 	}
 
-	auto object_it = module_it->second.handler_map.find(entry_point);
-	if(object_it == module_it->second.handler_map.end()) {
-		pybind11::object obj;
-		try {
-			obj = module_it->second.module_.attr(entry_point.c_str());
-		} catch(pybind11::error_already_set& e) {
-			throw std::invalid_argument("Could not find the '" + entry_point +
-										"' method in module " + module_name +
-										": " + std::string(e.what()));
-		}
+	void add(size_t index,
+			 std::shared_ptr<const RecordingTarget> target,
+			 std::string payload,
+			 std::chrono::steady_clock::time_point enqueued,
+			 std::chrono::steady_clock::time_point committed,
+			 std::chrono::steady_clock::time_point assembled) {
+		Item& item = _items.emplace_back();
+		item.index = index;
+		item.request.arrival_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+									  enqueued - target->recorder->origin())
+									  .count();
+		item.request.commit_ns = elapsedNs(enqueued, committed);
+		item.request.hold_ns = elapsedNs(committed, assembled);
+		item.request.payload = std::move(payload);
+		item.target = std::move(target);
+	}
 
-		auto obj_ptr = std::make_shared<pybind11::object>(obj);
-		auto [handler_it, handler_inserted] =
-			module_it->second.handler_map.emplace(entry_point, obj_ptr);
-		if(!handler_inserted) {
-			obj_ptr = handler_it->second;
+	void executed(size_t batch_size,
+				  std::chrono::steady_clock::time_point execute_start,
+				  std::chrono::steady_clock::time_point python_end) {
+		_python_end = python_end;
+		for(Item& item : _items) {
+			item.request.batch_size = static_cast<uint32_t>(batch_size);
+			item.request.execute_ns = elapsedNs(execute_start, python_end);
 		}
-		size_t id = module_it->second.handler_map.size() - 1;
+	}
 
-		return PyManager::InvokeHandler(
-			id, obj_ptr, std::make_unique<PyManager>(), batch_size, prefetch_depth);
+	/// @brief Writes the item at index once its callback has run. Called in index order.
+	void callback_done(size_t index, bool failed) {
+		if(_next == _items.size() || _items[_next].index != index) return;
+		Item& item = _items[_next++];
+		item.request.callback_ns = elapsedNs(_python_end, std::chrono::steady_clock::now());
+		item.request.failed = failed;
+		item.target->recorder->write(item.request);
+		item.target.reset();
 	}
 
-	size_t id = 0;
-	return PyManager::InvokeHandler(
-		id, object_it->second, std::make_unique<PyManager>(), batch_size, prefetch_depth);
+private:
+	struct Item {
+		size_t index = 0;
+		std::shared_ptr<const RecordingTarget> target;
+		RecordedRequest request;
+	};
+	std::vector<Item> _items;
+	size_t _next = 0;
+	std::chrono::steady_clock::time_point _python_end;
+};
+} // namespace details
+
+inline void PyManager::InvokeHandler::WorkerState::record_commit(size_t count, double ns) {
+	std::lock_guard<std::mutex> lock(stats_mutex);
+	const bool first = !has_commit_sample;
+	commit_batch_size_ema =
+		details::blendEma(commit_batch_size_ema, static_cast<double>(count), first);
+	commit_ns_per_batch_ema = details::blendEma(commit_ns_per_batch_ema, ns, first);
+	has_commit_sample = true;
 }
 
-void PyManager::add_path(const std::string& directory) {
-	if(directory.empty()) {
-		throw std::invalid_argument("Path cannot be empty");
-	}
+inline void PyManager::InvokeHandler::WorkerState::record_execute(size_t count, double ns) {
+	std::lock_guard<std::mutex> lock(stats_mutex);
+	const bool first = !has_execute_sample;
+	execute_batch_size_ema =
+		details::blendEma(execute_batch_size_ema, static_cast<double>(count), first);
+	execute_ns_per_batch_ema = details::blendEma(execute_ns_per_batch_ema, ns, first);
+	has_execute_sample = true;
+}
 
-	if(!shared().interpreter_initialized) {
-		throw std::runtime_error("Python interpreter not initialized");
-	}
+inline void PyManager::InvokeHandler::WorkerState::record_batch(size_t count,
+																 uint64_t execute_ns,
+																 uint64_t fanout_ns) {
+	histograms.batch_size.record(count);
+	histograms.execute_batch_ns.record(execute_ns);
+	histograms.execute_item_ns.record(count > 0 ? execute_ns / count : execute_ns);
+	histograms.fanout_ns.record(fanout_ns);
+}
 
-	SharedState& state = shared();
+inline size_t PyManager::InvokeHandler::WorkerState::queued() const {
+	return commit_queue.size_approx() + priority_queue.size_approx();
+}
 
-	pybind11::gil_scoped_acquire gil;
+inline void PyManager::InvokeHandler::WorkerState::idle_wait() {
+	std::unique_lock<std::mutex> lock(wake_mutex);
+	wake.wait_for(lock, std::chrono::milliseconds(5), [this] {
+		return priority_queue.size_approx() > 0;
+	});
+}
 
-	constexpr const char* kSysModule = "sys";
-	constexpr const char* kPathObjectKey = "__sys_path__";
+inline void PyManager::InvokeHandler::WorkerState::publish_oldest(
+	const details::FixedRing<CommittedEntry>& prefetch_buffer,
+	std::optional<std::chrono::steady_clock::time_point> last_taken) {
+	if(!prefetch_buffer.empty()) {
+		oldest_pending_ns.store(details::steadyNs(prefetch_buffer.front().enqueued),
+								std::memory_order_relaxed);
+	} else if(queued() == 0) {
+		oldest_pending_ns.store(0, std::memory_order_relaxed);
+	} else if(last_taken) {
+		oldest_pending_ns.store(details::steadyNs(*last_taken), std::memory_order_relaxed);
+	}
+}
 
-	auto module_it = state.py_invoke_handler_map.find(kSysModule);
+inline void PyManager::InvokeHandler::commitPhase(
+	WorkerState& state,
+	details::FixedRing<CommittedEntry>& prefetch_buffer) {
+	size_t commit_count = 0;
+	std::optional<std::chrono::steady_clock::time_point> last_taken;
+	std::shared_ptr<const details::RecordingTarget> recording;
+	if(state.recording_on.load(std::memory_order_acquire)) {
+		std::lock_guard<std::mutex> lock(state.recording_mutex);
+		recording = state.recording;
+	}
+	auto commit_start = std::chrono::steady_clock::now();
+	auto item_start = commit_start;
+	// The priority lane first, so synchronous invoke calls join the next batch
+	bool priority = state.invoke_via_worker;
+	while(!prefetch_buffer.full()) {
+		QueueEntry entry;
+		if(priority && !state.priority_queue.try_dequeue(entry)) priority = false;
+		if(!priority && !state.commit_queue.try_dequeue(entry)) break;
+		if(!priority) last_taken = entry.enqueued;
+		state.histograms.queue_wait_ns.record(details::elapsedNs(entry.enqueued, item_start));
+
+		if(entry.trace_id != 0) {
+			Tracer::record(Tracer::Phase::kCommitStart, entry.trace_id, 0, state.id, item_start);
+		}
+
+		try {
+			pybind11::object committed = entry.commit();
+			uint64_t key = entry.key;
+			if(!entry.has_key && state.batch_key) {
+				key = state.batch_key(committed);
+			}
+			auto item_end = std::chrono::steady_clock::now();
+			state.histograms.commit_ns.record(details::elapsedNs(item_start, item_end));
+			if(entry.trace_id != 0) {
+				Tracer::record(Tracer::Phase::kCommitEnd, entry.trace_id, 0, state.id, item_end);
+			}
+			// Serialized outside the timed commit; a failure only loses the recording
+			std::shared_ptr<const details::RecordingTarget> recorded;
+			std::string payload;
+			if(recording) {
+				try {
+					payload = recording->serialize(committed);
+					recorded = recording;
+				} catch(...) {
+					recording->recorder->drop();
+				}
+			}
+			prefetch_buffer.push_back(CommittedEntry{ std::move(committed),
+													  std::move(entry.on_result),
+													  std::move(entry.on_error),
+													  entry.enqueued,
+													  item_end,
+													  entry.trace_id,
+													  key,
+													  std::move(entry.on_partial),
+													  std::move(recorded),
+													  std::move(payload),
+													  priority });
+			if(priority) {
+				// Ahead of everything but earlier priority entries
+				const size_t last = prefetch_buffer.size() - 1;
+				size_t to = 0;
+				while(to < last && prefetch_buffer[to].priority) to++;
+				prefetch_buffer.move_forward(last, to);
+			}
+			item_start = recording ? std::chrono::steady_clock::now() : item_end;
+			commit_count++;
+		} catch(...) {
+			try {
+				entry.on_error(details::workerError(state.isolated));
+			} catch(...) {
+			}
+			state.total_completed.fetch_add(1, std::memory_order_relaxed);
+			item_start = std::chrono::steady_clock::now();
+			if(entry.trace_id != 0) {
+				Tracer::record(Tracer::Phase::kCommitEnd, entry.trace_id, 0, state.id, item_start);
+				Tracer::record(
+					Tracer::Phase::kCallbackEnd, entry.trace_id, 0, state.id, item_start);
+			}
+		}
+	}
+	auto commit_end = std::chrono::steady_clock::now();
+	state.publish_oldest(prefetch_buffer, last_taken);
+
+	if(commit_count > 0) {
+		state.record_commit(
+			commit_count,
+			static_cast<double>(
+				std::chrono::duration_cast<std::chrono::nanoseconds>(commit_end - commit_start)
+					.count()));
+	}
+	state.execute_queue_size.store(prefetch_buffer.size(), std::memory_order_relaxed);
+}
+
+inline size_t PyManager::InvokeHandler::selectBatch(
+	WorkerState& state,
+	details::FixedRing<CommittedEntry>& prefetch_buffer,
+	size_t batch_size) {
+	size_t available = std::min(batch_size, prefetch_buffer.size());
+	if(available == 0 || !state.keyed.load(std::memory_order_relaxed)) {
+		return available;
+	}
+
+	// The buffer stays in commit order, so its front is the oldest item. Past the max wait
+	// its key goes next; otherwise run the fullest key (the earliest on a tie).
+	uint64_t key = prefetch_buffer.front().key;
+	auto waited = std::chrono::steady_clock::now() - prefetch_buffer.front().enqueued;
+	// A synchronous invoke at the front picks the key as if it had waited too long
+	if(waited < state.batch_key_max_wait && !prefetch_buffer.front().priority) {
+		auto& counts = state.key_counts;
+		counts.clear();
+		for(size_t i = 0; i < prefetch_buffer.size(); i++) {
+			const uint64_t entry_key = prefetch_buffer[i].key;
+			auto it = std::find_if(counts.begin(), counts.end(), [&](const auto& count) {
+				return count.first == entry_key;
+			});
+			if(it == counts.end()) {
+				counts.emplace_back(entry_key, 1);
+			} else {
+				it->second++;
+			}
+		}
+		auto fullest = std::max_element(
+			counts.begin(), counts.end(), [](const auto& a, const auto& b) {
+				return a.second < b.second;
+			});
+		key = fullest->first;
+	}
+
+	// Move each entry of the key down to the end of the selected prefix, which keeps the
+	// relative order of both the selected and the remaining entries.
+	size_t selected = 0;
+	for(size_t i = 0; i < prefetch_buffer.size() && selected < batch_size; i++) {
+		if(prefetch_buffer[i].key != key) continue;
+		if(i != selected) prefetch_buffer.move_forward(i, selected);
+		selected++;
+	}
+	return selected;
+}
+
+inline pybind11::list PyManager::InvokeHandler::drainStream(
+	pybind11::object iterator,
+	std::vector<MoveOnlyFunction<void(pybind11::object)>>& partial_callbacks) {
+	pybind11::list last;
+	for(size_t i = 0; i < partial_callbacks.size(); i++) {
+		last.append(pybind11::none());
+	}
+	for(pybind11::handle item : iterator) {
+		auto pair = item.cast<std::pair<size_t, pybind11::object>>();
+		if(pair.first >= partial_callbacks.size()) {
+			throw std::out_of_range("Streamed result index " + std::to_string(pair.first) +
+									" is outside the batch of " +
+									std::to_string(partial_callbacks.size()));
+		}
+		last[pair.first] = pair.second;
+		if(partial_callbacks[pair.first]) partial_callbacks[pair.first](std::move(pair.second));
+	}
+	return last;
+}
+
+inline void PyManager::InvokeHandler::bisectBatch(WorkerState& state,
+												 pybind11::object& resource,
+												 pybind11::handle items,
+												 size_t begin,
+												 size_t end,
+												 pybind11::list& results,
+												 std::vector<std::exception_ptr>& errors) {
+	const size_t mid = begin + (end - begin) / 2;
+	for(auto [first, last] : { std::pair{ begin, mid }, std::pair{ mid, end } }) {
+		pybind11::list half;
+		for(size_t i = first; i < last; i++) {
+			half.append(pybind11::handle(PyTuple_GET_ITEM(items.ptr(), i)));
+		}
+		const auto start = std::chrono::steady_clock::now();
+		std::exception_ptr error;
+		try {
+			pybind11::object half_results = resource(half);
+			for(size_t i = first; i < last; i++) {
+				results[i] = details::sequenceItem(half_results, i - first);
+			}
+		} catch(...) {
+			error = details::workerError(state.isolated);
+		}
+		state.bisect_retries.fetch_add(1, std::memory_order_relaxed);
+		state.bisect_python_ns.fetch_add(
+			static_cast<std::int64_t>(details::elapsedNs(start, std::chrono::steady_clock::now())),
+			std::memory_order_relaxed);
+		if(!error) continue;
+		if(last - first == 1) {
+			errors[first] = error;
+			state.bisect_failed_items.fetch_add(1, std::memory_order_relaxed);
+		} else {
+			bisectBatch(state, resource, items, first, last, results, errors);
+		}
+	}
+}
+
+inline pybind11::object& PyManager::InvokeHandler::eventLoop(WorkerState& state) {
+	if(!state.event_loop) {
+		state.event_loop = pybind11::module_::import("asyncio").attr("new_event_loop")();
+	}
+	return state.event_loop;
+}
+
+inline void PyManager::InvokeHandler::runWarmup(WorkerState& state,
+												pybind11::object& resource,
+												size_t batch_size) {
+	using Clock = std::chrono::steady_clock;
+	auto since = [](Clock::time_point start) {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+	};
+
+	const auto started = Clock::now();
+	try {
+		WarmupReport report;
+		pybind11::list samples;
+		if(!state.warmup_function.empty()) {
+			const auto function_start = Clock::now();
+			pybind11::object returned = pybind11::module_::import(state.module_name.c_str())
+											.attr(state.warmup_function.c_str())();
+			report.function = since(function_start);
+			if(!returned.is_none()) samples = pybind11::list(returned);
+		}
+
+		std::vector<size_t> sizes = state.warmup_batch_sizes;
+		if(sizes.empty()) sizes.push_back(batch_size);
+		if(state.warmup_batch || samples.size() > 0) {
+			for(size_t size : sizes) {
+				pybind11::list batch;
+				if(state.warmup_batch) {
+					batch = state.warmup_batch(size);
+				} else {
+					for(size_t i = 0; i < size; i++) {
+						batch.append(samples[i % samples.size()]);
+					}
+				}
+				const auto batch_start = Clock::now();
+				pybind11::object results = resource(batch);
+				if(PyCoro_CheckExact(results.ptr())) {
+					eventLoop(state).attr("run_until_complete")(results);
+				} else if(PyIter_Check(results.ptr())) {
+					// A streaming entry point only runs while it is iterated
+					for(pybind11::handle partial : results) {
+						(void)partial;
+					}
+				}
+				report.batches.emplace_back(size, since(batch_start));
+			}
+		}
+		report.total = since(started);
+		state.warmup_done.set_value(std::move(report));
+	} catch(const pybind11::error_already_set& e) {
+		// Rethrown on threads that may not hold this interpreter's GIL: keep only the text
+		state.warmup_done.set_exception(
+			std::make_exception_ptr(std::runtime_error("Warmup failed: " + std::string(e.what()))));
+	} catch(...) {
+		state.warmup_done.set_exception(std::current_exception());
+	}
+}
+
+inline void PyManager::InvokeHandler::workerLoop(std::shared_ptr<WorkerState> state,
+												 std::shared_ptr<pybind11::object> resource,
+												 size_t batch_size,
+												 size_t prefetch_depth,
+												 std::shared_ptr<std::atomic<bool>> active) {
+	// Isolated workers are pinned by isolatedWorkerMain before creating their interpreter
+	if(state->interpreter == nullptr) pinWorker(*state);
+
+	details::FixedRing<CommittedEntry> prefetch_buffer(batch_size * prefetch_depth);
+
+	// Active profile_python request, if any
+	std::unique_ptr<FrameProfiler> profiler;
+	size_t profile_remaining = 0;
+	std::promise<std::string> profile_result;
+	auto finish_profile = [&] {
+		std::string folded = profiler->folded();
+		profiler.reset();
+		// Cleared first so a caller woken by the future may start the next profile
+		state->profile_busy.store(false, std::memory_order_release);
+		profile_result.set_value(std::move(folded));
+	};
+
+	// A batch handed to the entry point, until its results are fanned out. Batches of an
+	// async def entry point stay in async_batches while their task runs on the event loop.
+	struct RunningBatch {
+		std::vector<MoveOnlyFunction<void(pybind11::object)>> result_callbacks;
+		std::vector<MoveOnlyFunction<void(std::exception_ptr)>> error_callbacks;
+		std::vector<MoveOnlyFunction<void(pybind11::object)>> partial_callbacks;
+		details::BatchTrace trace;
+		details::BatchRecording recording;
+		std::chrono::steady_clock::time_point execute_start;
+		pybind11::object task;
+		/// Per-item errors left by bisectBatch; empty unless the batch was bisected.
+		std::vector<std::exception_ptr> item_errors;
+	};
+	std::deque<RunningBatch> async_batches;
+	const size_t max_inflight = state->max_inflight_batches;
+
+	// Containers of the batch being assembled, reused from batch to batch so the steady
+	// state does not allocate; a batch handed to the event loop takes them along. The
+	// Python list passed to the entry point is cached per batch size, and replaced only
+	// when the entry point keeps a reference to it.
+	RunningBatch running;
+	std::vector<pybind11::object> batch_lists(batch_size + 1);
+	auto prepare = [&] {
+		running.result_callbacks.clear();
+		running.error_callbacks.clear();
+		running.partial_callbacks.clear();
+		running.result_callbacks.reserve(batch_size);
+		running.error_callbacks.reserve(batch_size);
+		running.partial_callbacks.reserve(batch_size);
+		running.item_errors.clear();
+		running.trace = details::BatchTrace();
+		running.recording.clear();
+		running.task = pybind11::object();
+	};
+	// Drops the committed objects now rather than when the list is next filled
+	auto recycle = [](pybind11::object& batch, size_t count) {
+		if(Py_REFCNT(batch.ptr()) != 1 ||
+		   PyList_GET_SIZE(batch.ptr()) != static_cast<Py_ssize_t>(count)) {
+			batch = pybind11::object();
+			return;
+		}
+		for(size_t i = 0; i < count; i++) {
+			Py_INCREF(Py_None);
+			PyList_SetItem(batch.ptr(), static_cast<Py_ssize_t>(i), Py_None);
+		}
+	};
+
+	// Phase 3: Fan-out — dispatch each result (or the batch's error) to its callback
+	auto finish = [&](RunningBatch& running,
+					  const pybind11::object& results,
+					  bool streamed,
+					  std::exception_ptr error,
+					  std::chrono::steady_clock::time_point python_end) {
+		running.trace.execute(Tracer::Phase::kExecuteEnd, python_end);
+		const size_t count = running.result_callbacks.size();
+		running.recording.executed(count, running.execute_start, python_end);
+		for(size_t i = 0; i < count; i++) {
+			const bool failed =
+				error || (!running.item_errors.empty() && running.item_errors[i]);
+			try {
+				if(error) {
+					running.error_callbacks[i](error);
+				} else if(failed) {
+					running.error_callbacks[i](running.item_errors[i]);
+				} else {
+					pybind11::object result = details::sequenceItem(results, i);
+					if(!streamed && running.partial_callbacks[i]) {
+						running.partial_callbacks[i](result);
+					}
+					running.result_callbacks[i](std::move(result));
+				}
+			} catch(...) {
+			}
+			running.trace.callback_done(i);
+			running.recording.callback_done(i, failed);
+		}
+		auto execute_end = std::chrono::steady_clock::now();
+		state->total_completed.fetch_add(static_cast<std::int64_t>(count),
+										 std::memory_order_relaxed);
+
+		state->record_execute(
+			count,
+			static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+									execute_end - running.execute_start)
+									.count()));
+		state->record_batch(count,
+							details::elapsedNs(running.execute_start, python_end),
+							details::elapsedNs(python_end, execute_end));
+		if(state->batch_hook) state->batch_hook(count);
+	};
+
+	// Runs the event loop until an async batch finishes or timeout passes, then fans out
+	// every finished batch. The loop releases the GIL while it waits for I/O.
+	auto poll_async = [&](double timeout_s) {
+		pybind11::list tasks;
+		for(const RunningBatch& running : async_batches) {
+			tasks.append(running.task);
+		}
+		try {
+			pybind11::module_ asyncio = pybind11::module_::import("asyncio");
+			pybind11::object first_completed = asyncio.attr("FIRST_COMPLETED");
+			state->event_loop.attr("run_until_complete")(
+				asyncio.attr("wait")(tasks,
+									 pybind11::arg("timeout") = timeout_s,
+									 pybind11::arg("return_when") = first_completed));
+		} catch(...) {
+			// The loop itself failed: nothing in flight can finish
+			auto error = details::workerError(state->isolated);
+			for(RunningBatch& running : async_batches) {
+				running.task.attr("cancel")();
+				finish(running, pybind11::object(), false, error, std::chrono::steady_clock::now());
+			}
+			async_batches.clear();
+			return;
+		}
+
+		for(auto it = async_batches.begin(); it != async_batches.end();) {
+			if(!it->task.attr("done")().cast<bool>()) {
+				++it;
+				continue;
+			}
+			auto python_end = std::chrono::steady_clock::now();
+			pybind11::object results;
+			std::exception_ptr error;
+			try {
+				results = it->task.attr("result")();
+			} catch(...) {
+				error = details::workerError(state->isolated);
+			}
+			finish(*it, results, false, error, python_end);
+			it = async_batches.erase(it);
+		}
+	};
+
+	if(!state->warmup_function.empty() || state->warmup_batch) {
+		ScopedGil gil(state->interpreter, &state->gil);
+		runWarmup(*state, *resource, batch_size);
+	}
+
+	while(active->load() || state->queued() > 0 || !prefetch_buffer.empty() ||
+		  !async_batches.empty()) {
+
+		// Block-wait only when prefetch buffer is empty and queue is empty
+		if(prefetch_buffer.empty() && state->queued() == 0 && async_batches.empty()) {
+			state->idle_wait();
+			continue;
+		}
+
+		{ // GIL scope
+			ScopedGil gil(state->interpreter, &state->gil);
+
+			// Phase 1: Refill prefetch buffer up to batch_size * prefetch_depth
+			commitPhase(*state, prefetch_buffer);
+
+			// Phase 2: Execute batch — consume up to batch_size items (opportunistic)
+			size_t batch_target = async_batches.size() < max_inflight
+									  ? selectBatch(*state, prefetch_buffer, batch_size)
+									  : 0;
+
+			if(batch_target > 0) {
+				prepare();
+				pybind11::object& batch = batch_lists[batch_target];
+				if(!batch) batch = pybind11::list(batch_target);
+
+				running.trace.begin(state->id, batch_target);
+				auto batch_start = std::chrono::steady_clock::now();
+				std::chrono::steady_clock::time_point last_taken;
+				for(size_t i = 0; i < batch_target; i++) {
+					CommittedEntry& entry = prefetch_buffer.front();
+					state->histograms.hold_ns.record(
+						details::elapsedNs(entry.committed, batch_start));
+					running.trace.add(entry.trace_id, batch_start);
+					if(entry.recording) {
+						running.recording.add(i,
+											  std::move(entry.recording),
+											  std::move(entry.payload),
+											  entry.enqueued,
+											  entry.committed,
+											  batch_start);
+					}
+					last_taken = entry.enqueued;
+					PyList_SetItem(batch.ptr(),
+								   static_cast<Py_ssize_t>(i),
+								   entry.committed_obj.release().ptr());
+					running.result_callbacks.push_back(std::move(entry.on_result));
+					running.error_callbacks.push_back(std::move(entry.on_error));
+					running.partial_callbacks.push_back(std::move(entry.on_partial));
+					prefetch_buffer.pop_front();
+				}
+				state->execute_queue_size.store(prefetch_buffer.size(),
+												std::memory_order_relaxed);
+				state->publish_oldest(prefetch_buffer, last_taken);
+
+				if(!profiler && state->profile_busy.load(std::memory_order_acquire)) {
+					std::lock_guard<std::mutex> lock(state->profile_mutex);
+					profiler = std::make_unique<FrameProfiler>(state->name);
+					profile_remaining = state->profile_batches;
+					profile_result = std::move(state->profile_result);
+				}
+				if(profiler) profiler->attach();
+
+				running.execute_start = std::chrono::steady_clock::now();
+				running.trace.execute(Tracer::Phase::kExecuteStart, running.execute_start);
+				// The entry point may consume its list, so bisection keeps its own copy
+				pybind11::object items;
+				if(state->bisect_failed_batches && batch_target > 1) {
+					items = pybind11::reinterpret_steal<pybind11::object>(
+						PyList_AsTuple(batch.ptr()));
+				}
+				pybind11::object results;
+				bool streamed = false;
+				std::exception_ptr error;
+				try {
+					results = (*resource)(batch);
+					if(PyCoro_CheckExact(results.ptr())) {
+						// async def entry point: runs on the event loop, finished by poll_async
+						running.task = eventLoop(*state).attr("create_task")(results);
+					} else if(PyIter_Check(results.ptr())) {
+						// Streaming entry points yield partial results while the batch runs
+						streamed = true;
+						results = drainStream(std::move(results), running.partial_callbacks);
+					}
+				} catch(...) {
+					error = details::workerError(state->isolated);
+				}
+				// Streamed batches already delivered partial results and cannot be re-run
+				if(error && items && !streamed) {
+					state->bisected_batches.fetch_add(1, std::memory_order_relaxed);
+					pybind11::list bisected;
+					for(size_t i = 0; i < batch_target; i++) {
+						bisected.append(pybind11::none());
+					}
+					running.item_errors.resize(batch_target);
+					bisectBatch(*state, *resource, items, 0, batch_target, bisected,
+								running.item_errors);
+					results = std::move(bisected);
+					error = nullptr;
+				}
+				auto python_end = std::chrono::steady_clock::now();
+				if(profiler) profiler->detach();
+
+				if(running.task) {
+					async_batches.push_back(std::move(running));
+				} else {
+					finish(running, results, streamed, error, python_end);
+				}
+				results = pybind11::object();
+				recycle(batch, batch_target);
+
+				if(profiler && --profile_remaining == 0) finish_profile();
+			}
+
+			if(!async_batches.empty()) {
+				// Wait for a running batch only when there is no new batch to start
+				const bool can_start = async_batches.size() < max_inflight &&
+									   (!prefetch_buffer.empty() ||
+										state->queued() > 0);
+				poll_async(can_start ? 0.0 : 0.005);
+			}
+		} // GIL released
+	}
+
+	// Clean up any remaining pybind11 objects with GIL held
+	ScopedGil gil(state->interpreter, &state->gil);
+	closeQueues(*state);
+	prefetch_buffer.clear();
+	running = RunningBatch();
+	batch_lists.clear();
+	if(profiler) finish_profile();
+	{
+		// A profile requested after the last batch resolves empty rather than broken
+		std::lock_guard<std::mutex> lock(state->profile_mutex);
+		if(state->profile_busy.load(std::memory_order_relaxed)) {
+			state->profile_busy.store(false, std::memory_order_release);
+			state->profile_result.set_value(std::string());
+		}
+	}
+	if(state->event_loop) {
+		state->event_loop.attr("close")();
+		state->event_loop = pybind11::object();
+	}
+}
+
+inline void PyManager::InvokeHandler::processWorkerLoop(std::shared_ptr<WorkerState> state,
+														size_t batch_size,
+														size_t prefetch_depth,
+														std::shared_ptr<std::atomic<bool>> active) {
+	struct InflightBatch {
+		std::vector<MoveOnlyFunction<void(pybind11::object)>> result_callbacks;
+		std::vector<MoveOnlyFunction<void(std::exception_ptr)>> error_callbacks;
+		std::chrono::steady_clock::time_point dispatched;
+		details::BatchTrace trace;
+	};
+
+	pinWorker(*state);
+	ProcessPool& pool = *state->process_pool;
+	details::FixedRing<CommittedEntry> prefetch_buffer(batch_size * prefetch_depth);
+	std::unordered_map<uint64_t, InflightBatch> inflight;
+	uint64_t next_batch_id = 1;
+
+	// A pickled batch that did not fit in any ring yet; retried before forming new batches.
+	std::optional<std::pair<pybind11::bytes, InflightBatch>> stalled;
+
+	pybind11::object dumps;
+	pybind11::object loads;
+	{
+		ScopedGil gil(nullptr, &state->gil);
+		pybind11::module_ pickle = pybind11::module_::import("pickle");
+		dumps = pickle.attr("dumps");
+		loads = pickle.attr("loads");
+	}
+
+	auto fail_all = [&state](InflightBatch& batch, std::exception_ptr eptr) {
+		for(size_t i = 0; i < batch.error_callbacks.size(); i++) {
+			try {
+				batch.error_callbacks[i](eptr);
+			} catch(...) {
+			}
+			batch.trace.callback_done(i);
+		}
+		state->total_completed.fetch_add(static_cast<std::int64_t>(batch.error_callbacks.size()),
+										 std::memory_order_relaxed);
+	};
+
+	auto submit = [&](pybind11::bytes& payload, InflightBatch& batch) -> bool {
+		char* data = nullptr;
+		Py_ssize_t size = 0;
+		PyBytes_AsStringAndSize(payload.ptr(), &data, &size);
+		if(!pool.try_submit(next_batch_id, data, static_cast<size_t>(size))) return false;
+		batch.dispatched = std::chrono::steady_clock::now();
+		batch.trace.execute(Tracer::Phase::kExecuteStart, batch.dispatched);
+		inflight.emplace(next_batch_id++, std::move(batch));
+		return true;
+	};
+
+	while(active->load() || state->queued() > 0 || !prefetch_buffer.empty() ||
+		  stalled || !inflight.empty()) {
+
+		const bool workers_lost = pool.live_workers() == 0;
+		const bool can_commit =
+			!prefetch_buffer.full() && state->queued() > 0;
+		const bool can_dispatch = (!prefetch_buffer.empty() || stalled) &&
+								  (workers_lost || (!stalled && pool.has_capacity()));
+
+		// Nothing to do until a worker answers: park on the doorbells, not the GIL
+		if(!can_commit && !can_dispatch) {
+			if(inflight.empty() && !stalled) {
+				state->idle_wait();
+				continue;
+			}
+			pool.wait(std::chrono::milliseconds(5));
+		}
+
+		{ // GIL scope
+			ScopedGil gil(nullptr, &state->gil);
+
+			// Phase 1: Refill prefetch buffer up to batch_size * prefetch_depth
+			commitPhase(*state, prefetch_buffer);
+
+			// Phase 3: Fan-out for every batch the workers have finished
+			pool.poll([&](uint64_t batch_id, ProcessPool::Status status, std::string_view payload) {
+				auto it = inflight.find(batch_id);
+				if(it == inflight.end()) return;
+				InflightBatch batch = std::move(it->second);
+				inflight.erase(it);
+
+				auto received = std::chrono::steady_clock::now();
+				batch.trace.execute(Tracer::Phase::kExecuteEnd, received);
+				if(status == ProcessPool::kOk) {
+					try {
+						pybind11::object results = loads(pybind11::memoryview::from_memory(
+							payload.data(), static_cast<ssize_t>(payload.size())));
+						for(size_t i = 0; i < batch.result_callbacks.size(); i++) {
+							try {
+								batch.result_callbacks[i](details::sequenceItem(results, i));
+							} catch(...) {
+							}
+							batch.trace.callback_done(i);
+						}
+						state->total_completed.fetch_add(
+							static_cast<std::int64_t>(batch.result_callbacks.size()),
+							std::memory_order_relaxed);
+					} catch(...) {
+						fail_all(batch, std::current_exception());
+					}
+				} else {
+					fail_all(batch,
+							 std::make_exception_ptr(std::runtime_error(std::string(payload))));
+				}
+
+				auto finished = std::chrono::steady_clock::now();
+				state->record_execute(
+					batch.result_callbacks.size(),
+					static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+											finished - batch.dispatched)
+											.count()));
+				state->record_batch(batch.result_callbacks.size(),
+									details::elapsedNs(batch.dispatched, received),
+									details::elapsedNs(received, finished));
+				if(state->batch_hook) state->batch_hook(batch.result_callbacks.size());
+			});
+
+			// Phase 2: Pickle batches and hand them to the least-loaded worker
+			if(stalled) {
+				if(pool.live_workers() == 0) {
+					fail_all(stalled->second,
+							 std::make_exception_ptr(
+								 std::runtime_error("All worker processes have exited")));
+					stalled.reset();
+				} else if(submit(stalled->first, stalled->second)) {
+					stalled.reset();
+				}
+			}
+
+			while(!stalled && !prefetch_buffer.empty() &&
+				  (pool.has_capacity() || pool.live_workers() == 0)) {
+				size_t batch_target = selectBatch(*state, prefetch_buffer, batch_size);
+				pybind11::list batch;
+				InflightBatch pending;
+				pending.result_callbacks.reserve(batch_target);
+				pending.error_callbacks.reserve(batch_target);
+				pending.trace.begin(state->id, batch_target);
+				auto batch_start = std::chrono::steady_clock::now();
+				std::chrono::steady_clock::time_point last_taken;
+				for(size_t i = 0; i < batch_target; i++) {
+					CommittedEntry& entry = prefetch_buffer.front();
+					state->histograms.hold_ns.record(
+						details::elapsedNs(entry.committed, batch_start));
+					pending.trace.add(entry.trace_id, batch_start);
+					last_taken = entry.enqueued;
+					batch.append(std::move(entry.committed_obj));
+					pending.result_callbacks.push_back(std::move(entry.on_result));
+					pending.error_callbacks.push_back(std::move(entry.on_error));
+					prefetch_buffer.pop_front();
+				}
+				state->execute_queue_size.store(prefetch_buffer.size(),
+												std::memory_order_relaxed);
+				state->publish_oldest(prefetch_buffer, last_taken);
+
+				if(pool.live_workers() == 0) {
+					fail_all(pending,
+							 std::make_exception_ptr(
+								 std::runtime_error("All worker processes have exited")));
+					continue;
+				}
+
+				pybind11::bytes payload;
+				try {
+					payload = dumps(batch, -1).cast<pybind11::bytes>();
+					if(!pool.fits(static_cast<size_t>(PyBytes_GET_SIZE(payload.ptr())))) {
+						throw std::length_error("Pickled batch exceeds worker_ring_bytes");
+					}
+				} catch(...) {
+					fail_all(pending, std::current_exception());
+					continue;
+				}
+
+				if(!submit(payload, pending)) {
+					stalled.emplace(std::move(payload), std::move(pending));
+				}
+			}
+		} // GIL released
+	}
+
+	// Clean up any remaining pybind11 objects with GIL held
+	ScopedGil gil(nullptr, &state->gil);
+	closeQueues(*state);
+	prefetch_buffer.clear();
+	stalled.reset();
+	dumps = pybind11::object();
+	loads = pybind11::object();
+}
+
+namespace details {
+/// @brief Renders and clears the pending Python exception. Requires the GIL.
+inline std::string takePythonError() {
+	PyObject *type = nullptr, *value = nullptr, *traceback = nullptr;
+	PyErr_Fetch(&type, &value, &traceback);
+	PyErr_NormalizeException(&type, &value, &traceback);
+	std::string message = "unknown error";
+	if(value != nullptr) {
+		if(PyObject* text = PyObject_Str(value)) {
+			if(const char* utf8 = PyUnicode_AsUTF8(text)) message = utf8;
+			Py_DECREF(text);
+		}
+	}
+	Py_XDECREF(type);
+	Py_XDECREF(value);
+	Py_XDECREF(traceback);
+	PyErr_Clear();
+	return message;
+}
+} // namespace details
+
+inline void PyManager::InvokeHandler::isolatedWorkerMain(std::shared_ptr<WorkerState> state,
+														 SubinterpreterSpec spec,
+														 size_t batch_size,
+														 size_t prefetch_depth,
+														 std::shared_ptr<std::atomic<bool>> active,
+														 std::promise<void> ready) {
+#if PY_VERSION_HEX >= 0x030C0000
+	pinWorker(*state);
+
+	// Py_NewInterpreterFromConfig must be entered from an attached thread state. Borrow a
+	// main-interpreter one for this thread; creating an OWN_GIL interpreter releases the
+	// main GIL and leaves the new interpreter's GIL held.
+	PyThreadState* main_tstate = PyThreadState_New(PyInterpreterState_Main());
+	PyEval_RestoreThread(main_tstate);
+
+	PyInterpreterConfig config{};
+	config.use_main_obmalloc = 0;
+	config.allow_fork = 0;
+	config.allow_exec = 0;
+	config.allow_threads = 1;
+	config.allow_daemon_threads = 0;
+	config.check_multi_interp_extensions = 1;
+	config.gil = PyInterpreterConfig_OWN_GIL;
+
+	PyThreadState* tstate = nullptr;
+	PyStatus status = Py_NewInterpreterFromConfig(&tstate, &config);
+	if(PyStatus_Exception(status)) {
+		PyThreadState_Clear(main_tstate);
+		PyThreadState_DeleteCurrent();
+		ready.set_exception(std::make_exception_ptr(
+			std::runtime_error(std::string("Could not create subinterpreter: ") +
+							   (status.err_msg != nullptr ? status.err_msg : "unknown error"))));
+		return;
+	}
+
+	PyInterpreterState* interp = PyThreadState_GetInterpreter(tstate);
+	{
+		std::lock_guard<std::mutex> lock(shared().subinterpreter_mutex);
+		shared().subinterpreters.insert(interp);
+	}
+
+	std::shared_ptr<pybind11::object> resource;
+	std::exception_ptr setup_error;
+
+	PyObject* sys_path = PySys_GetObject("path"); // borrowed
+	for(const std::string& directory : spec.sys_path) {
+		PyObject* entry = PyUnicode_FromString(directory.c_str());
+		if(entry == nullptr) break;
+		if(sys_path != nullptr && PySequence_Contains(sys_path, entry) == 0) {
+			(void)PyList_Append(sys_path, entry);
+		}
+		Py_DECREF(entry);
+	}
+	PyErr_Clear();
+
+	PyObject* module = PyImport_ImportModule(spec.module_name.c_str());
+	PyObject* callable =
+		module != nullptr ? PyObject_GetAttrString(module, spec.entry_point.c_str()) : nullptr;
+	Py_XDECREF(module);
+	if(callable == nullptr) {
+		setup_error = std::make_exception_ptr(
+			std::invalid_argument("Could not load '" + spec.entry_point + "' from module '" +
+								  spec.module_name + "' in subinterpreter: " +
+								  details::takePythonError()));
+	} else {
+		resource = std::make_shared<pybind11::object>(
+			pybind11::reinterpret_steal<pybind11::object>(callable));
+	}
+	(void)PyEval_SaveThread();
+
+	// Return the borrowed main thread state.
+	PyEval_RestoreThread(main_tstate);
+	PyThreadState_Clear(main_tstate);
+	PyThreadState_DeleteCurrent();
+
+	auto end_interpreter = [&] {
+		PyEval_RestoreThread(tstate);
+		resource.reset();
+		Py_EndInterpreter(tstate);
+		std::lock_guard<std::mutex> lock(shared().subinterpreter_mutex);
+		shared().subinterpreters.erase(interp);
+	};
+
+	if(setup_error) {
+		end_interpreter();
+		ready.set_exception(setup_error);
+		return;
+	}
+
+	state->interpreter = tstate;
+	ready.set_value();
+
+	workerLoop(state, resource, batch_size, prefetch_depth, std::move(active));
+
+	state->interpreter = nullptr;
+	end_interpreter();
+#else
+	(void)state;
+	(void)spec;
+	(void)batch_size;
+	(void)prefetch_depth;
+	(void)active;
+	ready.set_exception(std::make_exception_ptr(
+		std::runtime_error("Per-interpreter GIL subinterpreters require Python 3.12 or newer")));
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Impl ReplicatedHandler
+///////////////////////////////////////////////////////////////////////////////
+
+inline PyManager::ReplicatedHandler::ReplicatedHandler(std::vector<InvokeHandler> replicas)
+	: _replicas(std::move(replicas))
+	, _next(std::make_unique<std::atomic<size_t>>(0)) {}
+
+template <typename CommitFn, typename Callback, typename... Args>
+auto PyManager::ReplicatedHandler::queue_invoke(CommitFn&& commit_fn,
+												Callback&& callback,
+												Args&&... args)
+	-> std::future<std::invoke_result_t<Callback, pybind11::object>> {
+	return pickReplica().queue_invoke(std::forward<CommitFn>(commit_fn),
+									  std::forward<Callback>(callback),
+									  std::forward<Args>(args)...);
+}
+
+inline PyManager::InvokeHandler& PyManager::ReplicatedHandler::pickReplica() {
+	const size_t start = _next->fetch_add(1, std::memory_order_relaxed) % _replicas.size();
+	size_t best = start;
+	size_t best_outstanding = _replicas[start].outstanding();
+	for(size_t i = 1; i < _replicas.size() && best_outstanding > 0; i++) {
+		size_t index = (start + i) % _replicas.size();
+		size_t outstanding = _replicas[index].outstanding();
+		if(outstanding < best_outstanding) {
+			best = index;
+			best_outstanding = outstanding;
+		}
+	}
+	return _replicas[best];
+}
+
+inline size_t PyManager::ReplicatedHandler::size() const {
+	return _replicas.size();
+}
+
+inline PyManager::InvokeHandler& PyManager::ReplicatedHandler::replica(size_t index) {
+	return _replicas.at(index);
+}
+
+inline const PyManager::InvokeHandler&
+PyManager::ReplicatedHandler::replica(size_t index) const {
+	return _replicas.at(index);
+}
+
+inline std::vector<PyManager::InvokeHandler::QueueStats>
+PyManager::ReplicatedHandler::get_replica_stats() const {
+	std::vector<InvokeHandler::QueueStats> stats;
+	stats.reserve(_replicas.size());
+	for(const InvokeHandler& handler : _replicas) {
+		stats.push_back(handler.get_queue_stats());
+	}
+	return stats;
+}
+
+inline PyManager::InvokeHandler::QueueStats PyManager::ReplicatedHandler::get_queue_stats() const {
+	InvokeHandler::QueueStats total;
+	for(const InvokeHandler::QueueStats& stats : get_replica_stats()) {
+		total.commit_queue_size += stats.commit_queue_size;
+		total.execute_queue_size += stats.execute_queue_size;
+		total.total_enqueued += stats.total_enqueued;
+		total.total_completed += stats.total_completed;
+		total.bisected_batches += stats.bisected_batches;
+		total.bisect_retries += stats.bisect_retries;
+		total.bisect_python_ns += stats.bisect_python_ns;
+		total.bisect_failed_items += stats.bisect_failed_items;
+		total.commit_batch_size_ema += stats.commit_batch_size_ema;
+		total.execute_batch_size_ema += stats.execute_batch_size_ema;
+		total.commit_ns_per_batch_ema += stats.commit_ns_per_batch_ema;
+		total.execute_ns_per_batch_ema += stats.execute_ns_per_batch_ema;
+	}
+	const auto replicas = static_cast<double>(_replicas.size());
+	total.commit_batch_size_ema /= replicas;
+	total.execute_batch_size_ema /= replicas;
+	total.commit_ns_per_batch_ema /= replicas;
+	total.execute_ns_per_batch_ema /= replicas;
+	return total;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Impl SharedHandler
+///////////////////////////////////////////////////////////////////////////////
+
+inline PyManager::SharedHandler::SharedHandler(std::shared_ptr<InvokeHandler> handler)
+	: _handler(std::move(handler)) {}
+
+inline PyManager::InvokeHandler& PyManager::SharedHandler::operator*() const {
+	return *_handler;
+}
+
+inline PyManager::InvokeHandler* PyManager::SharedHandler::operator->() const {
+	return _handler.get();
+}
+
+inline long PyManager::SharedHandler::use_count() const {
+	return _handler.use_count();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Impl PyManager
+///////////////////////////////////////////////////////////////////////////////
+
+namespace details {
+/// @brief Fills config from options; clears config and throws std::runtime_error on failure.
+inline void initPyConfig(PyConfig& config, const PyManager::StartupOptions& options) {
+	if(options.isolated) {
+		PyConfig_InitIsolatedConfig(&config);
+	} else {
+		PyConfig_InitPythonConfig(&config);
+	}
+	// Do not register python signal handlers
+	// https://docs.python.org/3/c-api/init_config.html#c.PyConfig.install_signal_handlers
+	config.install_signal_handlers = 0;
+	config.site_import = options.skip_site ? 0 : 1;
+	config.optimization_level = options.optimization_level;
+	if(options.hash_seed) {
+		config.use_hash_seed = 1;
+		config.hash_seed = *options.hash_seed;
+	}
+
+	auto check = [&config](PyStatus status) {
+		if(PyStatus_Exception(status)) {
+			PyConfig_Clear(&config);
+			throw std::runtime_error(status.err_msg != nullptr ? status.err_msg
+															   : "Invalid interpreter config");
+		}
+	};
+	if(!options.module_search_paths.empty()) {
+		config.module_search_paths_set = 1;
+		for(const std::string& path : options.module_search_paths) {
+			wchar_t* wide = Py_DecodeLocale(path.c_str(), nullptr);
+			if(wide == nullptr) {
+				PyConfig_Clear(&config);
+				throw std::runtime_error("Could not decode module search path: " + path);
+			}
+			PyStatus status = PyWideStringList_Append(&config.module_search_paths, wide);
+			PyMem_RawFree(wide);
+			check(status);
+		}
+	}
+}
+} // namespace details
+
+PyManager::PyManager()
+	: PyManager(StartupOptions{ }) {}
+
+PyManager::PyManager(const StartupOptions& options) {
+	// Waits on the interpreter thread's promise rather than spinning
+	start_interpreter(options).get();
+	shared().arc.fetch_add(1, std::memory_order_acq_rel);
+}
+
+std::shared_future<void> PyManager::start_interpreter(const StartupOptions& options) {
+	// The Python interpreter is initialized exactly once per process and the
+	// owning thread is parked forever. This keeps a valid PyThreadState alive
+	// for the lifetime of the process so that static destructors in libraries
+	// such as libtorch_python (which decref Python objects at exit) can safely
+	// acquire the GIL.
+	std::call_once(shared().init_flag, [&options] {
+		shared().interpreter_ready = shared().interpreter_promise.get_future().share();
+		std::thread([options] { PyManager::mainLoop(options); }).detach();
+
+		// Release any cached pybind11 handles before static destructors run,
+		// so dec_ref happens with the GIL held.
+		std::atexit([] {
+			if(!shared().interpreter_initialized.load(std::memory_order_acquire)) return;
+			pybind11::gil_scoped_acquire gil;
+			shared().py_invoke_handler_map.clear();
+		});
+	});
+	if(options.preimport.empty()) return shared().interpreter_ready;
+
+	// Preimports are queued to the interpreter thread and run after the one-time boot, so a
+	// failing import fails only this call: the interpreter stays ready for every other
+	// PyManager and the call can be retried.
+	InterpreterJobs& jobs = *shared().interpreter_jobs;
+	std::promise<void> done;
+	std::shared_future<void> imported = done.get_future().share();
+	{
+		std::lock_guard<std::mutex> lock(jobs.mutex);
+		// The interpreter failed to start: report that instead
+		if(jobs.closed) return shared().interpreter_ready;
+		jobs.preimports.emplace_back(options.preimport, std::move(done));
+	}
+	jobs.wake.notify_one();
+	return imported;
+}
+
+std::shared_future<void> PyManager::start_interpreter() {
+	return start_interpreter(StartupOptions{ });
+}
+
+std::future<std::unique_ptr<PyManager>> PyManager::create_async(const StartupOptions& options) {
+	std::shared_future<void> ready = start_interpreter(options);
+	return std::async(std::launch::async, [ready] {
+		ready.get();
+		return std::make_unique<PyManager>();
+	});
+}
+
+std::future<std::unique_ptr<PyManager>> PyManager::create_async() {
+	return create_async(StartupOptions{ });
+}
+
+PyManager::~PyManager() {
+	shared().arc.fetch_sub(1, std::memory_order_acq_rel);
+	// Interpreter is intentionally not finalized; see PyManager() for rationale.
+}
+
+PyManager::InvokeHandler PyManager::loadPythonModule(const std::string& module_name,
+													 const std::string& entry_point,
+													 size_t batch_size,
+													 size_t prefetch_depth) {
+	HandlerOptions options;
+	options.batch_size = batch_size;
+	options.prefetch_depth = prefetch_depth;
+	return loadPythonModule(module_name, entry_point, options);
+}
+
+PyManager::InvokeHandler PyManager::loadPythonModule(const std::string& module_name,
+													 const std::string& entry_point,
+													 const HandlerOptions& handler_options) {
+
+	if(!shared().interpreter_initialized) {
+		throw std::runtime_error("Python interpreter not initialized");
+	}
+
+	HandlerOptions options = handler_options;
+	if(options.name.empty()) {
+		options.name = module_name + "." + entry_point;
+	}
+
+	if(options.isolated_interpreter && options.worker_processes > 0) {
+		throw std::invalid_argument(
+			"isolated_interpreter and worker_processes cannot be combined on one handler");
+	}
+	const bool has_warmup = !options.warmup_function.empty() || options.warmup_batch;
+	if(has_warmup && options.worker_processes > 0) {
+		throw std::invalid_argument("Warmup is not supported on out-of-process handlers");
+	}
+	if(options.bisect_failed_batches && options.worker_processes > 0) {
+		throw std::invalid_argument("Batch bisection is not supported on out-of-process handlers");
+	}
+	if(options.max_inflight_batches > 1 && options.worker_processes > 0) {
+		throw std::invalid_argument(
+			"max_inflight_batches is not supported on out-of-process handlers");
+	}
+	if(std::find(options.warmup_batch_sizes.begin(), options.warmup_batch_sizes.end(), 0) !=
+	   options.warmup_batch_sizes.end()) {
+		throw std::invalid_argument("warmup_batch_sizes must be positive");
+	}
+	if(options.max_inflight_batches == 0) {
+		throw std::invalid_argument("max_inflight_batches must be positive");
+	}
+	(void)resolveAffinityCpus(options.worker_affinity);
+
+	if(options.isolated_interpreter) {
+#if PY_VERSION_HEX < 0x030C0000
+		throw std::runtime_error("Per-interpreter GIL subinterpreters require Python 3.12 or newer");
+#else
+		InvokeHandler::SubinterpreterSpec spec{ module_name, entry_point, { } };
+		{
+			InvokeHandler::ScopedGil gil(nullptr);
+			spec.sys_path = sysPathSnapshot();
+		}
+		// The module is imported by the worker inside its own interpreter; the GIL must
+		// not be held here because creating the subinterpreter needs it.
+		return PyManager::InvokeHandler(0,
+										std::make_shared<pybind11::object>(),
+										std::make_unique<PyManager>(),
+										options,
+										module_name,
+										std::move(spec));
+#endif
+	}
+
+	std::shared_ptr<pybind11::object> callable;
+	size_t id = 0;
+	ProcessPool::Options pool_options;
+	{
+		InvokeHandler::ScopedGil gil(nullptr);
+
+		std::tie(callable, id) = resolveEntryPoint(module_name, entry_point);
+		checkWarmupFunction(module_name, options);
+
+		if(options.worker_processes > 0) {
+			pool_options.sys_path = sysPathSnapshot();
+			pool_options.python_executable = options.worker_python;
+			if(pool_options.python_executable.empty()) {
+				pool_options.python_executable =
+					pybind11::module_::import("sys").attr("executable").cast<std::string>();
+			}
+			if(pool_options.python_executable.empty()) {
+				throw std::invalid_argument(
+					"sys.executable is empty; set worker_python for worker_processes");
+			}
+		}
+	}
+
+	std::unique_ptr<ProcessPool> pool;
+	if(options.worker_processes > 0) {
+		// Spawned without the GIL: workers may take a while to import heavy modules.
+		pool_options.module_name = module_name;
+		pool_options.entry_point = entry_point;
+		pool_options.processes = options.worker_processes;
+		pool_options.ring_bytes = options.worker_ring_bytes;
+		pool_options.python_version =
+			std::to_string(PY_MAJOR_VERSION) + "." + std::to_string(PY_MINOR_VERSION);
+		pool = std::make_unique<ProcessPool>(pool_options);
+	}
+
+	return PyManager::InvokeHandler(id,
+									callable,
+									std::make_unique<PyManager>(),
+									options,
+									module_name,
+									std::nullopt,
+									std::move(pool));
+}
+
+namespace details {
+/// @brief Python callable running a batch through pipeline stages, re-chunking the items
+/// to each stage's batch size (0: all at once).
+/// @param named_stages "module.entry_point" and callable of each stage, for error messages.
+inline pybind11::object
+makePipeline(std::vector<std::pair<std::string, pybind11::object>> named_stages,
+			 std::vector<size_t> batch_sizes) {
+	return pybind11::cpp_function(
+		[stages = std::move(named_stages),
+		 sizes = std::move(batch_sizes)](const pybind11::object& batch) -> pybind11::object {
+			pybind11::list items(batch);
+			for(size_t s = 0; s < stages.size(); s++) {
+				const auto& [name, stage] = stages[s];
+				const size_t count = items.size();
+				const size_t step = sizes[s] == 0 ? std::max<size_t>(count, 1) : sizes[s];
+				pybind11::list outputs;
+				for(size_t begin = 0; begin < count; begin += step) {
+					const size_t end = std::min(count, begin + step);
+					pybind11::list chunk = begin == 0 && end == count
+											   ? items
+											   : pybind11::reinterpret_steal<pybind11::list>(
+													 PyList_GetSlice(items.ptr(),
+																	 static_cast<Py_ssize_t>(begin),
+																	 static_cast<Py_ssize_t>(end)));
+					pybind11::list results(stage(chunk));
+					if(results.size() != end - begin) {
+						throw pybind11::value_error("Pipeline stage " + name + " returned " +
+													std::to_string(results.size()) +
+													" results for " + std::to_string(end - begin) +
+													" inputs");
+					}
+					if(begin == 0 && end == count) {
+						outputs = std::move(results);
+					} else {
+						for(auto result : results) {
+							outputs.append(result);
+						}
+					}
+				}
+				items = std::move(outputs);
+			}
+			return items;
+		});
+}
+} // namespace details
+
+PyManager::InvokeHandler PyManager::loadPipeline(const std::vector<PipelineStage>& stages) {
+	return loadPipeline(stages, HandlerOptions{ });
+}
+
+PyManager::InvokeHandler PyManager::loadPipeline(const std::vector<PipelineStage>& stages,
+												 const HandlerOptions& handler_options) {
+	if(!shared().interpreter_initialized) {
+		throw std::runtime_error("Python interpreter not initialized");
+	}
+	if(stages.empty()) {
+		throw std::invalid_argument("A pipeline needs at least one stage");
+	}
+	if(handler_options.isolated_interpreter || handler_options.worker_processes > 0) {
+		throw std::invalid_argument(
+			"Pipelines cannot run in isolated interpreters or worker processes");
+	}
+
+	HandlerOptions options = handler_options;
+	std::vector<size_t> batch_sizes;
+	std::string default_name;
+	for(const PipelineStage& stage : stages) {
+		options.batch_size = std::max(options.batch_size, stage.batch_size);
+		batch_sizes.push_back(stage.batch_size);
+		if(!default_name.empty()) default_name += "->";
+		default_name += stage.module_name + "." + stage.entry_point;
+	}
+	if(options.name.empty()) {
+		options.name = default_name;
+	}
+	if(std::find(options.warmup_batch_sizes.begin(), options.warmup_batch_sizes.end(), 0) !=
+	   options.warmup_batch_sizes.end()) {
+		throw std::invalid_argument("warmup_batch_sizes must be positive");
+	}
+	if(options.max_inflight_batches == 0) {
+		throw std::invalid_argument("max_inflight_batches must be positive");
+	}
+	(void)resolveAffinityCpus(options.worker_affinity);
+
+	std::shared_ptr<pybind11::object> pipeline;
+	{
+		InvokeHandler::ScopedGil gil(nullptr);
+		std::vector<std::pair<std::string, pybind11::object>> resolved;
+		for(const PipelineStage& stage : stages) {
+			resolved.emplace_back(stage.module_name + "." + stage.entry_point,
+								  *resolveEntryPoint(stage.module_name, stage.entry_point).first);
+		}
+		checkWarmupFunction(stages.front().module_name, options);
+		pipeline = std::make_shared<pybind11::object>(
+			details::makePipeline(std::move(resolved), std::move(batch_sizes)));
+	}
+
+	return PyManager::InvokeHandler(
+		0, pipeline, std::make_unique<PyManager>(), options, stages.front().module_name);
+}
+
+PyManager::ReplicatedHandler PyManager::loadReplicated(const std::string& module_name,
+													   const std::string& entry_point,
+													   size_t replicas) {
+	return loadReplicated(module_name, entry_point, replicas, HandlerOptions{ });
+}
+
+PyManager::ReplicatedHandler PyManager::loadReplicated(const std::string& module_name,
+													   const std::string& entry_point,
+													   size_t replicas,
+													   const HandlerOptions& options) {
+	if(replicas == 0) {
+		throw std::invalid_argument("A replicated handler needs at least one replica");
+	}
+	const std::string name =
+		options.name.empty() ? module_name + "." + entry_point : options.name;
+
+	// The entry point cache hands every replica the same callable
+	std::vector<InvokeHandler> handlers;
+	handlers.reserve(replicas);
+	for(size_t i = 0; i < replicas; i++) {
+		HandlerOptions replica_options = options;
+		replica_options.name = name + "[" + std::to_string(i) + "]";
+		handlers.push_back(loadPythonModule(module_name, entry_point, replica_options));
+	}
+	return ReplicatedHandler(std::move(handlers));
+}
+
+PyManager::SharedHandler PyManager::loadShared(const std::string& module_name,
+											   const std::string& entry_point,
+											   size_t batch_size,
+											   size_t prefetch_depth) {
+	HandlerOptions options;
+	options.batch_size = batch_size;
+	options.prefetch_depth = prefetch_depth;
+	return loadShared(module_name, entry_point, options);
+}
+
+PyManager::SharedHandler PyManager::loadShared(const std::string& module_name,
+											   const std::string& entry_point,
+											   const HandlerOptions& options) {
+	using Slot = std::shared_future<std::weak_ptr<InvokeHandler>>;
+	auto ready = [](const Slot& slot) {
+		return slot.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	};
+	const std::string key = sharedHandlerKey(module_name, entry_point, options);
+
+	while(true) {
+		// The registry lock is never held while loading: a caller that holds the GIL could
+		// otherwise wait on it while the loader waits for the GIL.
+		Slot loading;
+		std::promise<std::weak_ptr<InvokeHandler>> loaded;
+		{
+			std::lock_guard<std::mutex> lock(shared().shared_handlers_mutex);
+			auto& handlers = shared().shared_handlers;
+			if(auto it = handlers.find(key); it != handlers.end()) {
+				if(!ready(it->second)) {
+					loading = it->second;
+				} else if(std::shared_ptr<InvokeHandler> handler = it->second.get().lock()) {
+					return SharedHandler(std::move(handler));
+				}
+			}
+			if(!loading.valid()) {
+				for(auto it = handlers.begin(); it != handlers.end();) {
+					if(ready(it->second) && it->second.get().expired()) {
+						it = handlers.erase(it);
+					} else {
+						++it;
+					}
+				}
+				// Concurrent first uses wait on this slot, so a single handler is created
+				handlers[key] = loaded.get_future().share();
+			}
+		}
+
+		if(loading.valid()) {
+			// The loader needs the GIL to import
+			if(PyGILState_Check()) {
+				pybind11::gil_scoped_release release;
+				loading.wait();
+			} else {
+				loading.wait();
+			}
+			continue;
+		}
+
+		try {
+			auto handler = std::make_shared<InvokeHandler>(
+				loadPythonModule(module_name, entry_point, options));
+			loaded.set_value(handler);
+			return SharedHandler(std::move(handler));
+		} catch(...) {
+			// Leaves an expired slot: waiting callers retry the load themselves
+			loaded.set_value({ });
+			throw;
+		}
+	}
+}
+
+std::string PyManager::sharedHandlerKey(const std::string& module_name,
+										const std::string& entry_point,
+										const HandlerOptions& options) {
+	// Every field is length-prefixed, so free-form strings cannot run into the next field
+	std::string key;
+	auto field = [&key](const auto& value) {
+		std::string text;
+		if constexpr(std::is_convertible_v<decltype(value), std::string>) {
+			text = value;
+		} else {
+			text = std::to_string(value);
+		}
+		key += std::to_string(text.size());
+		key += ':';
+		key += text;
+	};
+	field(module_name);
+	field(entry_point);
+	field(options.name);
+	field(options.batch_size);
+	field(options.prefetch_depth);
+	field(options.isolated_interpreter);
+	field(options.worker_processes);
+	field(options.worker_ring_bytes);
+	field(options.worker_python);
+	field(options.max_inflight_batches);
+	field(options.bisect_failed_batches);
+	field(options.invoke_via_worker);
+	field(options.worker_affinity.numa_node);
+	field(options.worker_affinity.numa_local_memory);
+	field(options.worker_affinity.cpus.size());
+	for(int cpu : options.worker_affinity.cpus) {
+		field(cpu);
+	}
+	field(options.warmup_function);
+	field(options.warmup_batch_sizes.size());
+	for(size_t size : options.warmup_batch_sizes) {
+		field(size);
+	}
+	field(options.batch_key_max_wait.count());
+	// Callables cannot be compared, but whether one is set changes the handler's semantics
+	field(static_cast<bool>(options.batch_key));
+	field(static_cast<bool>(options.batch_hook));
+	field(static_cast<bool>(options.warmup_batch));
+	return key;
+}
+
+void PyManager::set_default_worker_affinity(const ThreadAffinity& affinity) {
+	(void)resolveAffinityCpus(affinity);
+	std::lock_guard<std::mutex> lock(shared().affinity_mutex);
+	shared().default_worker_affinity = affinity;
+}
+
+void PyManager::set_interpreter_affinity(const ThreadAffinity& affinity) {
+	if(!shared().interpreter_initialized.load(std::memory_order_acquire)) {
+		throw std::runtime_error("Python interpreter not initialized");
+	}
+	setThreadCpus(shared().interpreter_thread, resolveAffinityCpus(affinity));
+}
+
+void PyManager::add_path(const std::string& directory) {
+	if(directory.empty()) {
+		throw std::invalid_argument("Path cannot be empty");
+	}
+
+	if(!shared().interpreter_initialized) {
+		throw std::runtime_error("Python interpreter not initialized");
+	}
+
+	SharedState& state = shared();
+
+	InvokeHandler::ScopedGil gil(nullptr);
+
+	constexpr const char* kSysModule = "sys";
+	constexpr const char* kPathObjectKey = "__sys_path__";
+
+	auto module_it = state.py_invoke_handler_map.find(kSysModule);
 	if(module_it == state.py_invoke_handler_map.end()) {
 		pybind11::module_ mod;
 		try {
@@ -432,6 +2330,211 @@ void PyManager::add_path(const std::string& directory) {
 	sys_path.append(pybind11::str(directory));
 }
 
+inline std::pair<std::shared_ptr<pybind11::object>, size_t>
+PyManager::resolveEntryPoint(const std::string& module_name, const std::string& entry_point) {
+	SharedState& state = shared();
+
+	auto module_it = state.py_invoke_handler_map.find(module_name);
+	if(module_it == state.py_invoke_handler_map.end()) {
+		pybind11::module_ mod;
+		try {
+			mod = pybind11::module_::import(module_name.c_str());
+		} catch(pybind11::error_already_set& e) {
+			throw std::invalid_argument("Could not import module '" + module_name +
+										"': " + std::string(e.what()));
+		}
+
+		auto [inserted_it, successful] =
+			state.py_invoke_handler_map.emplace(module_name, PyInvokeHandlerEntry{ mod, { } });
+		module_it = inserted_it;
+	}
+
+	auto object_it = module_it->second.handler_map.find(entry_point);
+	if(object_it != module_it->second.handler_map.end()) {
+		return { object_it->second, 0 };
+	}
+
+	pybind11::object obj;
+	try {
+		obj = module_it->second.module_.attr(entry_point.c_str());
+	} catch(pybind11::error_already_set& e) {
+		throw std::invalid_argument("Could not find the '" + entry_point + "' method in module " +
+									module_name + ": " + std::string(e.what()));
+	}
+
+	auto callable = std::make_shared<pybind11::object>(obj);
+	auto [handler_it, handler_inserted] =
+		module_it->second.handler_map.emplace(entry_point, callable);
+	if(!handler_inserted) {
+		callable = handler_it->second;
+	}
+	return { callable, module_it->second.handler_map.size() - 1 };
+}
+
+inline void PyManager::checkWarmupFunction(const std::string& module_name,
+										   const HandlerOptions& options) {
+	if(options.warmup_function.empty()) return;
+	const pybind11::module_& mod = shared().py_invoke_handler_map.at(module_name).module_;
+	if(!pybind11::hasattr(mod, options.warmup_function.c_str())) {
+		throw std::invalid_argument("Could not find the warmup function '" +
+									options.warmup_function + "' in module " + module_name);
+	}
+}
+
+inline std::vector<std::string> PyManager::sysPathSnapshot() {
+	std::vector<std::string> paths;
+	pybind11::list sys_path = pybind11::module_::import("sys").attr("path").cast<pybind11::list>();
+	for(auto item : sys_path) {
+		paths.push_back(pybind11::str(item).cast<std::string>());
+	}
+	return paths;
+}
+
+MetricsSnapshot PyManager::metrics_snapshot() {
+	std::vector<std::shared_ptr<InvokeHandler::WorkerState>> states;
+	{
+		std::lock_guard<std::mutex> lock(shared().metrics_mutex);
+		for(const auto& weak : shared().handler_states) {
+			if(auto state = weak.lock()) states.push_back(std::move(state));
+		}
+	}
+
+	MetricsSnapshot snapshot;
+	snapshot.handlers.reserve(states.size());
+	for(const auto& state : states) {
+		snapshot.handlers.push_back(InvokeHandler::snapshotMetrics(*state));
+	}
+	return snapshot;
+}
+
+void PyManager::register_buffer(const std::string& name,
+								std::shared_ptr<const void> owner,
+								const void* data,
+								size_t size) {
+	std::lock_guard<std::mutex> lock(shared().buffers_mutex);
+	shared().buffers[name] = RegisteredBuffer{ std::move(owner), data, size };
+}
+
+template <typename Container>
+void PyManager::register_buffer(const std::string& name, std::shared_ptr<Container> container) {
+	const void* data = container->data();
+	const size_t size = container->size() * sizeof(*container->data());
+	register_buffer(name, std::shared_ptr<const void>(std::move(container)), data, size);
+}
+
+bool PyManager::unregister_buffer(const std::string& name) {
+	std::lock_guard<std::mutex> lock(shared().buffers_mutex);
+	return shared().buffers.erase(name) > 0;
+}
+
+namespace details {
+/// @brief Python exception object for a failed request. Requires the GIL.
+inline pybind11::object pythonException(std::exception_ptr error) {
+	try {
+		std::rethrow_exception(error);
+	} catch(pybind11::error_already_set& e) {
+		return e.value();
+	} catch(const std::exception& e) {
+		return pybind11::handle(PyExc_RuntimeError)(e.what());
+	} catch(...) {
+		return pybind11::handle(PyExc_RuntimeError)("Unknown error");
+	}
+}
+} // namespace details
+
+void PyManager::define_embedded_module(pybind11::module_& module) {
+	module.def(
+		"buffer",
+		[](const std::string& name) {
+			RegisteredBuffer buffer;
+			{
+				std::lock_guard<std::mutex> lock(shared().buffers_mutex);
+				auto it = shared().buffers.find(name);
+				if(it == shared().buffers.end()) {
+					throw pybind11::key_error("No buffer registered as " + name);
+				}
+				buffer = it->second;
+			}
+			// The view owns a reference to the registration's owner, not a copy of its bytes
+			struct Borrowed {
+				std::shared_ptr<const void> owner;
+				const char* bytes;
+				size_t length;
+				const char* data() const {
+					return bytes;
+				}
+				size_t size() const {
+					return length;
+				}
+			};
+			return makeBytesView(Borrowed{
+				std::move(buffer.owner), static_cast<const char*>(buffer.data), buffer.size });
+		},
+		pybind11::arg("name"));
+
+	module.def("buffer_names", [] {
+		std::vector<std::string> names;
+		std::lock_guard<std::mutex> lock(shared().buffers_mutex);
+		for(const auto& [name, buffer] : shared().buffers) {
+			names.push_back(name);
+		}
+		return names;
+	});
+
+	module.def(
+		"submit",
+		[](const std::string& handler_name, pybind11::object obj) {
+			std::shared_ptr<InvokeHandler::WorkerState> target;
+			{
+				std::lock_guard<std::mutex> lock(shared().metrics_mutex);
+				std::int64_t least = 0;
+				for(const auto& weak : shared().handler_states) {
+					auto state = weak.lock();
+					if(!state || state->name != handler_name || !state->active->load()) continue;
+					const std::int64_t outstanding =
+						state->total_enqueued.load(std::memory_order_relaxed) -
+						state->total_completed.load(std::memory_order_relaxed);
+					if(!target || outstanding < least) {
+						target = std::move(state);
+						least = outstanding;
+					}
+				}
+			}
+			if(!target) {
+				throw pybind11::key_error("No running handler named " + handler_name);
+			}
+			if(target->isolated) {
+				throw pybind11::value_error("Cannot submit to isolated handler " + handler_name);
+			}
+
+			pybind11::object future =
+				pybind11::module_::import("concurrent.futures").attr("Future")();
+			// Runs on the target's worker, which holds the GIL for commit and fan-out
+			InvokeHandler::QueueEntry entry;
+			entry.commit = [obj = std::move(obj)]() mutable { return std::move(obj); };
+			entry.on_result = [future](pybind11::object result) {
+				future.attr("set_result")(std::move(result));
+			};
+			entry.on_error = [future](std::exception_ptr error) {
+				future.attr("set_exception")(details::pythonException(error));
+			};
+			{
+				// The worker closes its queues under this lock, so the entry either lands
+				// before its final drain or is failed here
+				std::lock_guard<std::mutex> lock(target->submit_mutex);
+				if(!target->closed) {
+					InvokeHandler::submitTo(*target, std::move(entry));
+					return future;
+				}
+			}
+			entry.on_error(std::make_exception_ptr(
+				std::runtime_error("Handler " + handler_name + " shut down")));
+			return future;
+		},
+		pybind11::arg("handler_name"),
+		pybind11::arg("obj"));
+}
+
 uintptr_t PyManager::debug_shared_state_address() {
 	return reinterpret_cast<uintptr_t>(&shared());
 }
@@ -440,28 +2543,95 @@ uint64_t PyManager::debug_arc_count() {
 	return shared().arc.load();
 }
 
-void PyManager::mainLoop() {
-	// Do not register python signal handlers
-	// https://docs.python.org/3/c-api/init.html#c.Py_InitializeEx
-	pybind11::initialize_interpreter(false);
+size_t PyManager::debug_subinterpreter_count() {
+	std::lock_guard<std::mutex> lock(shared().subinterpreter_mutex);
+	return shared().subinterpreters.size();
+}
 
-	pybind11::module_ sys = pybind11::module_::import("sys");
-	(void)pybind11::module_::import("atexit");
+void PyManager::preimportModules(const std::vector<std::string>& modules) {
+	for(const std::string& module_name : modules) {
+		try {
+			(void)pybind11::module_::import(module_name.c_str());
+		} catch(pybind11::error_already_set& e) {
+			throw std::runtime_error("Could not preimport module " + module_name + ": " +
+									 e.what());
+		}
+	}
+}
 
-	pybind11::list(sys.attr("path")).append(".");
+void PyManager::mainLoop(const StartupOptions& options) {
+	// Held here so the queue outlives SharedState's static destruction at exit
+	std::shared_ptr<InterpreterJobs> jobs = shared().interpreter_jobs;
+	// Fails queued preimports with the startup error and refuses later ones
+	auto close_jobs = [&jobs](std::exception_ptr error) {
+		std::lock_guard<std::mutex> lock(jobs->mutex);
+		jobs->closed = true;
+		for(auto& request : jobs->preimports) {
+			request.second.set_exception(error);
+		}
+		jobs->preimports.clear();
+	};
+
+	try {
+		PyConfig config;
+		details::initPyConfig(config, options);
+		// Clears config itself when it throws
+		pybind11::initialize_interpreter(&config, 0, nullptr, false);
+		PyConfig_Clear(&config);
+	} catch(...) {
+		// No interpreter: nothing to keep this thread around for
+		shared().interpreter_promise.set_exception(std::current_exception());
+		close_jobs(std::current_exception());
+		return;
+	}
+
+	std::exception_ptr startup_error;
+	try {
+		pybind11::module_ sys = pybind11::module_::import("sys");
+		(void)pybind11::module_::import("atexit");
+		// Embedded module registered by src/pyscheduler_state.cpp
+		(void)pybind11::module_::import("pyscheduler");
+
+		if(options.module_search_paths.empty()) {
+			pybind11::list(sys.attr("path")).append(".");
+		}
+	} catch(...) {
+		startup_error = std::current_exception();
+	}
 
 	// Release the GIL so InvokeHandler worker threads (and any other thread
 	// that calls into Python via pybind11::gil_scoped_acquire) can acquire it.
 	// The PyThreadState owned by this thread remains valid for the lifetime of
 	// the process; we never let this function return.
-	(void)PyEval_SaveThread();
-
-	shared().interpreter_initialized.store(true, std::memory_order_release);
+	PyThreadState* tstate = PyEval_SaveThread();
+
+	shared().interpreter_thread = pthread_self();
+	if(startup_error) {
+		shared().interpreter_promise.set_exception(startup_error);
+		close_jobs(startup_error);
+	} else {
+		shared().interpreter_initialized.store(true, std::memory_order_release);
+		shared().interpreter_promise.set_value();
+	}
 
-	// Park forever. The OS reaps this thread at process exit. Keeping it alive
-	// preserves a valid Python thread state for static destructors that decref
-	// Python objects (e.g. libtorch_python).
-	std::promise<void> never;
-	never.get_future().wait();
+	// Park forever, waking only to run preimport requests. The OS reaps this thread at
+	// process exit. Keeping it alive preserves a valid Python thread state for static
+	// destructors that decref Python objects (e.g. libtorch_python).
+	while(true) {
+		std::unique_lock<std::mutex> lock(jobs->mutex);
+		jobs->wake.wait(lock, [&jobs] { return !jobs->preimports.empty(); });
+		auto [modules, done] = std::move(jobs->preimports.front());
+		jobs->preimports.pop_front();
+		lock.unlock();
+
+		PyEval_RestoreThread(tstate);
+		try {
+			preimportModules(modules);
+			done.set_value();
+		} catch(...) {
+			done.set_exception(std::current_exception());
+		}
+		(void)PyEval_SaveThread();
+	}
 }
 } // namespace pyscheduler
@@ -0,0 +1,206 @@
+#ifdef __INTELLISENSE__
+#	include "pyscheduler/recorder.hpp"
+#endif
+
+#include <algorithm>
+#include <future>
+#include <istream>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace pyscheduler {
+
+namespace details {
+inline void putVarint(std::string& out, uint64_t value) {
+	while(value >= 0x80) {
+		out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<char>(value));
+}
+
+/// @throws std::runtime_error on a truncated or overlong varint.
+inline uint64_t getVarint(std::istream& in) {
+	uint64_t value = 0;
+	for(unsigned shift = 0; shift < 64; shift += 7) {
+		const int byte = in.get();
+		if(byte == std::char_traits<char>::eof()) {
+			throw std::runtime_error("Truncated traffic recording");
+		}
+		value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+		if((byte & 0x80) == 0) return value;
+	}
+	throw std::runtime_error("Corrupt varint in traffic recording");
+}
+
+inline uint64_t zigzag(std::int64_t value) {
+	return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline std::int64_t unzigzag(uint64_t value) {
+	return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+/// @brief Sleeps until shortly before deadline, then spins; sleep_until alone overshoots by
+/// tens of microseconds, which would distort open-loop arrival times.
+inline void sleepUntil(std::chrono::steady_clock::time_point deadline) {
+	constexpr auto kSpinWindow = std::chrono::microseconds(100);
+	auto now = std::chrono::steady_clock::now();
+	if(deadline - now > kSpinWindow) {
+		std::this_thread::sleep_until(deadline - kSpinWindow);
+	}
+	while(std::chrono::steady_clock::now() < deadline) {
+	}
+}
+
+inline std::string picklePayload(pybind11::handle obj) {
+	pybind11::bytes pickled = pybind11::module_::import("pickle").attr("dumps")(obj);
+	return std::string(pickled);
+}
+
+inline pybind11::object unpicklePayload(std::string_view payload) {
+	return pybind11::module_::import("pickle").attr("loads")(
+		pybind11::bytes(payload.data(), payload.size()));
+}
+} // namespace details
+
+inline TrafficRecorder::TrafficRecorder(const std::string& path)
+	: _origin(std::chrono::steady_clock::now())
+	, _file(path, std::ios::binary | std::ios::trunc) {
+	if(!_file) {
+		throw std::runtime_error("Could not open traffic recording " + path);
+	}
+	_file.write(kMagic, sizeof(kMagic));
+}
+
+inline TrafficRecorder::~TrafficRecorder() {
+	flush();
+}
+
+inline void TrafficRecorder::write(const RecordedRequest& request) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	_scratch.clear();
+	// Completion order differs from arrival order, hence signed deltas
+	details::putVarint(_scratch, details::zigzag(request.arrival_ns - _last_arrival_ns));
+	details::putVarint(_scratch, request.commit_ns);
+	details::putVarint(_scratch, request.hold_ns);
+	details::putVarint(_scratch, request.execute_ns);
+	details::putVarint(_scratch, request.callback_ns);
+	details::putVarint(_scratch, request.batch_size);
+	details::putVarint(_scratch, request.failed ? 1 : 0);
+	details::putVarint(_scratch, request.payload.size());
+	_scratch.append(request.payload);
+	_file.write(_scratch.data(), static_cast<std::streamsize>(_scratch.size()));
+	_last_arrival_ns = request.arrival_ns;
+	_recorded.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline void TrafficRecorder::drop() {
+	_dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline void TrafficRecorder::flush() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	_file.flush();
+}
+
+inline std::vector<RecordedRequest> read_traffic(const std::string& path) {
+	std::ifstream in(path, std::ios::binary);
+	if(!in) {
+		throw std::runtime_error("Could not open traffic recording " + path);
+	}
+	char magic[sizeof(TrafficRecorder::kMagic)] = { };
+	in.read(magic, sizeof(magic));
+	if(!in || !std::equal(std::begin(magic), std::end(magic), TrafficRecorder::kMagic)) {
+		throw std::runtime_error(path + " is not a traffic recording");
+	}
+
+	std::vector<RecordedRequest> requests;
+	std::int64_t arrival_ns = 0;
+	while(in.peek() != std::char_traits<char>::eof()) {
+		RecordedRequest request;
+		arrival_ns += details::unzigzag(details::getVarint(in));
+		request.arrival_ns = arrival_ns;
+		request.commit_ns = details::getVarint(in);
+		request.hold_ns = details::getVarint(in);
+		request.execute_ns = details::getVarint(in);
+		request.callback_ns = details::getVarint(in);
+		request.batch_size = static_cast<uint32_t>(details::getVarint(in));
+		request.failed = details::getVarint(in) != 0;
+		request.payload.resize(details::getVarint(in));
+		in.read(request.payload.data(), static_cast<std::streamsize>(request.payload.size()));
+		if(!in) {
+			throw std::runtime_error("Truncated traffic recording " + path);
+		}
+		requests.push_back(std::move(request));
+	}
+	return requests;
+}
+
+template <typename Handler>
+ReplayReport replay_traffic(Handler& handler,
+							const std::vector<RecordedRequest>& requests,
+							const ReplayOptions& options) {
+	if(!(options.rate_scale > 0.0)) {
+		throw std::invalid_argument("Replay rate_scale must be positive");
+	}
+	auto deserialize = options.deserialize;
+	if(!deserialize) deserialize = details::unpicklePayload;
+
+	// Recordings are in completion order
+	std::vector<size_t> order(requests.size());
+	std::iota(order.begin(), order.end(), size_t{ 0 });
+	std::stable_sort(order.begin(), order.end(), [&requests](size_t a, size_t b) {
+		return requests[a].arrival_ns < requests[b].arrival_ns;
+	});
+
+	ReplayReport report;
+	report.requests = requests.size();
+	auto latency = std::make_unique<LatencyHistogram>();
+	auto recorded = std::make_unique<LatencyHistogram>();
+	std::vector<std::future<bool>> futures;
+	futures.reserve(requests.size());
+
+	const std::int64_t first = requests.empty() ? 0 : requests[order.front()].arrival_ns;
+	const auto start = std::chrono::steady_clock::now();
+	for(size_t index : order) {
+		const RecordedRequest& request = requests[index];
+		recorded->record(request.latency_ns());
+		const auto scheduled =
+			start + std::chrono::nanoseconds(static_cast<std::int64_t>(
+						static_cast<double>(request.arrival_ns - first) / options.rate_scale));
+		details::sleepUntil(scheduled);
+		const auto lag = std::chrono::steady_clock::now() - scheduled;
+		report.max_send_lag = std::max(
+			report.max_send_lag, std::chrono::duration_cast<std::chrono::nanoseconds>(lag));
+		futures.push_back(handler.queue_invoke(
+			[&deserialize](std::string_view payload) { return deserialize(payload); },
+			[&latency, scheduled](const pybind11::object&) {
+				latency->record(static_cast<uint64_t>(
+					std::chrono::duration_cast<std::chrono::nanoseconds>(
+						std::chrono::steady_clock::now() - scheduled)
+						.count()));
+				return true;
+			},
+			std::string_view(request.payload)));
+	}
+
+	for(auto& future : futures) {
+		try {
+			future.get();
+		} catch(...) {
+			report.failed++;
+		}
+	}
+	report.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - start);
+	report.latency_ns = latency->snapshot();
+	report.recorded_latency_ns = recorded->snapshot();
+	return report;
+}
+
+} // namespace pyscheduler
@@ -0,0 +1,80 @@
+#ifdef __INTELLISENSE__
+#	include "pyscheduler/result_stream.hpp"
+#endif
+
+#include <utility>
+
+namespace pyscheduler {
+
+namespace details {
+
+template <typename T>
+void StreamChannel<T>::push(T item) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if(closed) return;
+		items.push_back(std::move(item));
+	}
+	ready.notify_one();
+}
+
+template <typename T>
+void StreamChannel<T>::close(std::exception_ptr failure) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if(closed) return;
+		closed = true;
+		error = std::move(failure);
+	}
+	ready.notify_all();
+}
+
+} // namespace details
+
+template <typename T>
+ResultStream<T>::ResultStream(std::shared_ptr<details::StreamChannel<T>> channel)
+	: _channel(std::move(channel)) {}
+
+template <typename T>
+std::optional<T> ResultStream<T>::next() {
+	std::unique_lock<std::mutex> lock(_channel->mutex);
+	_channel->ready.wait(lock, [this] { return !_channel->items.empty() || _channel->closed; });
+	if(!_channel->items.empty()) {
+		T item = std::move(_channel->items.front());
+		_channel->items.pop_front();
+		return item;
+	}
+	if(_channel->error) {
+		// Rethrown once; afterwards the stream reads as complete
+		std::rethrow_exception(std::exchange(_channel->error, nullptr));
+	}
+	return std::nullopt;
+}
+
+template <typename T>
+std::optional<T> ResultStream<T>::try_next() {
+	std::lock_guard<std::mutex> lock(_channel->mutex);
+	if(_channel->items.empty()) return std::nullopt;
+	T item = std::move(_channel->items.front());
+	_channel->items.pop_front();
+	return item;
+}
+
+template <typename T>
+bool ResultStream<T>::done() const {
+	std::lock_guard<std::mutex> lock(_channel->mutex);
+	return _channel->closed && _channel->items.empty() && !_channel->error;
+}
+
+template <typename T>
+ResultStream<T>::iterator::iterator(ResultStream* stream)
+	: _stream(stream)
+	, _current(stream->next()) {}
+
+template <typename T>
+typename ResultStream<T>::iterator& ResultStream<T>::iterator::operator++() {
+	_current = _stream->next();
+	return *this;
+}
+
+} // namespace pyscheduler
@@ -0,0 +1,149 @@
+#ifdef __INTELLISENSE__
+#	include "pyscheduler/shm_ring.hpp"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace pyscheduler {
+
+namespace details {
+inline std::atomic_ref<uint64_t> ringCursor(char* base, size_t offset) {
+	return std::atomic_ref<uint64_t>(*reinterpret_cast<uint64_t*>(base + offset));
+}
+} // namespace details
+
+inline ShmRing::ShmRing(size_t capacity)
+	: _capacity((std::max<size_t>(capacity, kRecordHeaderBytes) + 7) & ~size_t{ 7 }) {
+	_mapped_bytes = kDataOffset + _capacity;
+
+	_fd = static_cast<int>(memfd_create("pyscheduler-ring", MFD_CLOEXEC));
+	if(_fd < 0) {
+		throw std::system_error(errno, std::generic_category(), "memfd_create failed");
+	}
+	if(ftruncate(_fd, static_cast<off_t>(_mapped_bytes)) != 0) {
+		int err = errno;
+		close(_fd);
+		throw std::system_error(err, std::generic_category(), "ftruncate failed");
+	}
+	void* mapping = mmap(nullptr, _mapped_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+	if(mapping == MAP_FAILED) {
+		int err = errno;
+		close(_fd);
+		throw std::system_error(err, std::generic_category(), "mmap failed");
+	}
+	_base = static_cast<char*>(mapping);
+
+	// ftruncate zero-fills, so both cursors already start at 0.
+	const uint64_t data_capacity = _capacity;
+	std::memcpy(_base + kCapacityOffset, &data_capacity, sizeof(data_capacity));
+}
+
+inline ShmRing::~ShmRing() {
+	if(_base != nullptr) munmap(_base, _mapped_bytes);
+	if(_fd >= 0) close(_fd);
+}
+
+inline ShmRing::ShmRing(ShmRing&& other) noexcept
+	: _fd(other._fd)
+	, _base(other._base)
+	, _capacity(other._capacity)
+	, _mapped_bytes(other._mapped_bytes) {
+	other._fd = -1;
+	other._base = nullptr;
+}
+
+inline ShmRing& ShmRing::operator=(ShmRing&& other) noexcept {
+	if(this != &other) {
+		if(_base != nullptr) munmap(_base, _mapped_bytes);
+		if(_fd >= 0) close(_fd);
+		_fd = other._fd;
+		_base = other._base;
+		_capacity = other._capacity;
+		_mapped_bytes = other._mapped_bytes;
+		other._fd = -1;
+		other._base = nullptr;
+	}
+	return *this;
+}
+
+inline int ShmRing::fd() const {
+	return _fd;
+}
+
+inline size_t ShmRing::capacity() const {
+	return _capacity;
+}
+
+inline size_t ShmRing::free_bytes() const {
+	const uint64_t head = details::ringCursor(_base, kHeadOffset).load(std::memory_order_relaxed);
+	const uint64_t tail = details::ringCursor(_base, kTailOffset).load(std::memory_order_acquire);
+	return _capacity - static_cast<size_t>(head - tail);
+}
+
+inline size_t ShmRing::record_size(size_t payload_bytes) {
+	return (kRecordHeaderBytes + payload_bytes + 7) & ~size_t{ 7 };
+}
+
+inline bool ShmRing::try_push(uint64_t tag, uint32_t status, const void* data, size_t size) {
+	const size_t needed = record_size(size);
+	const uint64_t head = details::ringCursor(_base, kHeadOffset).load(std::memory_order_relaxed);
+	const uint64_t tail = details::ringCursor(_base, kTailOffset).load(std::memory_order_acquire);
+	if(_capacity - static_cast<size_t>(head - tail) < needed) return false;
+
+	const uint32_t length = static_cast<uint32_t>(size);
+	char header[kRecordHeaderBytes];
+	std::memcpy(header, &tag, sizeof(tag));
+	std::memcpy(header + 8, &status, sizeof(status));
+	std::memcpy(header + 12, &length, sizeof(length));
+	copy_in(head, header, sizeof(header));
+	copy_in(head + kRecordHeaderBytes, data, size);
+
+	details::ringCursor(_base, kHeadOffset).store(head + needed, std::memory_order_release);
+	return true;
+}
+
+inline bool ShmRing::try_pop(uint64_t& tag, uint32_t& status, std::string& payload) {
+	const uint64_t tail = details::ringCursor(_base, kTailOffset).load(std::memory_order_relaxed);
+	const uint64_t head = details::ringCursor(_base, kHeadOffset).load(std::memory_order_acquire);
+	if(head == tail) return false;
+
+	char header[kRecordHeaderBytes];
+	copy_out(tail, header, sizeof(header));
+	uint32_t length = 0;
+	std::memcpy(&tag, header, sizeof(tag));
+	std::memcpy(&status, header + 8, sizeof(status));
+	std::memcpy(&length, header + 12, sizeof(length));
+
+	payload.resize(length);
+	copy_out(tail + kRecordHeaderBytes, payload.data(), length);
+
+	details::ringCursor(_base, kTailOffset)
+		.store(tail + record_size(length), std::memory_order_release);
+	return true;
+}
+
+inline void ShmRing::copy_in(uint64_t position, const void* src, size_t size) {
+	if(size == 0) return;
+	const size_t start = static_cast<size_t>(position % _capacity);
+	const size_t first = std::min(size, _capacity - start);
+	std::memcpy(_base + kDataOffset + start, src, first);
+	std::memcpy(_base + kDataOffset, static_cast<const char*>(src) + first, size - first);
+}
+
+inline void ShmRing::copy_out(uint64_t position, void* dst, size_t size) const {
+	if(size == 0) return;
+	const size_t start = static_cast<size_t>(position % _capacity);
+	const size_t first = std::min(size, _capacity - start);
+	std::memcpy(dst, _base + kDataOffset + start, first);
+	std::memcpy(static_cast<char*>(dst) + first, _base + kDataOffset, size - first);
+}
+
+} // namespace pyscheduler
@@ -0,0 +1,350 @@
+#ifdef __INTELLISENSE__
+#	include "pyscheduler/shm_tensor.hpp"
+#endif
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace pyscheduler {
+
+namespace details {
+/// @brief manager_ctx of every shared-memory tensor. Arena tensors keep their arena alive;
+/// imported tensors own a private mapping and a duplicate of the sender's fd.
+struct ShmTensorContext {
+	std::shared_ptr<ShmArena> arena;
+	int fd = -1;
+	void* mapping = nullptr;
+	size_t mapping_bytes = 0;
+	uint64_t offset = 0;
+	std::vector<int64_t> shape;
+};
+
+inline void deleteShmTensor(DLManagedTensor* self) {
+	auto* ctx = static_cast<ShmTensorContext*>(self->manager_ctx);
+	if(ctx->mapping != nullptr) munmap(ctx->mapping, ctx->mapping_bytes);
+	if(ctx->arena == nullptr && ctx->fd >= 0) close(ctx->fd);
+	delete ctx;
+	delete self;
+}
+
+inline DLManagedTensor* wrapShmTensor(ShmTensorContext* ctx, void* data, DLDataType dtype) {
+	auto* managed = new DLManagedTensor();
+	managed->dl_tensor.data = data;
+	managed->dl_tensor.device = DLDevice{ kDLCPU, 0 };
+	managed->dl_tensor.ndim = static_cast<int32_t>(ctx->shape.size());
+	managed->dl_tensor.dtype = dtype;
+	managed->dl_tensor.shape = ctx->shape.data();
+	managed->dl_tensor.strides = nullptr;
+	managed->dl_tensor.byte_offset = 0;
+	managed->manager_ctx = ctx;
+	managed->deleter = &deleteShmTensor;
+	return managed;
+}
+
+/// @brief Fixed-size prefix of a descriptor on the wire; the shape follows as int64 values.
+struct ShmDescriptorHeader {
+	uint32_t magic;
+	uint32_t ndim;
+	uint64_t offset;
+	uint8_t code;
+	uint8_t bits;
+	uint16_t lanes;
+	uint32_t reserved;
+};
+
+inline constexpr uint32_t kShmDescriptorMagic = 0x54534850; // "PHST"
+inline constexpr uint32_t kShmDescriptorMaxDims = 64;
+
+inline void sendAll(int socket, const char* data, size_t size) {
+	while(size > 0) {
+		ssize_t n = ::send(socket, data, size, MSG_NOSIGNAL);
+		if(n < 0) {
+			if(errno == EINTR) continue;
+			throw std::system_error(errno, std::generic_category(), "send failed");
+		}
+		data += n;
+		size -= static_cast<size_t>(n);
+	}
+}
+
+inline void recvAll(int socket, char* data, size_t size) {
+	while(size > 0) {
+		ssize_t n = ::recv(socket, data, size, MSG_WAITALL);
+		if(n == 0) throw std::runtime_error("Peer closed socket while sending a descriptor");
+		if(n < 0) {
+			if(errno == EINTR) continue;
+			throw std::system_error(errno, std::generic_category(), "recv failed");
+		}
+		data += n;
+		size -= static_cast<size_t>(n);
+	}
+}
+} // namespace details
+
+inline std::shared_ptr<ShmArena> ShmArena::create(size_t capacity, const std::string& name) {
+	if(capacity == 0) {
+		throw std::invalid_argument("ShmArena capacity must be non-zero");
+	}
+	int fd = static_cast<int>(memfd_create(name.c_str(), MFD_CLOEXEC));
+	if(fd < 0) {
+		throw std::system_error(errno, std::generic_category(), "memfd_create failed");
+	}
+	if(ftruncate(fd, static_cast<off_t>(capacity)) != 0) {
+		int err = errno;
+		close(fd);
+		throw std::system_error(err, std::generic_category(), "ftruncate failed");
+	}
+	void* mapping = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if(mapping == MAP_FAILED) {
+		int err = errno;
+		close(fd);
+		throw std::system_error(err, std::generic_category(), "mmap failed");
+	}
+	return std::shared_ptr<ShmArena>(new ShmArena(fd, static_cast<char*>(mapping), capacity));
+}
+
+inline ShmArena::ShmArena(int fd, char* base, size_t capacity)
+	: _fd(fd)
+	, _base(base)
+	, _capacity(capacity) { }
+
+inline ShmArena::~ShmArena() {
+	munmap(_base, _capacity);
+	close(_fd);
+}
+
+inline size_t ShmArena::allocate(size_t bytes, size_t alignment) {
+	if(alignment == 0 || (alignment & (alignment - 1)) != 0) {
+		throw std::invalid_argument("ShmArena alignment must be a power of two");
+	}
+	std::lock_guard lock(_mutex);
+	const size_t offset = (_used + alignment - 1) & ~(alignment - 1);
+	if(offset > _capacity || _capacity - offset < bytes) {
+		throw std::bad_alloc();
+	}
+	_used = offset + bytes;
+	return offset;
+}
+
+inline int ShmArena::fd() const {
+	return _fd;
+}
+
+inline size_t ShmArena::capacity() const {
+	return _capacity;
+}
+
+inline char* ShmArena::data() const {
+	return _base;
+}
+
+inline uint64_t ShmTensorDescriptor::nbytes() const {
+	uint64_t elements = 1;
+	for(int64_t dim : shape) {
+		elements *= static_cast<uint64_t>(dim);
+	}
+	return elements * ((uint64_t{ dtype.bits } * dtype.lanes + 7) / 8);
+}
+
+template <typename T>
+inline DLManagedTensor* createShmTensorDlpack(const std::shared_ptr<ShmArena>& arena,
+											  const std::vector<int64_t>& shape) {
+	if(arena == nullptr) {
+		throw std::invalid_argument("createShmTensorDlpack requires an arena");
+	}
+	size_t elements = 1;
+	for(int64_t dim : shape) {
+		if(dim < 0) throw std::invalid_argument("Tensor dimensions must be non-negative");
+		elements *= static_cast<size_t>(dim);
+	}
+
+	constexpr size_t alignment = alignof(T) > 64 ? alignof(T) : 64;
+	const size_t offset = arena->allocate(elements * sizeof(T), alignment);
+
+	auto* ctx = new details::ShmTensorContext();
+	ctx->arena = arena;
+	ctx->fd = arena->fd();
+	ctx->offset = offset;
+	ctx->shape = shape;
+	return details::wrapShmTensor(ctx, arena->data() + offset, DLPackTypeTraits<T>::dtype);
+}
+
+inline ShmTensorDescriptor describeShmTensor(const DLManagedTensor* tensor) {
+	if(tensor == nullptr || tensor->deleter != &details::deleteShmTensor) {
+		throw std::invalid_argument("Tensor is not backed by shared memory");
+	}
+	const auto* ctx = static_cast<const details::ShmTensorContext*>(tensor->manager_ctx);
+
+	ShmTensorDescriptor descriptor;
+	descriptor.fd = ctx->fd;
+	descriptor.offset = ctx->offset;
+	descriptor.shape = ctx->shape;
+	descriptor.dtype = tensor->dl_tensor.dtype;
+	return descriptor;
+}
+
+inline DLManagedTensor* importShmTensorDlpack(const ShmTensorDescriptor& descriptor) {
+	for(int64_t dim : descriptor.shape) {
+		if(dim < 0) throw std::invalid_argument("Tensor dimensions must be non-negative");
+	}
+	struct stat info{ };
+	if(fstat(descriptor.fd, &info) != 0) {
+		throw std::system_error(errno, std::generic_category(), "fstat failed");
+	}
+	const uint64_t nbytes = descriptor.nbytes();
+	if(descriptor.offset > static_cast<uint64_t>(info.st_size) ||
+	   static_cast<uint64_t>(info.st_size) - descriptor.offset < nbytes) {
+		throw std::invalid_argument("Descriptor points past the end of the shared memory");
+	}
+
+	// mmap offsets must be page aligned; map from the page holding the first element.
+	const uint64_t page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+	const uint64_t map_offset = descriptor.offset & ~(page - 1);
+	const size_t map_bytes = static_cast<size_t>(descriptor.offset - map_offset + nbytes);
+
+	int fd = fcntl(descriptor.fd, F_DUPFD_CLOEXEC, 0);
+	if(fd < 0) {
+		throw std::system_error(errno, std::generic_category(), "fcntl(F_DUPFD_CLOEXEC) failed");
+	}
+	void* mapping = nullptr;
+	if(map_bytes > 0) {
+		mapping = mmap(nullptr,
+					   map_bytes,
+					   PROT_READ | PROT_WRITE,
+					   MAP_SHARED,
+					   fd,
+					   static_cast<off_t>(map_offset));
+		if(mapping == MAP_FAILED) {
+			int err = errno;
+			close(fd);
+			throw std::system_error(err, std::generic_category(), "mmap failed");
+		}
+	}
+
+	auto* ctx = new details::ShmTensorContext();
+	ctx->fd = fd;
+	ctx->mapping = mapping;
+	ctx->mapping_bytes = map_bytes;
+	ctx->offset = descriptor.offset;
+	ctx->shape = descriptor.shape;
+	char* data = static_cast<char*>(mapping) + (descriptor.offset - map_offset);
+	return details::wrapShmTensor(ctx, mapping != nullptr ? data : nullptr, descriptor.dtype);
+}
+
+inline void sendShmTensorDescriptor(int socket, const ShmTensorDescriptor& descriptor) {
+	if(descriptor.shape.size() > details::kShmDescriptorMaxDims) {
+		throw std::invalid_argument("Tensor has too many dimensions to send");
+	}
+	details::ShmDescriptorHeader header{ details::kShmDescriptorMagic,
+										 static_cast<uint32_t>(descriptor.shape.size()),
+										 descriptor.offset,
+										 descriptor.dtype.code,
+										 descriptor.dtype.bits,
+										 descriptor.dtype.lanes,
+										 0 };
+
+	// The fd rides on the header's first byte; the shape follows as plain stream data.
+	iovec iov{ &header, sizeof(header) };
+	alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = { };
+	msghdr message{ };
+	message.msg_iov = &iov;
+	message.msg_iovlen = 1;
+	message.msg_control = control;
+	message.msg_controllen = sizeof(control);
+	cmsghdr* cmsg = CMSG_FIRSTHDR(&message);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+	std::memcpy(CMSG_DATA(cmsg), &descriptor.fd, sizeof(int));
+
+	ssize_t sent = -1;
+	do {
+		sent = ::sendmsg(socket, &message, MSG_NOSIGNAL);
+	} while(sent < 0 && errno == EINTR);
+	if(sent < 0) {
+		throw std::system_error(errno, std::generic_category(), "sendmsg failed");
+	}
+	details::sendAll(socket,
+					 reinterpret_cast<const char*>(&header) + sent,
+					 sizeof(header) - static_cast<size_t>(sent));
+	details::sendAll(socket,
+					 reinterpret_cast<const char*>(descriptor.shape.data()),
+					 descriptor.shape.size() * sizeof(int64_t));
+}
+
+inline ShmTensorDescriptor receiveShmTensorDescriptor(int socket) {
+	details::ShmDescriptorHeader header{ };
+	iovec iov{ &header, sizeof(header) };
+	alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = { };
+	msghdr message{ };
+	message.msg_iov = &iov;
+	message.msg_iovlen = 1;
+	message.msg_control = control;
+	message.msg_controllen = sizeof(control);
+
+	ssize_t received = -1;
+	do {
+		received = ::recvmsg(socket, &message, MSG_CMSG_CLOEXEC);
+	} while(received < 0 && errno == EINTR);
+	if(received < 0) {
+		throw std::system_error(errno, std::generic_category(), "recvmsg failed");
+	}
+	if(received == 0) {
+		throw std::runtime_error("Peer closed socket while sending a descriptor");
+	}
+
+	int fd = -1;
+	for(cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr;
+		cmsg = CMSG_NXTHDR(&message, cmsg)) {
+		if(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+			std::memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+		}
+	}
+
+	ShmTensorDescriptor descriptor;
+	try {
+		if(fd < 0 || (message.msg_flags & MSG_CTRUNC) != 0) {
+			throw std::runtime_error("Descriptor arrived without its file descriptor");
+		}
+		details::recvAll(socket,
+						 reinterpret_cast<char*>(&header) + received,
+						 sizeof(header) - static_cast<size_t>(received));
+		if(header.magic != details::kShmDescriptorMagic ||
+		   header.ndim > details::kShmDescriptorMaxDims) {
+			throw std::runtime_error("Malformed shared-memory tensor descriptor");
+		}
+		descriptor.shape.resize(header.ndim);
+		details::recvAll(socket,
+						 reinterpret_cast<char*>(descriptor.shape.data()),
+						 descriptor.shape.size() * sizeof(int64_t));
+	} catch(...) {
+		if(fd >= 0) close(fd);
+		throw;
+	}
+
+	descriptor.fd = fd;
+	descriptor.offset = header.offset;
+	descriptor.dtype = DLDataType{ header.code, header.bits, header.lanes };
+	return descriptor;
+}
+
+inline pybind11::capsule makeDlpackCapsule(DLManagedTensor* tensor) {
+	return pybind11::capsule(tensor, "dltensor", [](PyObject* capsule) {
+		// Consumers rename the capsule to "used_dltensor" once they own the tensor.
+		if(PyCapsule_IsValid(capsule, "dltensor")) {
+			auto* managed =
+				static_cast<DLManagedTensor*>(PyCapsule_GetPointer(capsule, "dltensor"));
+			if(managed->deleter != nullptr) managed->deleter(managed);
+		}
+	});
+}
+
+} // namespace pyscheduler
@@ -0,0 +1,225 @@
+#ifdef __INTELLISENSE__
+#	include "pyscheduler/trace.hpp"
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace pyscheduler {
+
+inline void Tracer::enable(size_t events_per_thread) {
+	_state.capacity.store(std::max<size_t>(events_per_thread, 1), std::memory_order_relaxed);
+	_state.enabled.store(true, std::memory_order_relaxed);
+}
+
+inline void Tracer::disable() {
+	_state.enabled.store(false, std::memory_order_relaxed);
+}
+
+inline uint64_t Tracer::next_request_id() {
+	return _state.next_request.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline uint64_t Tracer::next_batch_id() {
+	return _state.next_batch.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline Tracer::Buffer& Tracer::localBuffer() {
+	thread_local std::shared_ptr<Buffer> buffer = [] {
+		auto created = std::make_shared<Buffer>();
+		created->events.resize(_state.capacity.load(std::memory_order_relaxed));
+		created->tid = static_cast<uint32_t>(::syscall(SYS_gettid));
+		std::lock_guard<std::mutex> lock(_state.buffers_mutex);
+		_state.buffers.push_back(created);
+		return created;
+	}();
+	return *buffer;
+}
+
+inline void Tracer::record(Phase phase,
+						   uint64_t request_id,
+						   uint64_t batch_id,
+						   uint64_t handler_id,
+						   std::chrono::steady_clock::time_point ts,
+						   uint32_t value) {
+	Buffer& buffer = localBuffer();
+	std::lock_guard<std::mutex> lock(buffer.mutex);
+	if(buffer.events.empty()) return;
+	Event& event = buffer.events[buffer.next];
+	event.request_id = request_id;
+	event.batch_id = batch_id;
+	event.ts_ns =
+		std::chrono::duration_cast<std::chrono::nanoseconds>(ts.time_since_epoch()).count();
+	event.handler_id = static_cast<uint32_t>(handler_id);
+	event.value = value;
+	event.phase = phase;
+	if(++buffer.next == buffer.events.size()) {
+		buffer.next = 0;
+		buffer.wrapped = true;
+	}
+}
+
+inline void Tracer::clear() {
+	std::lock_guard<std::mutex> lock(_state.buffers_mutex);
+	auto& buffers = _state.buffers;
+	// A buffer only referenced by the registry belongs to a thread that has exited.
+	buffers.erase(std::remove_if(buffers.begin(),
+								 buffers.end(),
+								 [](const auto& buffer) { return buffer.use_count() == 1; }),
+				  buffers.end());
+	const size_t capacity = _state.capacity.load(std::memory_order_relaxed);
+	for(auto& buffer : buffers) {
+		std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+		buffer->events.assign(capacity, Event{ });
+		buffer->next = 0;
+		buffer->wrapped = false;
+	}
+}
+
+namespace details {
+inline void appendTraceEvent(std::string& out,
+							 bool& first,
+							 const char* name,
+							 const char* category,
+							 char phase,
+							 std::int64_t ts_ns,
+							 uint32_t tid,
+							 const std::string& extra) {
+	char buffer[256];
+	std::snprintf(buffer,
+				  sizeof(buffer),
+				  "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\","
+				  "\"ts\":%.3f,\"pid\":%d,\"tid\":%u",
+				  first ? "\n" : ",\n",
+				  name,
+				  category,
+				  phase,
+				  static_cast<double>(ts_ns) / 1000.0,
+				  static_cast<int>(::getpid()),
+				  tid);
+	out += buffer;
+	out += extra;
+	out += "}";
+	first = false;
+}
+} // namespace details
+
+inline std::string Tracer::dump_chrome_json() {
+	struct Stamped {
+		Event event;
+		uint32_t tid;
+	};
+	std::vector<Stamped> events;
+	{
+		std::lock_guard<std::mutex> lock(_state.buffers_mutex);
+		for(const auto& buffer : _state.buffers) {
+			std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+			const size_t count = buffer->wrapped ? buffer->events.size() : buffer->next;
+			for(size_t i = 0; i < count; i++) {
+				events.push_back(Stamped{ buffer->events[i], buffer->tid });
+			}
+		}
+	}
+
+	struct BatchInfo {
+		std::int64_t start = -1;
+		std::int64_t end = -1;
+		uint32_t tid = 0;
+		uint32_t handler = 0;
+		uint32_t size = 0;
+	};
+	struct RequestInfo {
+		std::int64_t enqueue = -1;
+		std::int64_t commit_start = -1;
+		std::int64_t commit_end = -1;
+		std::int64_t callback_end = -1;
+		uint64_t batch = 0;
+		uint32_t handler = 0;
+		uint32_t tid = 0;
+	};
+	std::unordered_map<uint64_t, BatchInfo> batches;
+	std::unordered_map<uint64_t, RequestInfo> requests;
+
+	for(const Stamped& stamped : events) {
+		const Event& event = stamped.event;
+		switch(event.phase) {
+		case Phase::kExecuteStart: {
+			BatchInfo& batch = batches[event.batch_id];
+			batch.start = event.ts_ns;
+			batch.tid = stamped.tid;
+			batch.handler = event.handler_id;
+			batch.size = event.value;
+			break;
+		}
+		case Phase::kExecuteEnd: batches[event.batch_id].end = event.ts_ns; break;
+		default: {
+			RequestInfo& request = requests[event.request_id];
+			request.handler = event.handler_id;
+			if(event.phase == Phase::kEnqueue) {
+				request.enqueue = event.ts_ns;
+			} else {
+				request.tid = stamped.tid;
+			}
+			if(event.phase == Phase::kCommitStart) request.commit_start = event.ts_ns;
+			if(event.phase == Phase::kCommitEnd) request.commit_end = event.ts_ns;
+			if(event.phase == Phase::kBatchAssembled) request.batch = event.batch_id;
+			if(event.phase == Phase::kCallbackEnd) request.callback_end = event.ts_ns;
+		}
+		}
+	}
+
+	std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+	bool first = true;
+
+	for(const auto& [id, batch] : batches) {
+		if(batch.start < 0 || batch.end < batch.start) continue;
+		char extra[160];
+		std::snprintf(extra,
+					  sizeof(extra),
+					  ",\"dur\":%.3f,\"args\":{\"handler\":%u,\"batch\":%llu,\"size\":%u}",
+					  static_cast<double>(batch.end - batch.start) / 1000.0,
+					  batch.handler,
+					  static_cast<unsigned long long>(id),
+					  batch.size);
+		details::appendTraceEvent(
+			out, first, "execute batch", "batch", 'X', batch.start, batch.tid, extra);
+	}
+
+	for(const auto& [id, request] : requests) {
+		std::int64_t execute_start = -1;
+		std::int64_t execute_end = -1;
+		if(auto it = batches.find(request.batch); request.batch != 0 && it != batches.end()) {
+			execute_start = it->second.start;
+			execute_end = it->second.end;
+		}
+
+		char extra[160];
+		std::snprintf(extra,
+					  sizeof(extra),
+					  ",\"id\":\"0x%llx\",\"args\":{\"handler\":%u,\"batch\":%llu}",
+					  static_cast<unsigned long long>(id),
+					  request.handler,
+					  static_cast<unsigned long long>(request.batch));
+
+		// One async track per request; spans are emitted only when both ends were captured.
+		auto span = [&](const char* name, std::int64_t begin, std::int64_t end) {
+			if(begin < 0 || end < begin) return;
+			details::appendTraceEvent(out, first, name, "request", 'b', begin, request.tid, extra);
+			details::appendTraceEvent(out, first, name, "request", 'e', end, request.tid, extra);
+		};
+		span("request", request.enqueue, request.callback_end);
+		span("queued", request.enqueue, request.commit_start);
+		span("commit", request.commit_start, request.commit_end);
+		span("hold", request.commit_end, execute_start);
+		span("execute", execute_start, execute_end);
+		span("callback", execute_end, request.callback_end);
+	}
+
+	out += "\n]}\n";
+	return out;
+}
+
+} // namespace pyscheduler
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <dlpack/dlpack.h>
+
+#include <cstdint>
+
+namespace pyscheduler {
+
+/// @brief Maps C++ element types to DLPack dtypes.
+template <typename T>
+struct DLPackTypeTraits;
+
+template <>
+struct DLPackTypeTraits<float> {
+	static constexpr DLDataType dtype = { kDLFloat, 32, 1 };
+};
+
+template <>
+struct DLPackTypeTraits<double> {
+	static constexpr DLDataType dtype = { kDLFloat, 64, 1 };
+};
+
+template <>
+struct DLPackTypeTraits<int64_t> {
+	static constexpr DLDataType dtype = { kDLInt, 64, 1 };
+};
+
+template <>
+struct DLPackTypeTraits<int32_t> {
+	static constexpr DLDataType dtype = { kDLInt, 32, 1 };
+};
+
+template <>
+struct DLPackTypeTraits<uint8_t> {
+	static constexpr DLDataType dtype = { kDLUInt, 8, 1 };
+};
+
+} // namespace pyscheduler
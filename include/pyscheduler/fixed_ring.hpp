@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+namespace pyscheduler {
+
+namespace details {
+
+/// @brief FIFO of at most capacity elements in one allocation made up front, so pushing and
+/// popping never touch the heap. Slots are default-constructed; pop_front resets the slot
+/// to release what the element held. Not thread-safe.
+template <typename T>
+class FixedRing {
+public:
+	explicit FixedRing(size_t capacity);
+
+	FixedRing(const FixedRing&) = delete;
+	FixedRing& operator=(const FixedRing&) = delete;
+
+	/// @brief Appends value. Requires !full().
+	void push_back(T&& value);
+	/// @brief Drops the first element. Requires !empty().
+	void pop_front();
+	void clear();
+
+	T& front();
+	const T& front() const;
+	/// @brief The index-th element from the front.
+	T& operator[](size_t index);
+	const T& operator[](size_t index) const;
+
+	/// @brief Moves the element at index to position to < index, shifting the elements in
+	/// between back by one; the order of every other element is kept.
+	void move_forward(size_t index, size_t to);
+
+	size_t size() const;
+	size_t capacity() const;
+	bool empty() const;
+	bool full() const;
+
+private:
+	size_t slot(size_t index) const;
+
+	std::unique_ptr<T[]> _slots;
+	size_t _capacity = 0;
+	size_t _head = 0;
+	size_t _size = 0;
+};
+
+} // namespace details
+
+} // namespace pyscheduler
+
+#include "pyscheduler/details/fixed_ring_impl.hpp"
@@ -0,0 +1,123 @@
+#pragma once
+#include "pyscheduler/library_export.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pyscheduler {
+
+/// @brief Point-in-time copy of a LatencyHistogram.
+struct HistogramSnapshot {
+	uint64_t count = 0;
+	uint64_t sum = 0;
+	uint64_t max = 0;
+	/// Per-bucket counts, indexed like LatencyHistogram buckets.
+	std::vector<uint64_t> buckets;
+
+	/// @brief Value at quantile q in [0, 1], accurate to the bucket width (~6%).
+	uint64_t percentile(double q) const;
+	double mean() const;
+};
+
+/// @brief GIL usage totals, as collected by GilProfiler.
+struct GilStats {
+	uint64_t acquisitions = 0;
+	/// Wall time of the library's GIL scopes, from acquisition to release. Python code
+	/// that releases the GIL inside a scope (time.sleep, I/O, native kernels) is counted
+	/// too, so this bounds actual GIL ownership from above.
+	uint64_t scope_ns = 0;
+	/// Thread CPU time consumed inside those scopes.
+	uint64_t scope_cpu_ns = 0;
+	/// Distribution of time spent waiting to acquire the GIL; its sum is the total wait.
+	HistogramSnapshot wait_ns;
+
+	/// @brief Fraction of scope time spent on CPU.
+	double scope_cpu_ratio() const;
+};
+
+/// @brief Lock-free log-linear histogram of non-negative integer samples.
+///
+/// Values below 16 get exact buckets; above that every power of two is split into 16
+/// linear sub-buckets, as in HdrHistogram with ~1.2 significant digits. Recording is a
+/// handful of relaxed atomic adds, so any number of threads may record while others snapshot.
+class PYSCHEDULER_LIBRARY_EXPORT LatencyHistogram {
+public:
+	static constexpr unsigned kSubBucketBits = 4;
+	static constexpr size_t kSubBuckets = size_t{ 1 } << kSubBucketBits;
+	static constexpr size_t kBucketCount = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+	void record(uint64_t value);
+
+	HistogramSnapshot snapshot() const;
+
+	static size_t bucket_index(uint64_t value);
+	/// @brief Smallest and largest values that land in a bucket.
+	static uint64_t bucket_lower_bound(size_t index);
+	static uint64_t bucket_upper_bound(size_t index);
+
+private:
+	std::array<std::atomic<uint64_t>, kBucketCount> _buckets{ };
+	std::atomic<uint64_t> _count{ 0 };
+	std::atomic<uint64_t> _sum{ 0 };
+	std::atomic<uint64_t> _max{ 0 };
+};
+
+/// @brief Per-phase distributions recorded by an InvokeHandler worker. Times are nanoseconds.
+struct HandlerHistograms {
+	/// queue_invoke until the worker starts committing the item.
+	LatencyHistogram queue_wait_ns;
+	/// Duration of each item's commit function.
+	LatencyHistogram commit_ns;
+	/// Commit finished until the item's batch starts executing.
+	LatencyHistogram hold_ns;
+	/// Duration of each batched Python call.
+	LatencyHistogram execute_batch_ns;
+	/// Batch execute time divided by the batch size.
+	LatencyHistogram execute_item_ns;
+	/// Time spent dispatching a batch's results and errors to callbacks.
+	LatencyHistogram fanout_ns;
+	/// Items per executed batch.
+	LatencyHistogram batch_size;
+};
+
+/// @brief Metrics of a single handler, as returned by InvokeHandler::get_metrics.
+struct HandlerMetricsSnapshot {
+	/// HandlerOptions::name, or "module.entry_point".
+	std::string handler;
+	/// Process-unique handler id, distinguishing handlers that share a name.
+	uint64_t id = 0;
+	size_t commit_queue_size = 0;
+	size_t execute_queue_size = 0;
+	std::int64_t total_enqueued = 0;
+	/// Age of the oldest item not yet handed to Python; 0 when the queues are empty.
+	/// Conservative: may overstate the age while the worker is busy.
+	uint64_t oldest_item_age_ns = 0;
+
+	HistogramSnapshot queue_wait_ns;
+	HistogramSnapshot commit_ns;
+	HistogramSnapshot hold_ns;
+	HistogramSnapshot execute_batch_ns;
+	HistogramSnapshot execute_item_ns;
+	HistogramSnapshot fanout_ns;
+	HistogramSnapshot batch_size;
+
+	/// GIL acquisitions made on behalf of this handler (worker and synchronous invoke).
+	GilStats gil;
+};
+
+/// @brief Metrics of every live handler in the process.
+struct MetricsSnapshot {
+	std::vector<HandlerMetricsSnapshot> handlers;
+};
+
+/// @brief Renders a snapshot in the OpenMetrics text format (also accepted by Prometheus).
+/// Latency distributions become summaries with 0.5/0.9/0.99/0.999 quantiles, in seconds.
+std::string renderOpenMetrics(const MetricsSnapshot& snapshot);
+
+} // namespace pyscheduler
+
+#include "pyscheduler/details/metrics_impl.hpp"
@@ -0,0 +1,73 @@
+#pragma once
+#include "pyscheduler/dlpack_traits.hpp"
+#include "pyscheduler/library_export.hpp"
+#include <pybind11/pybind11.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <span>
+
+namespace pyscheduler {
+
+/// @brief Completion of a set of requests that write into caller-owned memory (see
+/// InvokeHandler::queue_invoke_into), without a promise per request.
+///
+/// Copies share the same counter, so a group can be handed to requests by reference and
+/// waited on from any thread. Reusable: wait() resets the recorded error.
+class PYSCHEDULER_LIBRARY_EXPORT CompletionGroup {
+public:
+	CompletionGroup();
+
+	/// @brief Blocks until every request added so far has completed, then rethrows the first
+	/// error since the previous wait, if any.
+	void wait();
+
+	/// @brief Like wait(), giving up after timeout.
+	/// @return false if requests were still pending at the timeout.
+	template <typename Rep, typename Period>
+	bool wait_for(std::chrono::duration<Rep, Period> timeout);
+
+	/// @brief Number of requests that have not completed yet.
+	size_t pending() const;
+
+	/// @brief Registers one more request; called by queue_invoke_into.
+	void add();
+	/// @brief Marks one request complete, with its error if it failed. Thread-safe.
+	void done(std::exception_ptr error = nullptr);
+
+private:
+	struct State {
+		mutable std::mutex mutex;
+		std::condition_variable idle;
+		size_t pending = 0;
+		std::exception_ptr error;
+	};
+
+	void rethrowError(std::unique_lock<std::mutex>& lock);
+
+	std::shared_ptr<State> _state;
+};
+
+/// @brief Copies one result into destination in a single pass, without intermediate C++ or
+/// Python objects.
+///
+/// Accepts, in order of preference:
+/// - a C-contiguous buffer-protocol object (numpy array, array.array, bytes, memoryview)
+///   whose items are sizeof(T) bytes wide and, for arithmetic T, of T's kind (signed,
+///   unsigned, floating point or bool) in native byte order;
+/// - an object with `__dlpack__` (e.g. a CPU torch tensor) whose dtype matches T;
+/// - a sequence of numbers, converted item by item.
+///
+/// Requires the GIL.
+/// @throws std::invalid_argument if the element count, width or type does not match
+/// destination.
+template <typename T>
+void copyResultInto(pybind11::handle result, std::span<T> destination);
+
+} // namespace pyscheduler
+
+#include "pyscheduler/details/output_buffer_impl.hpp"
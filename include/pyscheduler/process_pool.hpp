@@ -0,0 +1,123 @@
+#pragma once
+#include "pyscheduler/library_export.hpp"
+#include "pyscheduler/shm_ring.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include <vector>
+
+namespace pyscheduler {
+
+/// @brief Pool of out-of-process Python workers fed through shared-memory rings.
+///
+/// Each worker is a separate Python interpreter process that imports the module, then pulls
+/// pickled batches from its request ShmRing and pushes pickled result lists (or error text)
+/// back through its response ShmRing. A socketpair per worker acts as the doorbell for both
+/// directions and doubles as the liveness signal: EOF means the worker exited.
+///
+/// The pool itself never touches Python objects; pickling happens on the owning handler's
+/// worker thread. It is not thread-safe and is driven by a single thread.
+class PYSCHEDULER_LIBRARY_EXPORT ProcessPool {
+public:
+	struct Options {
+		std::string module_name;
+		std::string entry_point;
+		/// Entries appended to each worker's sys.path (normally the host's sys.path).
+		std::vector<std::string> sys_path;
+		/// Number of worker processes to spawn.
+		size_t processes = 1;
+		/// Data capacity of each request and response ring.
+		size_t ring_bytes = size_t{ 16 } << 20;
+		/// Interpreter to spawn; a name without a slash is resolved through PATH. Batches and
+		/// results are pickled, so it must match the host's Python; see python_version.
+		std::string python_executable;
+		/// "major.minor" the spawned interpreter must report, normally the embedded one's.
+		/// A worker running any other version fails startup. Empty skips the check.
+		std::string python_version;
+		/// How long to wait for every worker to import the module.
+		std::chrono::milliseconds startup_timeout{ 60000 };
+		/// How long the destructor lets workers drain their rings and exit before it sends
+		/// SIGTERM, then SIGKILL.
+		std::chrono::milliseconds shutdown_grace{ 5000 };
+	};
+
+	/// @brief Status carried by each ring record.
+	enum Status : uint32_t {
+		/// Payload is the pickled list of results.
+		kOk = 0,
+		/// Payload is the text of the exception raised by the entry point.
+		kError = 1,
+		/// Startup handshake: the worker imported the module.
+		kReady = 2,
+		/// Synthesized by the pool: the worker died with the batch in flight.
+		kWorkerLost = 3,
+	};
+
+	/// @brief Maximum batches queued on a single worker at once.
+	static constexpr size_t kMaxInflightPerWorker = 2;
+
+	/// @brief Spawns the workers and waits for each to import the entry point.
+	/// @throws std::invalid_argument if a worker cannot import the module or entry point,
+	/// or runs another Python version than python_version.
+	/// @throws std::runtime_error / std::system_error if a worker cannot be started.
+	explicit ProcessPool(const Options& options);
+	~ProcessPool();
+	ProcessPool(const ProcessPool&) = delete;
+	ProcessPool& operator=(const ProcessPool&) = delete;
+
+	/// @brief Whether a live worker can take another batch.
+	bool has_capacity() const;
+
+	/// @brief Whether a payload of this size can ever fit in a request ring.
+	bool fits(size_t payload_bytes) const;
+
+	/// @brief Queues a pickled batch on the least-loaded live worker with ring space.
+	/// @return false if no worker can take it right now.
+	bool try_submit(uint64_t batch_id, const void* data, size_t size);
+
+	/// @brief Reports every completed batch without blocking.
+	/// @tparam OnComplete Callable: (uint64_t batch_id, Status, std::string_view payload)
+	/// @return Number of completions reported.
+	template <typename OnComplete>
+	size_t poll(OnComplete&& on_complete);
+
+	/// @brief Blocks until a worker rings its doorbell or the timeout elapses.
+	void wait(std::chrono::milliseconds timeout) const;
+
+	/// @brief Number of batches submitted but not yet reported by poll.
+	size_t inflight() const;
+
+	/// @brief Number of workers that have not exited.
+	size_t live_workers() const;
+
+private:
+	struct Worker {
+		pid_t pid = -1;
+		ShmRing requests;
+		ShmRing responses;
+		/// Parent end of the doorbell socketpair.
+		int bell = -1;
+		std::vector<uint64_t> inflight;
+		bool alive = true;
+	};
+
+	void spawn(Worker& worker, const Options& options);
+	void await_ready(Worker& worker, std::chrono::steady_clock::time_point deadline);
+	/// @brief Drains pending doorbell bytes; returns true if the worker closed its end.
+	static bool drain_bell(int bell);
+	/// @brief Lets workers exit on their own for up to grace, then terminates and kills the
+	/// rest; a zero grace kills at once. Reaps every worker.
+	void shutdown(std::chrono::milliseconds grace);
+
+	std::vector<Worker> _workers;
+	std::chrono::milliseconds _shutdown_grace;
+	std::string _scratch;
+};
+
+} // namespace pyscheduler
+
+#include "pyscheduler/details/process_pool_impl.hpp"
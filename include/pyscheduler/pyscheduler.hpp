@@ -1,21 +1,34 @@
 #pragma once
+#include "pyscheduler/affinity.hpp"
+#include "pyscheduler/fixed_ring.hpp"
+#include "pyscheduler/frame_profiler.hpp"
+#include "pyscheduler/gil_profiler.hpp"
 #include "pyscheduler/library_export.hpp"
+#include "pyscheduler/metrics.hpp"
 #include "pyscheduler/move_only.hpp"
+#include "pyscheduler/output_buffer.hpp"
+#include "pyscheduler/process_pool.hpp"
+#include "pyscheduler/recorder.hpp"
+#include "pyscheduler/result_stream.hpp"
+#include "pyscheduler/trace.hpp"
 
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <deque>
+#include <functional>
 #include <future>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <span>
 #include <cstdint>
 #include <pybind11/embed.h>
 #include <pybind11/pybind11.h>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include <concurrentqueue.h>
@@ -39,6 +52,126 @@ namespace pyscheduler {
 /// a thread pool to asynchronously invoke Python functions; optimizing GIL usage.
 class PYSCHEDULER_LIBRARY_EXPORT PyManager {
 public:
+	/// @brief Interpreter settings (PyConfig) applied when the process's interpreter boots.
+	///
+	/// The interpreter is initialized once per process, by the first start_interpreter call
+	/// or PyManager construction; options passed afterwards are ignored, except preimport.
+	struct StartupOptions {
+		/// Isolated mode: ignore PYTHON* environment variables and the user site directory,
+		/// and leave the current directory out of sys.path.
+		bool isolated = false;
+		/// Do not import site at startup (python -S), skipping site-packages .pth processing.
+		/// Third-party packages then need module_search_paths or add_path.
+		bool skip_site = false;
+		/// Bytecode optimization level: 1 strips asserts (python -O), 2 also docstrings.
+		int optimization_level = 0;
+		/// Fixed PYTHONHASHSEED; unset keeps the interpreter's default (randomized, or the
+		/// environment's PYTHONHASHSEED outside isolated mode).
+		std::optional<unsigned long> hash_seed;
+		/// Preset sys.path, replacing the computed one. When empty, the computed sys.path
+		/// is kept and "." appended to it.
+		std::vector<std::string> module_search_paths;
+		/// Modules imported on the interpreter thread once it has booted, before the
+		/// start_interpreter future (or the PyManager constructor) returns, so handlers do
+		/// not pay their import cost on first load. Honored on every call; a failing import
+		/// fails that call only.
+		std::vector<std::string> preimport;
+	};
+
+	/// @brief Outcome of a handler's warmup; see HandlerOptions::warmup_function.
+	struct WarmupReport {
+		/// Wall time from the worker starting the warmup until it was ready to serve.
+		std::chrono::nanoseconds total{ 0 };
+		/// Time spent in the module's warmup function, if one was configured.
+		std::chrono::nanoseconds function{ 0 };
+		/// Duration of the entry point call at each warmup batch size, in the order run.
+		std::vector<std::pair<size_t, std::chrono::nanoseconds>> batches;
+	};
+
+	/// @brief Per-handler configuration accepted by loadPythonModule.
+	struct HandlerOptions {
+		/// Number of items per batched Python call.
+		size_t batch_size = 1;
+		/// Number of batches to pre-commit as pybind11 objects.
+		size_t prefetch_depth = 1;
+		/// Load the module into a dedicated subinterpreter with its own GIL (PEP 684,
+		/// Python 3.12+) so the handler runs in parallel with every other handler.
+		/// Isolated handlers only accept queue_invoke; commit functions and callbacks run
+		/// on the handler's interpreter and must not use pybind11::gil_scoped_acquire.
+		/// Extension modules imported by the entry point must support subinterpreters.
+		bool isolated_interpreter = false;
+		/// Execute batches in this many out-of-process Python workers instead of the
+		/// embedded interpreter. Committed batches and result lists are pickled and
+		/// exchanged through shared-memory rings; synchronous invoke still runs in-process.
+		/// 0 keeps execution in-process.
+		size_t worker_processes = 0;
+		/// Data capacity of each worker's request and response ring; bounds one pickled batch.
+		size_t worker_ring_bytes = size_t{ 16 } << 20;
+		/// Python executable spawned for worker processes; a name without a slash is
+		/// resolved through PATH. Empty uses the embedded interpreter's sys.executable. It
+		/// must run the embedded Python version, or the handler fails to load.
+		std::string worker_python;
+		/// Label identifying the handler in metrics; defaults to "module.entry_point".
+		std::string name;
+		/// Batches an `async def` entry point may have running at once. The worker runs
+		/// the returned coroutines as tasks on its own asyncio event loop, keeps assembling
+		/// batches while fewer than this many are running, and fans each batch out as its
+		/// task finishes. Values above 1 are rejected with worker_processes.
+		size_t max_inflight_batches = 1;
+		/// CPU set, NUMA node and memory policy of the handler's worker thread, which commits,
+		/// executes and completes its requests. Empty uses PyManager::set_default_worker_affinity.
+		ThreadAffinity worker_affinity;
+		/// When the entry point raises, re-run the failed batch in halves, recursively, so the
+		/// exception only fails the item(s) that reproduce it alone and every other item
+		/// completes normally. A batch with one bad item costs about 2*log2(batch_size) extra
+		/// calls; see QueueStats::bisect_retries. Requires an entry point without side effects
+		/// on retry. Applies to plain entry points only: not to async def or streaming ones,
+		/// and not supported with worker_processes.
+		bool bisect_failed_batches = false;
+		/// Route synchronous invoke through the worker instead of calling the entry point
+		/// on the caller's thread. Each call becomes one item of the next batch, taken from
+		/// a priority lane ahead of queued requests, and the caller blocks until the worker
+		/// has run its callback; it never takes the GIL itself. The entry point then sees
+		/// invoke calls under the batched contract of queue_invoke: a single argument is
+		/// cast to Python, several are packed into a tuple. Also enables invoke on isolated
+		/// handlers. Calling invoke from one of the handler's own callbacks deadlocks.
+		bool invoke_via_worker = false;
+		/// Debug hook the worker calls after fanning out each batch, with the batch's size.
+		/// Runs on the worker thread with the GIL held, so it sees the worker's thread-local
+		/// state (e.g. a heap allocation counter) between consecutive batches. Keep it cheap.
+		std::function<void(size_t)> batch_hook;
+
+		/// Module-level function the worker calls with no arguments before serving any
+		/// request, e.g. "warmup". If it returns an iterable, its items form the
+		/// representative batches below when warmup_batch is unset. Empty disables it.
+		std::string warmup_function;
+		/// Builds a representative batch of the requested size. Before serving, the entry
+		/// point is called once with a batch of each warmup_batch_sizes and the results are
+		/// discarded. Runs on the worker with the GIL held; must not capture Python objects,
+		/// since options are copied without the GIL.
+		std::function<pybind11::list(size_t)> warmup_batch;
+		/// Batch sizes to warm up with; defaults to { batch_size }.
+		std::vector<size_t> warmup_batch_sizes;
+
+		/// Batching key of a committed item, e.g. a hash of (shape, dtype, device). When set,
+		/// every batch the entry point receives holds items of a single key. Runs on the
+		/// worker with the GIL held right after commit; an exception fails that item only.
+		/// Same capture rules as warmup_batch. queue_invoke_keyed overrides it per item.
+		std::function<uint64_t(const pybind11::object&)> batch_key;
+		/// Longest a buffered item may wait for its key to be picked. The worker normally
+		/// runs the key with the most buffered items; once the oldest item has waited this
+		/// long, its key goes next regardless of size.
+		std::chrono::microseconds batch_key_max_wait{ 1000 };
+	};
+
+	/// @brief One entry point of a pipeline built by loadPipeline.
+	struct PipelineStage {
+		std::string module_name;
+		std::string entry_point = "invoke";
+		/// Items per call of this stage; 0 passes the stage every item it receives at once.
+		size_t batch_size = 0;
+	};
+
 	/// @brief Handles the invocation of a predefined python function from a loaded module
 	///
 	/// The InvokeHandler class is tightly coupled with PyManager so that the lifetime of
@@ -53,7 +186,8 @@ public:
 		/// @brief Synchronously invokes the Python function with given arguments.
 		///
 		///	This method acquires the GIL and calls the Python function, then casts the result into the
-		/// specified return type.
+		/// specified return type. With HandlerOptions::invoke_via_worker the call runs as one
+		/// item of a batch on the worker instead, and the result is cast there.
 		///
 		/// @tparam ReturnType The expected return type after casting the Python result.
 		/// @tparam Args Types of the arguments to be forwarded to the Python function.
@@ -65,7 +199,9 @@ public:
 		/// @brief Synchronously invokes the Python function and processes its result with a callback.
 		///
 		/// This method acquires the GIL, calls the Python function with the provided arguments,
-		/// and then passes the result to a user-specified callback function.
+		/// and then passes the result to a user-specified callback function. With
+		/// HandlerOptions::invoke_via_worker the callback runs on the worker and must return a
+		/// C++ type, as with queue_invoke.
 		///
 		///  @tparam Callback Callable type that accepts a pybind11::object.
 		///  @tparam Args Types of the arguments to be forwarded to the Python function.
@@ -95,6 +231,58 @@ public:
 		auto queue_invoke(CommitFn&& commit, Callback&& callback, Args&&... args)
 			-> std::future<std::invoke_result_t<Callback, pybind11::object>>;
 
+		/// @brief Like queue_invoke, but the item is only batched with items of the same key.
+		///
+		/// Switches the handler to keyed batching (see HandlerOptions::batch_key); items
+		/// queued without a key share key 0 and the handler's batch_key, if any, is not
+		/// applied to this item.
+		///
+		/// @param key Batching key, e.g. a hash of the item's shape and dtype.
+		template <typename CommitFn, typename Callback, typename... Args>
+		auto queue_invoke_keyed(uint64_t key,
+								CommitFn&& commit,
+								Callback&& callback,
+								Args&&... args)
+			-> std::future<std::invoke_result_t<Callback, pybind11::object>>;
+
+		/// @brief Enqueues a request whose results arrive incrementally.
+		///
+		/// For entry points that are generators (or return an iterator): instead of a list,
+		/// the entry point yields `(index, partial_result)` pairs while the batch runs, where
+		/// index is the item's position in the batch. Each partial result is converted by
+		/// on_partial on the worker, with the GIL held, and handed to the returned stream at
+		/// once; the stream ends when the generator is exhausted, or carries its exception.
+		/// queue_invoke requests batched with it complete with their last partial result
+		/// (None if they got none). An entry point that returns a list delivers each item as
+		/// a single partial result.
+		///
+		/// @tparam PartialFn Callable: (pybind11::object) -> T
+		/// @param commit Function that converts C++ args into a pybind11::object.
+		/// @param on_partial Converts one partial result into a pure C++ value.
+		/// @param args Arguments to forward to the commit function.
+		/// @throws std::logic_error on handlers that run in worker processes.
+		template <typename CommitFn, typename PartialFn, typename... Args>
+		auto queue_invoke_stream(CommitFn&& commit, PartialFn&& on_partial, Args&&... args)
+			-> ResultStream<std::invoke_result_t<PartialFn, pybind11::object>>;
+
+		/// @brief Enqueues a request whose result is written straight into caller-owned memory.
+		///
+		/// The worker copies the item's result into destination with copyResultInto (buffer
+		/// protocol, DLPack or a sequence of numbers) in one pass, with the GIL held, and then
+		/// marks the request done in group; no future or callback is created per item. An item
+		/// whose result does not fit destination fails with std::invalid_argument, which
+		/// group.wait() rethrows. destination must stay valid until the group has completed.
+		///
+		/// @param commit Function that converts C++ args into a pybind11::object.
+		/// @param destination Row that receives this item's result.
+		/// @param group Completion group the request is added to.
+		/// @param args Arguments to forward to the commit function.
+		template <typename T, typename CommitFn, typename... Args>
+		void queue_invoke_into(CommitFn&& commit,
+							   std::span<T> destination,
+							   CompletionGroup& group,
+							   Args&&... args);
+
 		~InvokeHandler();
 		InvokeHandler(InvokeHandler&& other) noexcept;
 		InvokeHandler& operator=(InvokeHandler&& other) noexcept;
@@ -108,6 +296,16 @@ public:
 			size_t execute_queue_size = 0;
 			/// Total number of items ever enqueued via queue_invoke.
 			std::int64_t total_enqueued = 0;
+			/// Items answered so far: executed in a finished batch or failed at commit.
+			std::int64_t total_completed = 0;
+			/// Failed batches re-run in halves (HandlerOptions::bisect_failed_batches).
+			std::int64_t bisected_batches = 0;
+			/// Extra entry point calls made while bisecting.
+			std::int64_t bisect_retries = 0;
+			/// Nanoseconds spent in those extra calls.
+			std::int64_t bisect_python_ns = 0;
+			/// Items failed by bisection, i.e. items that raised when run alone.
+			std::int64_t bisect_failed_items = 0;
 			/// EMA of the number of items processed per commit phase.
 			double commit_batch_size_ema = 0.0;
 			/// EMA of the number of items processed per execute phase.
@@ -121,23 +319,98 @@ public:
 		/// @brief Snapshot of queue depths and worker timing statistics.
 		QueueStats get_queue_stats() const;
 
+		/// @brief Items enqueued but not answered yet, including the batch being executed.
+		/// Lock-free; meant for dispatch decisions across handlers.
+		size_t outstanding() const;
+
+		/// @brief Snapshot of this handler's per-phase latency and batch size distributions.
+		HandlerMetricsSnapshot get_metrics() const;
+
+		/// @brief GIL wait, scope and CPU time charged to this handler by its worker and by
+		/// synchronous invoke. Also part of get_metrics(); see GilProfiler.
+		GilStats get_gil_stats() const;
+
+		/// @brief Profiles the Python frames of the next `batches` batches the worker executes
+		/// and resolves to their folded stacks (see FrameProfiler), rooted at the handler name.
+		/// The future resolves early with what was recorded if the handler shuts down, and
+		/// with an empty string if it shuts down before running another batch.
+		/// @throws std::invalid_argument if batches is 0.
+		/// @throws std::logic_error if a profile is already running on this handler, or the
+		/// handler runs in worker processes.
+		std::future<std::string> profile_python(size_t batches);
+
+		/// @brief Records every request committed from now on to recorder: its arrival time,
+		/// its committed object as serialized by serialize (pickle.dumps by default) and its
+		/// per-phase timings, written once its callback has run. Replaces an active
+		/// recording. serialize runs on the worker with the GIL held, once per request: it is
+		/// kept out of the recorded commit timings, but its cost (a pickle.dumps by default)
+		/// delays every request behind it and lowers the handler's throughput while
+		/// recording, so pass a cheap serializer for large objects. A request whose object
+		/// fails to serialize is counted by TrafficRecorder::dropped. See replay_traffic.
+		/// @throws std::logic_error if the handler runs in worker processes.
+		void start_recording(std::shared_ptr<TrafficRecorder> recorder,
+							 std::function<std::string(pybind11::handle)> serialize = {});
+
+		/// @brief Stops recording; requests committed while recording are still written.
+		void stop_recording();
+
+		/// @brief Resolves once the handler's warmup has run, immediately for handlers without
+		/// one. Requests queued before then wait and are served afterwards; get() blocks until
+		/// the handler is warm and rethrows a warmup failure (the handler serves regardless).
+		std::shared_future<WarmupReport> ready() const;
+
 	private:
 		struct QueueEntry {
 			MoveOnlyFunction<pybind11::object()> commit;
 			MoveOnlyFunction<void(pybind11::object)> on_result;
 			MoveOnlyFunction<void(std::exception_ptr)> on_error;
+			std::chrono::steady_clock::time_point enqueued;
+			/// Tracer request id, or 0 when tracing was off at enqueue time.
+			uint64_t trace_id = 0;
+			/// Batching key given to queue_invoke_keyed; has_key is false for queue_invoke.
+			uint64_t key = 0;
+			bool has_key = false;
+			/// Set for queue_invoke_stream requests; receives each partial result.
+			MoveOnlyFunction<void(pybind11::object)> on_partial;
 		};
 
 		struct CommittedEntry {
 			pybind11::object committed_obj;
 			MoveOnlyFunction<void(pybind11::object)> on_result;
 			MoveOnlyFunction<void(std::exception_ptr)> on_error;
+			std::chrono::steady_clock::time_point enqueued;
+			std::chrono::steady_clock::time_point committed;
+			uint64_t trace_id = 0;
+			uint64_t key = 0;
+			MoveOnlyFunction<void(pybind11::object)> on_partial;
+			/// Set when the item was committed while recording; payload is its serialized
+			/// committed object.
+			std::shared_ptr<const details::RecordingTarget> recording;
+			std::string payload;
+			/// Synchronous invoke routed through the worker; kept at the front of the buffer.
+			bool priority = false;
 		};
 
 		struct WorkerState {
 			moodycamel::ConcurrentQueue<QueueEntry> commit_queue;
+			/// Synchronous invoke calls; see HandlerOptions::invoke_via_worker.
+			moodycamel::ConcurrentQueue<QueueEntry> priority_queue;
+			bool invoke_via_worker = false;
+			/// Wakes an idle worker early when a priority entry arrives.
+			std::mutex wake_mutex;
+			std::condition_variable wake;
+			/// Thread state of the handler's own subinterpreter, or nullptr for the main one.
+			PyThreadState* interpreter = nullptr;
 			std::atomic<size_t> execute_queue_size{ 0 };
 			std::atomic<std::int64_t> total_enqueued{ 0 };
+			std::atomic<std::int64_t> total_completed{ 0 };
+			/// Batch bisection; see HandlerOptions::bisect_failed_batches.
+			bool bisect_failed_batches = false;
+			std::atomic<std::int64_t> bisected_batches{ 0 };
+			std::atomic<std::int64_t> bisect_retries{ 0 };
+			std::atomic<std::int64_t> bisect_python_ns{ 0 };
+			std::atomic<std::int64_t> bisect_failed_items{ 0 };
+			std::function<void(size_t)> batch_hook;
 
 			mutable std::mutex stats_mutex;
 			double commit_batch_size_ema = 0.0;
@@ -146,19 +419,195 @@ public:
 			double execute_ns_per_batch_ema = 0.0;
 			bool has_commit_sample = false;
 			bool has_execute_sample = false;
+
+			/// Out-of-process executors, when HandlerOptions::worker_processes > 0.
+			std::unique_ptr<ProcessPool> process_pool;
+
+			std::string name;
+			uint64_t id = 0;
+			ThreadAffinity affinity;
+			HandlerHistograms histograms;
+			GilCounters gil;
+
+			/// profile_python request; profile_busy is set until the worker delivers it.
+			std::mutex profile_mutex;
+			size_t profile_batches = 0;
+			std::promise<std::string> profile_result;
+			std::atomic<bool> profile_busy{ false };
+
+			/// Traffic recording; recording_on is checked before taking the mutex.
+			std::mutex recording_mutex;
+			std::shared_ptr<const details::RecordingTarget> recording;
+			std::atomic<bool> recording_on{ false };
+
+			/// Warmup run by the worker before its first batch; see HandlerOptions.
+			std::string module_name;
+			std::string warmup_function;
+			std::function<pybind11::list(size_t)> warmup_batch;
+			std::vector<size_t> warmup_batch_sizes;
+			std::promise<WarmupReport> warmup_done;
+			std::shared_future<WarmupReport> ready;
+
+			/// Keyed batching; keyed is set once batch_key exists or a keyed item arrives.
+			std::function<uint64_t(const pybind11::object&)> batch_key;
+			std::chrono::nanoseconds batch_key_max_wait{ 0 };
+			std::atomic<bool> keyed{ false };
+			/// Worker-only scratch of (key, buffered items), reused across batches.
+			std::vector<std::pair<uint64_t, size_t>> key_counts;
+			/// Cleared when the handler shuts down; checked by pyscheduler.submit.
+			std::shared_ptr<std::atomic<bool>> active;
+			/// Set by the worker once it takes no more entries. pyscheduler.submit enqueues
+			/// under submit_mutex, so nothing lands after the worker's final drain.
+			std::mutex submit_mutex;
+			bool closed = false;
+			bool isolated = false;
+			/// asyncio event loop of async def entry points; worker-only, created on first use.
+			pybind11::object event_loop;
+			size_t max_inflight_batches = 1;
+			/// Enqueue time (steady_clock ns) of the oldest unexecuted item; 0 if none.
+			std::atomic<std::int64_t> oldest_pending_ns{ 0 };
+
+			/// @brief Entries waiting in both lanes; approximate, like size_approx.
+			size_t queued() const;
+			/// @brief Parks an idle worker for up to 5 ms, or until a priority entry arrives.
+			void idle_wait();
+			void record_commit(size_t count, double ns);
+			void record_execute(size_t count, double ns);
+			void record_batch(size_t count, uint64_t execute_ns, uint64_t fanout_ns);
+			/// @brief Republishes oldest_pending_ns from the prefetch buffer. When the buffer is
+			/// empty but the commit queue is not, falls back to last_taken (the newest item
+			/// already dequeued, which bounds the age of the rest) or keeps the current value.
+			void publish_oldest(const details::FixedRing<CommittedEntry>& prefetch_buffer,
+								std::optional<std::chrono::steady_clock::time_point> last_taken);
+		};
+
+		/// @brief What an isolated worker needs to resolve its callable inside its own
+		/// subinterpreter.
+		struct SubinterpreterSpec {
+			std::string module_name;
+			std::string entry_point;
+			/// sys.path of the main interpreter at load time, replayed in the subinterpreter.
+			std::vector<std::string> sys_path;
+		};
+
+		/// @brief Holds the GIL of the handler's interpreter for the enclosing scope: the
+		/// main interpreter through pybind11, or the handler's subinterpreter if attached.
+		/// Unless the thread already held the GIL, the acquisition is reported to GilProfiler
+		/// and charged to counters when given.
+		class PYSCHEDULER_LIBRARY_LOCAL ScopedGil {
+		public:
+			explicit ScopedGil(PyThreadState* tstate, GilCounters* counters = nullptr);
+			~ScopedGil();
+			ScopedGil(const ScopedGil&) = delete;
+			ScopedGil& operator=(const ScopedGil&) = delete;
+
+		private:
+			PyThreadState* _tstate;
+			std::optional<pybind11::gil_scoped_acquire> _main;
+			GilCounters* _counters;
+			bool _profiled = false;
+			uint64_t _wait_ns = 0;
+			std::chrono::steady_clock::time_point _acquired;
+			uint64_t _cpu_start_ns = 0;
 		};
 
 		InvokeHandler(size_t id,
 					  std::shared_ptr<pybind11::object> resource,
 					  std::unique_ptr<PyManager> manager,
-					  size_t batch_size,
-					  size_t prefetch_depth);
+					  const HandlerOptions& options,
+					  const std::string& module_name,
+					  std::optional<SubinterpreterSpec> isolation = std::nullopt,
+					  std::unique_ptr<ProcessPool> process_pool = nullptr);
+
+		/// @brief The worker's asyncio event loop, created on first use. Requires the GIL.
+		static pybind11::object& eventLoop(WorkerState& state);
+
+		/// @brief Runs the configured warmup on the worker and resolves warmup_done.
+		/// Requires the GIL of the handler's interpreter.
+		static void runWarmup(WorkerState& state, pybind11::object& resource, size_t batch_size);
+
+		static HandlerMetricsSnapshot snapshotMetrics(const WorkerState& state);
+
+		/// @brief Applies the handler's affinity to the calling worker thread. The affinity is
+		/// validated at construction, so a failure here is only reported.
+		static void pinWorker(const WorkerState& state);
+
+		/// @brief Phase 1: commits queued entries into the prefetch buffer until it is full.
+		static void commitPhase(WorkerState& state,
+								details::FixedRing<CommittedEntry>& prefetch_buffer);
+
+		/// @brief Picks the next batch: moves up to batch_size entries of one key to the front
+		/// of the prefetch buffer, keeping order within and across keys, and returns how many.
+		/// Unkeyed handlers take the front batch_size entries as-is.
+		static size_t selectBatch(WorkerState& state,
+								  details::FixedRing<CommittedEntry>& prefetch_buffer,
+								  size_t batch_size);
+
+		/// @brief Type-erases a commit function and its arguments.
+		template <typename CommitFn, typename... Args>
+		static MoveOnlyFunction<pybind11::object()> makeCommit(CommitFn&& commit, Args&&... args);
+
+		/// @brief Stamps an entry with its enqueue time and trace id and publishes it, on the
+		/// priority lane if priority is set.
+		void submit(QueueEntry entry);
+		static void submitTo(WorkerState& state, QueueEntry entry, bool priority = false);
+		/// @brief Closes the worker's queues and fails entries published after its last pass.
+		/// Requires the GIL.
+		static void closeQueues(WorkerState& state);
+
+		/// @brief Synchronous invoke routed through the worker's priority lane; blocks until
+		/// callback has run on the worker.
+		template <typename Callback, typename... Args>
+		auto invokeOnWorker(Callback&& callback, Args&&... args)
+			-> std::invoke_result_t<Callback, pybind11::object>;
+
+		/// @brief Drains a streaming entry point's (index, partial_result) pairs, forwarding
+		/// each to its item's partial callback, and returns the last partial result of every
+		/// item (None if it got none). Requires the GIL.
+		/// @throws std::out_of_range for an index outside the batch.
+		static pybind11::list drainStream(
+			pybind11::object iterator,
+			std::vector<MoveOnlyFunction<void(pybind11::object)>>& partial_callbacks);
+
+		/// @brief Re-runs items[begin, end) of a failed batch in halves until every failure is
+		/// pinned to single items. Fills results for the items of halves that succeed and
+		/// errors for the items that raise alone. Requires the GIL.
+		static void bisectBatch(WorkerState& state,
+								pybind11::object& resource,
+								pybind11::handle items,
+								size_t begin,
+								size_t end,
+								pybind11::list& results,
+								std::vector<std::exception_ptr>& errors);
+
+		template <typename CommitFn, typename Callback, typename... Args>
+		auto enqueue(std::optional<uint64_t> key,
+					 CommitFn&& commit,
+					 Callback&& callback,
+					 Args&&... args)
+			-> std::future<std::invoke_result_t<Callback, pybind11::object>>;
 
 		static void workerLoop(std::shared_ptr<WorkerState> state,
 							   std::shared_ptr<pybind11::object> resource,
 							   size_t batch_size,
 							   size_t prefetch_depth,
 							   std::shared_ptr<std::atomic<bool>> active);
+
+		/// @brief Worker loop for handlers backed by a ProcessPool: pickles batches into the
+		/// workers' request rings and fans results out as they come back.
+		static void processWorkerLoop(std::shared_ptr<WorkerState> state,
+									  size_t batch_size,
+									  size_t prefetch_depth,
+									  std::shared_ptr<std::atomic<bool>> active);
+
+		/// @brief Worker entry point for isolated handlers: creates the subinterpreter,
+		/// resolves the callable inside it, runs workerLoop, then tears the interpreter down.
+		static void isolatedWorkerMain(std::shared_ptr<WorkerState> state,
+									   SubinterpreterSpec spec,
+									   size_t batch_size,
+									   size_t prefetch_depth,
+									   std::shared_ptr<std::atomic<bool>> active,
+									   std::promise<void> ready);
 	
 	private:
 		// prevents PyManager destructor from finalizing the interpreter until all InvokeHandlers go out of scope
@@ -168,13 +617,83 @@ public:
 		std::shared_ptr<pybind11::object> _resource;
 		size_t _batch_size = 1;
 		size_t _prefetch_depth = 1;
+		bool _isolated = false;
 		std::shared_ptr<std::atomic<bool>> _active;
 		std::shared_ptr<WorkerState> _state;
 		std::thread _worker;
 	};
 
+	/// @brief Several InvokeHandlers bound to the same Python callable behind one
+	/// queue_invoke, for entry points that release the GIL in their kernels (torch, numpy)
+	/// and can run on several workers at once.
+	///
+	/// Each request goes to the replica with the least outstanding work; ties rotate.
+	/// Every replica keeps its own queue, batching, metrics and warmup.
+	class PYSCHEDULER_LIBRARY_EXPORT ReplicatedHandler {
+		friend PyManager;
+
+	public:
+		/// @brief Enqueues on the least-loaded replica; see InvokeHandler::queue_invoke.
+		template <typename CommitFn, typename Callback, typename... Args>
+		auto queue_invoke(CommitFn&& commit, Callback&& callback, Args&&... args)
+			-> std::future<std::invoke_result_t<Callback, pybind11::object>>;
+
+		/// @brief Number of replicas.
+		size_t size() const;
+
+		/// @brief The i-th replica, e.g. for its metrics or GIL statistics.
+		InvokeHandler& replica(size_t index);
+		const InvokeHandler& replica(size_t index) const;
+
+		/// @brief Queue statistics of every replica, in replica order.
+		std::vector<InvokeHandler::QueueStats> get_replica_stats() const;
+
+		/// @brief Queue statistics summed over all replicas; the EMAs are averaged.
+		InvokeHandler::QueueStats get_queue_stats() const;
+
+	private:
+		explicit ReplicatedHandler(std::vector<InvokeHandler> replicas);
+
+		/// @brief The replica with the fewest outstanding items, scanning from the next
+		/// position in the rotation.
+		InvokeHandler& pickReplica();
+
+		std::vector<InvokeHandler> _replicas;
+		std::unique_ptr<std::atomic<size_t>> _next;
+	};
+
+	/// @brief Copyable reference to an InvokeHandler registered process-wide by loadShared.
+	///
+	/// Every handle for the same entry point and configuration, in any module of the process
+	/// (including plugin DSOs), feeds the same queue and worker, so all producers contribute
+	/// to the same batches. The handler stops once the last handle is released, which must
+	/// not happen from one of its own callbacks, and the module that created it must stay
+	/// loaded until then.
+	class PYSCHEDULER_LIBRARY_EXPORT SharedHandler {
+		friend PyManager;
+
+	public:
+		InvokeHandler& operator*() const;
+		InvokeHandler* operator->() const;
+
+		/// @brief Number of handles referencing the handler.
+		long use_count() const;
+
+	private:
+		explicit SharedHandler(std::shared_ptr<InvokeHandler> handler);
+
+		std::shared_ptr<InvokeHandler> _handler;
+	};
+
 public:
+	/// @brief Attaches to the process's interpreter, booting it with default StartupOptions
+	/// if it is not running yet. Blocks until the interpreter is ready.
+	/// @throws std::runtime_error if the interpreter failed to start.
 	PyManager();
+	/// @brief Attaches to the process's interpreter, booting it with options if it is not
+	/// running yet. Blocks until the interpreter is ready.
+	/// @throws std::runtime_error if the interpreter failed to start.
+	explicit PyManager(const StartupOptions& options);
 	PyManager(const PyManager& udl_manager) = delete;
 	PyManager(PyManager&& udl_manager) = delete;
 
@@ -183,6 +702,17 @@ public:
 	PyManager operator=(PyManager&& udl_manager) = delete;
 
 public:
+	/// @brief Starts booting the interpreter with options on its own thread and returns
+	/// without waiting, so a service can overlap interpreter startup with its own
+	/// initialization. The future resolves once the interpreter is ready and rethrows a
+	/// startup failure; a PyManager constructed meanwhile waits for the same boot.
+	static std::shared_future<void> start_interpreter(const StartupOptions& options);
+	static std::shared_future<void> start_interpreter();
+
+	/// @brief Constructs a PyManager without blocking the caller; see start_interpreter.
+	static std::future<std::unique_ptr<PyManager>> create_async(const StartupOptions& options);
+	static std::future<std::unique_ptr<PyManager>> create_async();
+
 	/// @brief Loads a Python module and its entry point, or retrieves an existing one.
 	/// @param module_name Name of the Python module to load.
 	/// @param entry_point Function name to retrieve from the module.
@@ -194,16 +724,111 @@ public:
 								   size_t batch_size = 1,
 								   size_t prefetch_depth = 1);
 
+	/// @brief Loads a Python module and its entry point with explicit handler options.
+	/// @param module_name Name of the Python module to load.
+	/// @param entry_point Function name to retrieve from the module.
+	/// @param options Batching and isolation settings for the handler.
+	/// @return An InvokeHandler for calling the specified function
+	InvokeHandler loadPythonModule(const std::string& module_name,
+								   const std::string& entry_point,
+								   const HandlerOptions& options);
+
+	/// @brief Chains entry points into a single handler. Each batch runs through every stage
+	/// in one GIL turn: a stage's outputs stay native Python objects and feed the next stage,
+	/// which is called in chunks of its own batch_size, and only the final stage's outputs
+	/// reach the C++ callbacks. Every stage must return one output per input, in order.
+	/// @param stages Entry points in execution order.
+	/// @param options Handler settings. The batch size is raised to the largest stage
+	/// batch_size; the name defaults to the stages' "module.entry_point" joined by "->";
+	/// warmup_function is looked up in the first stage's module.
+	/// @throws std::invalid_argument for an empty pipeline, a stage that cannot be resolved,
+	/// or isolated_interpreter / worker_processes, which pipelines do not support.
+	InvokeHandler loadPipeline(const std::vector<PipelineStage>& stages,
+							   const HandlerOptions& options);
+	InvokeHandler loadPipeline(const std::vector<PipelineStage>& stages);
+
+	/// @brief Loads `replicas` handlers for the same entry point behind one ReplicatedHandler.
+	/// They share the resolved callable; replica i is named "<name>[i]" in metrics.
+	/// @param options Settings applied to every replica.
+	/// @throws std::invalid_argument if replicas is 0.
+	ReplicatedHandler loadReplicated(const std::string& module_name,
+									 const std::string& entry_point,
+									 size_t replicas,
+									 const HandlerOptions& options);
+	ReplicatedHandler loadReplicated(const std::string& module_name,
+									 const std::string& entry_point,
+									 size_t replicas);
+
+	/// @brief Returns a handle to the process-wide handler of this entry point and options,
+	/// loading it on first use; see SharedHandler. Handlers are shared when every option
+	/// matches. Callables in options (warmup_batch, batch_key, batch_hook) cannot be
+	/// compared: only whether each is set is, and handlers that set the same ones share the
+	/// first registration's. Safe to call with the GIL held.
+	/// @throws as loadPythonModule.
+	SharedHandler loadShared(const std::string& module_name,
+							 const std::string& entry_point,
+							 const HandlerOptions& options);
+	SharedHandler loadShared(const std::string& module_name,
+							 const std::string& entry_point = "invoke",
+							 size_t batch_size = 1,
+							 size_t prefetch_depth = 1);
+
+	/// @brief Affinity of handler workers whose HandlerOptions::worker_affinity is empty.
+	/// Applies to handlers created afterwards.
+	/// @throws std::invalid_argument as resolveAffinityCpus.
+	static void set_default_worker_affinity(const ThreadAffinity& affinity);
+
+	/// @brief Restricts the thread that owns the interpreter (see mainLoop) to the CPUs of
+	/// affinity; its memory policy cannot be changed from outside that thread.
+	/// @throws std::invalid_argument as resolveAffinityCpus; std::system_error if the kernel
+	/// rejects the CPU set.
+	static void set_interpreter_affinity(const ThreadAffinity& affinity);
+
+	/// @brief Publishes size bytes at data to Python as `pyscheduler.buffer(name)`, a read-only
+	/// memoryview over the memory itself. Views hold owner, so the memory stays valid while
+	/// Python uses it, even after unregister_buffer. Replaces a buffer of the same name.
+	static void register_buffer(const std::string& name,
+								std::shared_ptr<const void> owner,
+								const void* data,
+								size_t size);
+	/// @brief register_buffer over the elements of a contiguous container (std::vector, ...).
+	template <typename Container>
+	static void register_buffer(const std::string& name, std::shared_ptr<Container> container);
+	/// @brief Withdraws a buffer from `pyscheduler.buffer`; views already taken stay valid.
+	/// @return false if no buffer had that name.
+	static bool unregister_buffer(const std::string& name);
+
+	/// @brief Populates the embedded `pyscheduler` module, which the interpreter imports at
+	/// startup. Called by the module's init function; requires the GIL.
+	///
+	/// From Python code running in the main interpreter:
+	/// - `pyscheduler.buffer(name)`: zero-copy view of a buffer registered with
+	///   register_buffer; raises KeyError for an unknown name.
+	/// - `pyscheduler.buffer_names()`: names of the registered buffers.
+	/// - `pyscheduler.submit(handler_name, obj)`: enqueues obj, already committed, on the
+	///   running handler with that name (HandlerOptions::name; the least loaded one if several
+	///   share it) and returns a concurrent.futures.Future of its result. Waiting on the future
+	///   from an entry point of the same handler deadlocks. Raises KeyError for an unknown
+	///   handler and ValueError for an isolated one.
+	static void define_embedded_module(pybind11::module_& module);
+
 	/// @brief Adds a directory to Python's module search path (sys.path).
 	/// @param directory Filesystem path to append if not already present.
 	void add_path(const std::string& directory);
 
+	/// @brief Snapshot of the metrics of every live InvokeHandler in the process; render it
+	/// with renderOpenMetrics to serve a scrape endpoint.
+	static MetricsSnapshot metrics_snapshot();
+
 	/// @brief Test/debug helper: returns process-unique shared-state address token.
 	static uintptr_t debug_shared_state_address();
 
 	/// @brief Test/debug helper: returns current live PyManager reference count.
 	static uint64_t debug_arc_count();
 
+	/// @brief Test/debug helper: returns the number of live per-handler subinterpreters.
+	static size_t debug_subinterpreter_count();
+
 private:
 	struct PYSCHEDULER_LIBRARY_LOCAL PyInvokeHandlerEntry {
 		pybind11::module_ module_;
@@ -211,6 +836,22 @@ private:
 		std::unordered_map<std::string, std::shared_ptr<pybind11::object>> handler_map;
 	};
 
+	/// @brief Memory published by register_buffer.
+	struct PYSCHEDULER_LIBRARY_LOCAL RegisteredBuffer {
+		std::shared_ptr<const void> owner;
+		const void* data = nullptr;
+		size_t size = 0;
+	};
+
+	/// @brief StartupOptions::preimport requests queued to the interpreter thread.
+	struct InterpreterJobs {
+		std::mutex mutex;
+		std::condition_variable wake;
+		std::deque<std::pair<std::vector<std::string>, std::promise<void>>> preimports;
+		/// Set when the interpreter failed to start; requests then get the startup error.
+		bool closed = false;
+	};
+
 	struct PYSCHEDULER_LIBRARY_LOCAL SharedState {
 		std::atomic<uint64_t> arc = 0;
 
@@ -219,6 +860,35 @@ private:
 
 		std::once_flag init_flag;
 		std::atomic<bool> interpreter_initialized = false;
+		/// @brief set by mainLoop once the interpreter is ready, or with its startup failure
+		std::promise<void> interpreter_promise;
+		std::shared_future<void> interpreter_ready;
+		/// @brief thread running mainLoop; valid once interpreter_initialized is set
+		pthread_t interpreter_thread{ };
+		/// @brief preimport requests run by mainLoop; shared with the parked thread
+		std::shared_ptr<InterpreterJobs> interpreter_jobs = std::make_shared<InterpreterJobs>();
+
+		std::mutex affinity_mutex;
+		ThreadAffinity default_worker_affinity;
+
+		/// @brief subinterpreters owned by isolated InvokeHandler workers
+		std::mutex subinterpreter_mutex;
+		std::unordered_set<PyInterpreterState*> subinterpreters;
+
+		/// @brief worker state of every InvokeHandler, for metrics_snapshot
+		std::mutex metrics_mutex;
+		std::vector<std::weak_ptr<InvokeHandler::WorkerState>> handler_states;
+		std::atomic<uint64_t> next_handler_id = 1;
+
+		/// @brief handlers of loadShared, by sharedHandlerKey; a slot is pending while its
+		/// first caller loads it
+		std::mutex shared_handlers_mutex;
+		std::unordered_map<std::string, std::shared_future<std::weak_ptr<InvokeHandler>>>
+			shared_handlers;
+
+		/// @brief buffers exposed to Python by register_buffer
+		std::mutex buffers_mutex;
+		std::unordered_map<std::string, RegisteredBuffer> buffers;
 	};
 
 	static SharedState _instance;
@@ -226,7 +896,30 @@ private:
 		return _instance;
 	}
 
-	static void mainLoop();
+	/// @brief Registry key of loadShared: the entry point and every comparable option.
+	static std::string sharedHandlerKey(const std::string& module_name,
+										const std::string& entry_point,
+										const HandlerOptions& options);
+
+	/// @brief Copies the main interpreter's sys.path. Requires the GIL.
+	static std::vector<std::string> sysPathSnapshot();
+
+	/// @brief Imports module_name (once) and returns its cached entry_point callable with the
+	/// callable's id within the module. Requires the GIL.
+	/// @throws std::invalid_argument if the module or the entry point cannot be found.
+	static std::pair<std::shared_ptr<pybind11::object>, size_t>
+	resolveEntryPoint(const std::string& module_name, const std::string& entry_point);
+
+	/// @brief Rejects an options.warmup_function missing from an imported module. Requires the GIL.
+	static void checkWarmupFunction(const std::string& module_name,
+									const HandlerOptions& options);
+
+	/// @brief Imports StartupOptions::preimport modules. Requires the GIL.
+	static void preimportModules(const std::vector<std::string>& modules);
+
+	/// @brief Boots the interpreter with options, resolves interpreter_promise and parks
+	/// the calling thread forever, running the preimport requests start_interpreter queues.
+	static void mainLoop(const StartupOptions& options);
 };
 
 } // namespace pyscheduler
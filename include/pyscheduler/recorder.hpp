@@ -0,0 +1,133 @@
+#pragma once
+#include "pyscheduler/library_export.hpp"
+#include "pyscheduler/metrics.hpp"
+#include <pybind11/pybind11.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pyscheduler {
+
+/// @brief One request captured by a TrafficRecorder. Times are nanoseconds.
+struct RecordedRequest {
+	/// queue_invoke time, relative to the recorder's creation.
+	std::int64_t arrival_ns = 0;
+	/// queue_invoke until the item's commit finished (queue wait plus commit).
+	uint64_t commit_ns = 0;
+	/// Commit finished until the item's batch started executing.
+	uint64_t hold_ns = 0;
+	/// The Python call of the item's batch.
+	uint64_t execute_ns = 0;
+	/// Python call finished until the item's callback returned.
+	uint64_t callback_ns = 0;
+	uint32_t batch_size = 0;
+	bool failed = false;
+	/// The committed object as produced by the recording's serializer.
+	std::string payload;
+
+	/// @brief End-to-end latency observed when the request was recorded.
+	uint64_t latency_ns() const {
+		return commit_ns + hold_ns + execute_ns + callback_ns;
+	}
+};
+
+/// @brief Appends RecordedRequests to a compact binary file; see
+/// InvokeHandler::start_recording.
+///
+/// The file is an 8-byte magic followed by one record per completed request, in completion
+/// order: the arrival as a zigzag varint delta from the previous record's arrival, the phase
+/// timings, batch size and failure flag as varints, then the payload length and bytes.
+/// Thread-safe; handler workers write as their batches complete.
+class PYSCHEDULER_LIBRARY_EXPORT TrafficRecorder {
+public:
+	static constexpr char kMagic[8] = { 'P', 'Y', 'S', 'R', 'E', 'C', '0', '1' };
+
+	/// @throws std::runtime_error if path cannot be opened for writing.
+	explicit TrafficRecorder(const std::string& path);
+	~TrafficRecorder();
+	TrafficRecorder(const TrafficRecorder&) = delete;
+	TrafficRecorder& operator=(const TrafficRecorder&) = delete;
+
+	void write(const RecordedRequest& request);
+	/// @brief Counts a request that could not be recorded, e.g. whose payload failed to
+	/// serialize.
+	void drop();
+	void flush();
+
+	/// @brief Zero point of arrival_ns.
+	std::chrono::steady_clock::time_point origin() const {
+		return _origin;
+	}
+	uint64_t recorded() const {
+		return _recorded.load(std::memory_order_relaxed);
+	}
+	uint64_t dropped() const {
+		return _dropped.load(std::memory_order_relaxed);
+	}
+
+private:
+	const std::chrono::steady_clock::time_point _origin;
+	std::mutex _mutex;
+	std::ofstream _file;
+	std::string _scratch;
+	std::int64_t _last_arrival_ns = 0;
+	std::atomic<uint64_t> _recorded{ 0 };
+	std::atomic<uint64_t> _dropped{ 0 };
+};
+
+/// @brief Reads every request of a TrafficRecorder file, in file order.
+/// @throws std::runtime_error if the file cannot be read, is not a recording or is
+/// truncated.
+std::vector<RecordedRequest> read_traffic(const std::string& path);
+
+struct ReplayOptions {
+	/// Arrival rate multiplier: 2 replays twice as fast as recorded, 0.5 at half speed.
+	double rate_scale = 1.0;
+	/// Rebuilds a committed object from its payload; runs on the handler's worker with the
+	/// GIL held. Defaults to pickle.loads, matching the recorder's default serializer.
+	std::function<pybind11::object(std::string_view)> deserialize;
+};
+
+struct ReplayReport {
+	size_t requests = 0;
+	size_t failed = 0;
+	/// First scheduled arrival until the last request completed.
+	std::chrono::nanoseconds duration{ 0 };
+	/// Worst lag of an actual enqueue behind its scheduled arrival; large values mean the
+	/// recorded rate could not be offered.
+	std::chrono::nanoseconds max_send_lag{ 0 };
+	/// Scheduled arrival until callback, for requests that succeeded.
+	HistogramSnapshot latency_ns;
+	/// RecordedRequest::latency_ns of the replayed requests, for comparison.
+	HistogramSnapshot recorded_latency_ns;
+};
+
+/// @brief Re-drives handler (an InvokeHandler, ReplicatedHandler or the target of a
+/// SharedHandler) with recorded requests on their recorded open-loop schedule, scaled by
+/// options.rate_scale. Latency is measured from each request's scheduled arrival, so a
+/// backed-up producer does not hide queueing delay. Blocks until every request completed.
+template <typename Handler>
+ReplayReport replay_traffic(Handler& handler,
+							const std::vector<RecordedRequest>& requests,
+							const ReplayOptions& options = {});
+
+namespace details {
+/// @brief An active recording of one handler; see InvokeHandler::start_recording.
+struct RecordingTarget {
+	std::shared_ptr<TrafficRecorder> recorder;
+	std::function<std::string(pybind11::handle)> serialize;
+};
+} // namespace details
+
+} // namespace pyscheduler
+
+#include "pyscheduler/details/recorder_impl.hpp"
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+namespace pyscheduler {
+
+namespace details {
+
+/// @brief Buffer between the worker producing partial results and a ResultStream.
+template <typename T>
+struct StreamChannel {
+	std::mutex mutex;
+	std::condition_variable ready;
+	std::deque<T> items;
+	bool closed = false;
+	std::exception_ptr error;
+
+	/// @brief Appends a partial result; ignored once the stream is closed.
+	void push(T item);
+	/// @brief Ends the stream, with error if the request failed. Only the first call counts.
+	void close(std::exception_ptr error = nullptr);
+};
+
+} // namespace details
+
+/// @brief Consumer end of a streaming request (see InvokeHandler::queue_invoke_stream): the
+/// partial results in the order the entry point yielded them, then the end of the stream or
+/// the request's error.
+///
+/// One consumer at a time. Iterating with a range-for blocks for each partial result:
+/// @code
+/// for(const std::string& token : handler.queue_invoke_stream(commit, toString, prompt)) {}
+/// @endcode
+template <typename T>
+class ResultStream {
+public:
+	explicit ResultStream(std::shared_ptr<details::StreamChannel<T>> channel);
+
+	/// @brief Blocks until the next partial result, or returns std::nullopt once the request
+	/// has completed. Rethrows the request's error after the partial results before it.
+	std::optional<T> next();
+
+	/// @brief The next partial result if one is buffered; never blocks. Use done() to tell
+	/// the end of the stream from a result that has not arrived yet.
+	std::optional<T> try_next();
+
+	/// @brief True once the request has completed and every partial result was consumed.
+	bool done() const;
+
+	class iterator {
+	public:
+		using iterator_category = std::input_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const T*;
+		using reference = const T&;
+
+		iterator() = default;
+		explicit iterator(ResultStream* stream);
+
+		reference operator*() const {
+			return *_current;
+		}
+		pointer operator->() const {
+			return &*_current;
+		}
+		iterator& operator++();
+		void operator++(int) {
+			++*this;
+		}
+		bool operator==(const iterator& other) const {
+			return _current.has_value() == other._current.has_value();
+		}
+
+	private:
+		ResultStream* _stream = nullptr;
+		std::optional<T> _current;
+	};
+
+	iterator begin() {
+		return iterator(this);
+	}
+	iterator end() {
+		return iterator();
+	}
+
+private:
+	std::shared_ptr<details::StreamChannel<T>> _channel;
+};
+
+} // namespace pyscheduler
+
+#include "pyscheduler/details/result_stream_impl.hpp"
@@ -0,0 +1,66 @@
+#pragma once
+#include "pyscheduler/library_export.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace pyscheduler {
+
+/// @brief Single-producer/single-consumer byte ring living in a memfd-backed shared mapping.
+///
+/// The mapping starts with a header holding the producer cursor, the consumer cursor and the
+/// data capacity (each on its own cache line), followed by the data area. A record is a
+/// 16-byte header (tag, status, payload length) followed by the payload, padded to 8 bytes;
+/// records may wrap around the end of the data area. Cursors are monotonically increasing
+/// byte counts. The Python worker bootstrap in process_pool mirrors this layout, so the
+/// producer and consumer may live in different processes.
+class PYSCHEDULER_LIBRARY_EXPORT ShmRing {
+public:
+	static constexpr size_t kHeadOffset = 0;
+	static constexpr size_t kTailOffset = 64;
+	static constexpr size_t kCapacityOffset = 128;
+	static constexpr size_t kDataOffset = 192;
+	static constexpr size_t kRecordHeaderBytes = 16;
+
+	/// @brief Creates a ring with at least capacity bytes of data space.
+	explicit ShmRing(size_t capacity);
+	~ShmRing();
+	ShmRing(ShmRing&& other) noexcept;
+	ShmRing& operator=(ShmRing&& other) noexcept;
+	ShmRing(const ShmRing&) = delete;
+	ShmRing& operator=(const ShmRing&) = delete;
+
+	/// @brief File descriptor of the backing memfd (close-on-exec); share it to map the ring.
+	int fd() const;
+
+	/// @brief Size of the data area in bytes.
+	size_t capacity() const;
+
+	/// @brief Bytes currently free for new records.
+	size_t free_bytes() const;
+
+	/// @brief Ring bytes consumed by a record carrying payload_bytes of payload.
+	static size_t record_size(size_t payload_bytes);
+
+	/// @brief Appends a record. Producer side only.
+	/// @return false if the ring does not currently have room for the record.
+	bool try_push(uint64_t tag, uint32_t status, const void* data, size_t size);
+
+	/// @brief Pops the oldest record, reusing payload's storage. Consumer side only.
+	/// @return false if the ring is empty.
+	bool try_pop(uint64_t& tag, uint32_t& status, std::string& payload);
+
+private:
+	void copy_in(uint64_t position, const void* src, size_t size);
+	void copy_out(uint64_t position, void* dst, size_t size) const;
+
+	int _fd = -1;
+	char* _base = nullptr;
+	size_t _capacity = 0;
+	size_t _mapped_bytes = 0;
+};
+
+} // namespace pyscheduler
+
+#include "pyscheduler/details/shm_ring_impl.hpp"
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "pyscheduler/dlpack_traits.hpp"
+#include "pyscheduler/library_export.hpp"
+#include <dlpack/dlpack.h>
+#include <pybind11/pybind11.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace pyscheduler {
+
+/// @brief memfd-backed host memory that can be mapped by other processes.
+///
+/// Allocation is a bump pointer; memory is returned to the system once the arena handle and
+/// every tensor carved from it are gone. Tensors hold a shared_ptr to their arena.
+class PYSCHEDULER_LIBRARY_EXPORT ShmArena {
+public:
+	/// @brief Creates a new anonymous shared-memory arena of the given size.
+	static std::shared_ptr<ShmArena> create(size_t capacity,
+											const std::string& name = "pyscheduler-tensor");
+
+	~ShmArena();
+	ShmArena(const ShmArena&) = delete;
+	ShmArena& operator=(const ShmArena&) = delete;
+
+	/// @brief Reserves bytes and returns their offset from the start of the memfd.
+	/// @throws std::bad_alloc if the arena is exhausted.
+	size_t allocate(size_t bytes, size_t alignment = 64);
+
+	/// @brief File descriptor of the backing memfd (close-on-exec).
+	int fd() const;
+	size_t capacity() const;
+	char* data() const;
+
+private:
+	ShmArena(int fd, char* base, size_t capacity);
+
+	int _fd;
+	char* _base;
+	size_t _capacity;
+	std::mutex _mutex;
+	size_t _used = 0;
+};
+
+/// @brief Everything another process needs to map a shared-memory tensor.
+///
+/// fd is only meaningful in the process that owns it; move it between processes with
+/// sendShmTensorDescriptor / receiveShmTensorDescriptor (SCM_RIGHTS).
+struct ShmTensorDescriptor {
+	int fd = -1;
+	/// Byte offset of the first element within the memfd.
+	uint64_t offset = 0;
+	std::vector<int64_t> shape;
+	DLDataType dtype{ kDLFloat, 32, 1 };
+
+	/// @brief Size of the tensor data in bytes (dense, row-major).
+	uint64_t nbytes() const;
+};
+
+/// @brief Allocates a dense row-major CPU tensor from the arena. Contents are uninitialized;
+/// write through dl_tensor.data before handing it to Python.
+template <typename T>
+DLManagedTensor* createShmTensorDlpack(const std::shared_ptr<ShmArena>& arena,
+									   const std::vector<int64_t>& shape);
+
+/// @brief Describes a tensor created by createShmTensorDlpack or importShmTensorDlpack.
+/// @throws std::invalid_argument for tensors that are not shared-memory backed.
+ShmTensorDescriptor describeShmTensor(const DLManagedTensor* tensor);
+
+/// @brief Maps the bytes named by a descriptor and wraps them as a DLPack tensor. The fd is
+/// duplicated, so the caller keeps ownership of descriptor.fd.
+DLManagedTensor* importShmTensorDlpack(const ShmTensorDescriptor& descriptor);
+
+/// @brief Sends a descriptor, including its file descriptor, over a connected AF_UNIX socket.
+void sendShmTensorDescriptor(int socket, const ShmTensorDescriptor& descriptor);
+
+/// @brief Receives a descriptor sent by sendShmTensorDescriptor. The caller owns the
+/// returned fd and should close it once the tensor has been imported.
+ShmTensorDescriptor receiveShmTensorDescriptor(int socket);
+
+/// @brief Wraps a DLPack tensor in a "dltensor" capsule for torch.from_dlpack and friends.
+/// The tensor's deleter runs when the capsule is collected unless a consumer took ownership.
+/// Requires the GIL.
+pybind11::capsule makeDlpackCapsule(DLManagedTensor* tensor);
+
+} // namespace pyscheduler
+
+#include "pyscheduler/details/shm_tensor_impl.hpp"
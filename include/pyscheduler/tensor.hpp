@@ -1,5 +1,6 @@
 #pragma once
 
+#include "pyscheduler/dlpack_traits.hpp"
 #include "pyscheduler/library_export.hpp"
 #include <cuda_runtime.h>
 #include <dlpack/dlpack.h>
@@ -11,34 +12,6 @@
 
 namespace pyscheduler {
 
-template <typename T>
-struct DLPackTypeTraits;
-
-template <>
-struct DLPackTypeTraits<float> {
-	static constexpr DLDataType dtype = { kDLFloat, 32, 1 };
-};
-
-template <>
-struct DLPackTypeTraits<double> {
-	static constexpr DLDataType dtype = { kDLFloat, 64, 1 };
-};
-
-template <>
-struct DLPackTypeTraits<int64_t> {
-	static constexpr DLDataType dtype = { kDLInt, 64, 1 };
-};
-
-template <>
-struct DLPackTypeTraits<int32_t> {
-	static constexpr DLDataType dtype = { kDLInt, 32, 1 };
-};
-
-template <>
-struct DLPackTypeTraits<uint8_t> {
-	static constexpr DLDataType dtype = { kDLUInt, 8, 1 };
-};
-
 template <typename T>
 inline DLManagedTensor*
 createCudaMatrixDlpack(const std::vector<T>& host_data, int64_t rows, int64_t cols) {
@@ -0,0 +1,101 @@
+#pragma once
+#include "pyscheduler/library_export.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace pyscheduler {
+
+/// @brief Process-wide, opt-in request tracer.
+///
+/// While enabled, every queue_invoke gets a request id and the handler worker records
+/// timestamps as the request moves through commit, batch assembly, Python execution and its
+/// callback. Events land in a fixed-size ring buffer owned by the recording thread, so the
+/// hot path takes only an uncontended lock; when a ring fills, its oldest events are
+/// overwritten. dump_chrome_json renders everything as Chrome trace-event JSON, loadable in
+/// Perfetto or chrome://tracing. When disabled, each record site costs one relaxed load.
+class PYSCHEDULER_LIBRARY_EXPORT Tracer {
+public:
+	enum class Phase : uint8_t {
+		kEnqueue,
+		kCommitStart,
+		kCommitEnd,
+		/// The request was placed in batch batch_id.
+		kBatchAssembled,
+		/// Batch-level: the Python call for batch_id started; value is the batch size.
+		kExecuteStart,
+		/// Batch-level: the Python call for batch_id returned or raised.
+		kExecuteEnd,
+		/// The request's result or error callback finished.
+		kCallbackEnd,
+	};
+
+	struct Event {
+		uint64_t request_id = 0;
+		uint64_t batch_id = 0;
+		std::int64_t ts_ns = 0;
+		uint32_t handler_id = 0;
+		uint32_t value = 0;
+		Phase phase = Phase::kEnqueue;
+	};
+
+	/// @brief Starts recording. events_per_thread sizes rings created from now on, including
+	/// those recreated by clear().
+	static void enable(size_t events_per_thread = size_t{ 1 } << 16);
+	static void disable();
+	static bool enabled() {
+		return _state.enabled.load(std::memory_order_relaxed);
+	}
+
+	static uint64_t next_request_id();
+	static uint64_t next_batch_id();
+
+	/// @brief Appends an event to the calling thread's ring. Record sites check enabled()
+	/// first; record itself always appends.
+	static void record(Phase phase,
+					   uint64_t request_id,
+					   uint64_t batch_id,
+					   uint64_t handler_id,
+					   std::chrono::steady_clock::time_point ts,
+					   uint32_t value = 0);
+
+	/// @brief Renders every buffered event as a Chrome trace-event JSON document: per-request
+	/// async spans (queued, commit, hold, execute, callback) and per-batch slices on the
+	/// worker thread.
+	static std::string dump_chrome_json();
+
+	/// @brief Drops buffered events and the rings of threads that have exited.
+	static void clear();
+
+private:
+	struct Buffer {
+		std::mutex mutex;
+		std::vector<Event> events;
+		size_t next = 0;
+		bool wrapped = false;
+		uint32_t tid = 0;
+	};
+
+	struct State {
+		std::atomic<bool> enabled = false;
+		std::atomic<size_t> capacity = size_t{ 1 } << 16;
+		std::atomic<uint64_t> next_request = 1;
+		std::atomic<uint64_t> next_batch = 1;
+		std::mutex buffers_mutex;
+		std::vector<std::shared_ptr<Buffer>> buffers;
+	};
+
+	static Buffer& localBuffer();
+
+	static State _state;
+};
+
+} // namespace pyscheduler
+
+#include "pyscheduler/details/trace_impl.hpp"
@@ -2,4 +2,11 @@
 
 namespace pyscheduler {
 PyManager::SharedState PyManager::_instance;
+Tracer::State Tracer::_state;
+GilProfiler::State GilProfiler::_state;
+}
+
+// Registered with the interpreter's builtin modules before it starts; see PyManager::mainLoop
+PYBIND11_EMBEDDED_MODULE(pyscheduler, module) {
+	pyscheduler::PyManager::define_embedded_module(module);
 }
@@ -0,0 +1,117 @@
+#include "bench_common.hpp"
+
+#include <cstdint>
+#include <future>
+#include <thread>
+#include <vector>
+
+using namespace pyscheduler;
+
+// Pairs of benchmarks running the same workload in pure Python (one synchronous call into
+// tests/test_modules/bench_baseline.py) and through the scheduler.
+
+namespace {
+constexpr double kSleepSeconds = 0.01;
+} // namespace
+
+/// examples/multithreaded/main.py: n sleeps on module_a, then n on module_b, sequentially.
+static void BM_Baseline_PythonSleep(benchmark::State& state) {
+	const int requests = static_cast<int>(state.range(0));
+	PyManager::InvokeHandler run =
+		bench::getManager().loadPythonModule("tests.test_modules.bench_baseline", "run_sleep");
+	for(auto _ : state) {
+		benchmark::DoNotOptimize(run.invoke<int>(requests, kSleepSeconds));
+	}
+	state.SetItemsProcessed(state.iterations() * 2 * requests);
+}
+BENCHMARK(BM_Baseline_PythonSleep)
+	->ArgName("n")
+	->Arg(50)
+	->Unit(benchmark::kMillisecond)
+	->UseRealTime();
+
+/// examples/multithreaded/main.cpp: the same sleeps fed to two handlers by two producers.
+static void BM_Baseline_SchedulerSleep(benchmark::State& state) {
+	const int requests = static_cast<int>(state.range(0));
+	PyManager::InvokeHandler module_a = bench::getManager().loadPythonModule(
+		"examples.multithreaded.python_modules.module_a", "invoke", 8, 2);
+	PyManager::InvokeHandler module_b = bench::getManager().loadPythonModule(
+		"examples.multithreaded.python_modules.module_b", "invoke", 8, 2);
+
+	auto commit = [](double seconds) -> pybind11::object { return pybind11::cast(seconds); };
+	auto callback = [](const pybind11::object& obj) { return obj.cast<double>(); };
+
+	for(auto _ : state) {
+		std::vector<std::future<double>> futures_a;
+		std::vector<std::future<double>> futures_b;
+		std::thread producer_a([&] {
+			for(int i = 0; i < requests; i++) {
+				futures_a.push_back(module_a.queue_invoke(commit, callback, kSleepSeconds));
+			}
+		});
+		std::thread producer_b([&] {
+			for(int i = 0; i < requests; i++) {
+				futures_b.push_back(module_b.queue_invoke(commit, callback, kSleepSeconds));
+			}
+		});
+		producer_a.join();
+		producer_b.join();
+
+		double total = 0.0;
+		for(auto& f : futures_a) {
+			total += f.get();
+		}
+		for(auto& f : futures_b) {
+			total += f.get();
+		}
+		benchmark::DoNotOptimize(total);
+	}
+	state.SetItemsProcessed(state.iterations() * 2 * requests);
+}
+BENCHMARK(BM_Baseline_SchedulerSleep)
+	->ArgName("n")
+	->Arg(50)
+	->Unit(benchmark::kMillisecond)
+	->UseRealTime();
+
+/// n one-item calls to the identity entry point from a Python loop.
+static void BM_Baseline_PythonIdentity(benchmark::State& state) {
+	const int requests = static_cast<int>(state.range(0));
+	PyManager::InvokeHandler run =
+		bench::getManager().loadPythonModule("tests.test_modules.bench_baseline", "run_identity");
+	for(auto _ : state) {
+		benchmark::DoNotOptimize(run.invoke<int64_t>(requests));
+	}
+	state.SetItemsProcessed(state.iterations() * requests);
+}
+BENCHMARK(BM_Baseline_PythonIdentity)
+	->ArgName("n")
+	->Arg(20000)
+	->Unit(benchmark::kMillisecond)
+	->UseRealTime();
+
+/// The same n requests queued from C++ and batched by the scheduler.
+static void BM_Baseline_SchedulerIdentity(benchmark::State& state) {
+	const int64_t requests = state.range(0);
+	PyManager::InvokeHandler handler = bench::getManager().loadPythonModule(
+		"tests.test_modules.identity", "invoke", static_cast<size_t>(state.range(1)), 4);
+	for(auto _ : state) {
+		std::vector<std::future<int>> futures;
+		futures.reserve(static_cast<size_t>(requests));
+		for(int64_t i = 0; i < requests; i++) {
+			futures.push_back(
+				handler.queue_invoke(bench::commitInt, bench::castInt, static_cast<int>(i)));
+		}
+		int64_t checksum = 0;
+		for(auto& f : futures) {
+			checksum += f.get();
+		}
+		benchmark::DoNotOptimize(checksum);
+	}
+	state.SetItemsProcessed(state.iterations() * requests);
+}
+BENCHMARK(BM_Baseline_SchedulerIdentity)
+	->ArgNames({ "n", "batch" })
+	->ArgsProduct({ { 20000 }, { 1, 256 } })
+	->Unit(benchmark::kMillisecond)
+	->UseRealTime();
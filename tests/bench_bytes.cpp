@@ -0,0 +1,94 @@
+#include "bench_common.hpp"
+#include "pyscheduler/bytes_view.hpp"
+
+#include <cstdint>
+#include <future>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace pyscheduler;
+
+namespace {
+constexpr int64_t kRequests = 64;
+
+/// Per-item commit time as recorded by the worker, in microseconds.
+double commitP50Us(const PyManager::InvokeHandler& handler) {
+	return static_cast<double>(handler.get_metrics().commit_ns.percentile(0.5)) * 1e-3;
+}
+} // namespace
+
+/// Committing an n-byte std::string: copied into pybind11::bytes vs. handed over as a
+/// memoryview by makeBytesView. The copy grows with the payload; the view should not.
+static void BM_CommitBlob(benchmark::State& state) {
+	const bool zero_copy = state.range(0) != 0;
+	const auto payload = static_cast<size_t>(state.range(1));
+
+	PyManager::InvokeHandler handler =
+		bench::getManager().loadPythonModule("tests.test_modules.blobs", "lengths", 16, 4);
+
+	auto commit = [zero_copy](std::string blob) -> pybind11::object {
+		if(zero_copy) return makeBytesView(std::move(blob));
+		return pybind11::bytes(blob);
+	};
+	for(auto _ : state) {
+		std::vector<std::future<int>> futures;
+		futures.reserve(kRequests);
+		for(int64_t i = 0; i < kRequests; i++) {
+			futures.push_back(
+				handler.queue_invoke(commit, bench::castInt, std::string(payload, 'x')));
+		}
+		int64_t checksum = 0;
+		for(auto& f : futures) {
+			checksum += f.get();
+		}
+		benchmark::DoNotOptimize(checksum);
+	}
+	state.SetItemsProcessed(state.iterations() * kRequests);
+	state.SetBytesProcessed(state.iterations() * kRequests * static_cast<int64_t>(payload));
+	state.counters["commit_p50_us"] = commitP50Us(handler);
+}
+
+BENCHMARK(BM_CommitBlob)
+	->ArgNames({ "zero_copy", "bytes" })
+	->ArgsProduct({ { 0, 1 }, { 1 << 10, 1 << 16, 1 << 20, 1 << 24 } })
+	->Unit(benchmark::kMillisecond)
+	->UseRealTime();
+
+/// Reading an n-byte Python bytes result in the callback: copied into a std::string vs.
+/// viewed in place with bytesView.
+static void BM_ReadBlobResult(benchmark::State& state) {
+	const bool zero_copy = state.range(0) != 0;
+	const auto payload = static_cast<size_t>(state.range(1));
+
+	PyManager::InvokeHandler handler =
+		bench::getManager().loadPythonModule("tests.test_modules.blobs", "make", 16, 4);
+
+	auto commit = [](size_t size) -> pybind11::object { return pybind11::cast(size); };
+	auto read = [zero_copy](const pybind11::object& obj) -> size_t {
+		if(zero_copy) return bytesView(obj).size();
+		return obj.cast<std::string>().size();
+	};
+	for(auto _ : state) {
+		std::vector<std::future<size_t>> futures;
+		futures.reserve(kRequests);
+		for(int64_t i = 0; i < kRequests; i++) {
+			futures.push_back(handler.queue_invoke(commit, read, payload));
+		}
+		size_t checksum = 0;
+		for(auto& f : futures) {
+			checksum += f.get();
+		}
+		benchmark::DoNotOptimize(checksum);
+	}
+	state.SetItemsProcessed(state.iterations() * kRequests);
+	state.SetBytesProcessed(state.iterations() * kRequests * static_cast<int64_t>(payload));
+	state.counters["fanout_p50_us"] =
+		static_cast<double>(handler.get_metrics().fanout_ns.percentile(0.5)) * 1e-3;
+}
+
+BENCHMARK(BM_ReadBlobResult)
+	->ArgNames({ "zero_copy", "bytes" })
+	->ArgsProduct({ { 0, 1 }, { 1 << 10, 1 << 16, 1 << 20, 1 << 24 } })
+	->Unit(benchmark::kMillisecond)
+	->UseRealTime();
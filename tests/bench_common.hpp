@@ -0,0 +1,22 @@
+#pragma once
+#include "bench_support.hpp"
+#include "pyscheduler/metrics.hpp"
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+namespace bench {
+
+/// @brief Publishes percentiles of a nanosecond histogram as microsecond counters.
+inline void reportPercentiles(benchmark::State& state,
+							  const pyscheduler::HistogramSnapshot& snapshot,
+							  const std::string& prefix = "") {
+	constexpr double kNsToUs = 1e-3;
+	state.counters[prefix + "p50_us"] = static_cast<double>(snapshot.percentile(0.5)) * kNsToUs;
+	state.counters[prefix + "p99_us"] = static_cast<double>(snapshot.percentile(0.99)) * kNsToUs;
+	state.counters[prefix + "p999_us"] =
+		static_cast<double>(snapshot.percentile(0.999)) * kNsToUs;
+	state.counters[prefix + "max_us"] = static_cast<double>(snapshot.max) * kNsToUs;
+}
+
+} // namespace bench
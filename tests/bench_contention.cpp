@@ -0,0 +1,60 @@
+#include "bench_common.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <future>
+#include <thread>
+#include <vector>
+
+using namespace pyscheduler;
+
+/// Many handlers competing for the GIL: h handlers, each fed by its own producer thread,
+/// together process n items. Reports aggregate throughput and the worst per-handler p99
+/// GIL wait.
+static void BM_ManyHandlers(benchmark::State& state) {
+	const size_t handlers = static_cast<size_t>(state.range(0));
+	const int64_t entries = state.range(1);
+	const int64_t per_handler = entries / static_cast<int64_t>(handlers);
+
+	std::vector<PyManager::InvokeHandler> pool;
+	pool.reserve(handlers);
+	for(size_t h = 0; h < handlers; h++) {
+		pool.push_back(bench::getManager().loadPythonModule(
+			"tests.test_modules.identity", "invoke", 64, 4));
+	}
+
+	for(auto _ : state) {
+		std::vector<int64_t> checksums(handlers, 0);
+		std::vector<std::thread> producers;
+		for(size_t h = 0; h < handlers; h++) {
+			producers.emplace_back([&, h] {
+				std::vector<std::future<int>> futures;
+				futures.reserve(static_cast<size_t>(per_handler));
+				for(int64_t i = 0; i < per_handler; i++) {
+					futures.push_back(pool[h].queue_invoke(
+						bench::commitInt, bench::castInt, static_cast<int>(i)));
+				}
+				for(auto& f : futures) {
+					checksums[h] += f.get();
+				}
+			});
+		}
+		for(auto& producer : producers) {
+			producer.join();
+		}
+		benchmark::DoNotOptimize(checksums.data());
+	}
+
+	state.SetItemsProcessed(state.iterations() * per_handler * static_cast<int64_t>(handlers));
+	uint64_t worst_wait_p99 = 0;
+	for(const auto& handler : pool) {
+		worst_wait_p99 = std::max(worst_wait_p99, handler.get_gil_stats().wait_ns.percentile(0.99));
+	}
+	state.counters["gil_wait_p99_us"] = static_cast<double>(worst_wait_p99) * 1e-3;
+}
+
+BENCHMARK(BM_ManyHandlers)
+	->ArgNames({ "handlers", "n" })
+	->ArgsProduct({ { 1, 2, 4, 8, 16 }, { 32000 } })
+	->Unit(benchmark::kMillisecond)
+	->UseRealTime();
@@ -0,0 +1,79 @@
+#include "bench_common.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <thread>
+#include <vector>
+
+using namespace pyscheduler;
+
+/// Cost of queue_invoke itself with 1..N producers hammering one handler. Only the enqueue
+/// loops are timed (manual time: first producer released until the last one finishes);
+/// draining the futures happens outside the measurement.
+static void BM_EnqueuePerItem(benchmark::State& state) {
+	const size_t producers = static_cast<size_t>(state.range(0));
+	const int64_t per_producer = state.range(1);
+
+	PyManager::InvokeHandler handler =
+		bench::getManager().loadPythonModule("tests.test_modules.identity", "invoke", 1024, 64);
+
+	double enqueue_ns = 0.0;
+	for(auto _ : state) {
+		std::vector<std::vector<std::future<int>>> futures(producers);
+		std::vector<std::chrono::steady_clock::time_point> finished(producers);
+		std::vector<std::chrono::nanoseconds> busy(producers);
+		std::atomic<size_t> ready{ 0 };
+		std::atomic<bool> go{ false };
+
+		std::vector<std::thread> threads;
+		for(size_t p = 0; p < producers; p++) {
+			futures[p].reserve(static_cast<size_t>(per_producer));
+			threads.emplace_back([&, p] {
+				ready.fetch_add(1);
+				while(!go.load(std::memory_order_acquire)) {
+				}
+				auto start = std::chrono::steady_clock::now();
+				for(int64_t i = 0; i < per_producer; i++) {
+					futures[p].push_back(handler.queue_invoke(
+						bench::commitInt, bench::castInt, static_cast<int>(i)));
+				}
+				finished[p] = std::chrono::steady_clock::now();
+				busy[p] = finished[p] - start;
+			});
+		}
+		while(ready.load() < producers) {
+		}
+		auto released = std::chrono::steady_clock::now();
+		go.store(true, std::memory_order_release);
+		for(auto& thread : threads) {
+			thread.join();
+		}
+
+		auto last = *std::max_element(finished.begin(), finished.end());
+		state.SetIterationTime(std::chrono::duration<double>(last - released).count());
+		for(const auto& elapsed : busy) {
+			enqueue_ns += static_cast<double>(elapsed.count());
+		}
+
+		int64_t checksum = 0;
+		for(auto& producer_futures : futures) {
+			for(auto& f : producer_futures) {
+				checksum += f.get();
+			}
+		}
+		benchmark::DoNotOptimize(checksum);
+	}
+
+	const int64_t items = state.iterations() * static_cast<int64_t>(producers) * per_producer;
+	state.SetItemsProcessed(items);
+	state.counters["ns_per_enqueue"] = enqueue_ns / static_cast<double>(items);
+}
+
+BENCHMARK(BM_EnqueuePerItem)
+	->ArgNames({ "producers", "n" })
+	->ArgsProduct({ { 1, 2, 4, 8 }, { 10000 } })
+	->UseManualTime()
+	->Unit(benchmark::kMicrosecond);
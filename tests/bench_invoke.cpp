@@ -0,0 +1,63 @@
+#include "bench_common.hpp"
+
+#include <cstdint>
+#include <future>
+#include <vector>
+
+using namespace pyscheduler;
+
+namespace {
+PyManager::InvokeHandler loadIdentity(size_t batch_size) {
+	return bench::getManager().loadPythonModule(
+		"tests.test_modules.identity", "invoke", batch_size, 4);
+}
+} // namespace
+
+/// One synchronous call on the calling thread: GIL acquire, Python call, cast.
+static void BM_SyncInvoke(benchmark::State& state) {
+	PyManager::InvokeHandler handler = loadIdentity(1);
+	int i = 0;
+	for(auto _ : state) {
+		benchmark::DoNotOptimize(handler.invoke<int>(i++));
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SyncInvoke)->Unit(benchmark::kMicrosecond);
+
+/// One queued request at a time: the latency of a lone request through the worker,
+/// including the worker's idle wake-up.
+static void BM_QueueInvokeRoundTrip(benchmark::State& state) {
+	PyManager::InvokeHandler handler = loadIdentity(1);
+	int i = 0;
+	for(auto _ : state) {
+		benchmark::DoNotOptimize(
+			handler.queue_invoke(bench::commitInt, bench::castInt, i++).get());
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_QueueInvokeRoundTrip)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+/// n requests in flight at once: amortized per-item cost once batching kicks in.
+static void BM_QueueInvokePipelined(benchmark::State& state) {
+	const int64_t entries = state.range(0);
+	PyManager::InvokeHandler handler = loadIdentity(static_cast<size_t>(state.range(1)));
+	for(auto _ : state) {
+		std::vector<std::future<int>> futures;
+		futures.reserve(static_cast<size_t>(entries));
+		for(int64_t i = 0; i < entries; i++) {
+			futures.push_back(
+				handler.queue_invoke(bench::commitInt, bench::castInt, static_cast<int>(i)));
+		}
+		int64_t checksum = 0;
+		for(auto& f : futures) {
+			checksum += f.get();
+		}
+		benchmark::DoNotOptimize(checksum);
+	}
+	state.SetItemsProcessed(state.iterations() * entries);
+}
+BENCHMARK(BM_QueueInvokePipelined)
+	->ArgNames({ "n", "batch" })
+	->ArgsProduct({ { 1000 }, { 1, 64, 1024 } })
+	->Unit(benchmark::kMicrosecond)
+	->UseRealTime();
@@ -0,0 +1,68 @@
+#include "bench_common.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <vector>
+
+using namespace pyscheduler;
+
+/// End-to-end latency at a fixed offered load. Requests arrive on an open-loop schedule
+/// (request i at start + i / rps) and latency is measured from the scheduled arrival, not
+/// the actual enqueue, so a stalled producer cannot hide queueing delay (no coordinated
+/// omission). Each iteration is one run of n requests, i.e. n / rps seconds.
+static void BM_LatencyAtOfferedLoad(benchmark::State& state) {
+	const int64_t rps = state.range(0);
+	const int64_t requests = state.range(1);
+	const size_t batch_size = static_cast<size_t>(state.range(2));
+
+	PyManager::InvokeHandler handler = bench::getManager().loadPythonModule(
+		"tests.test_modules.identity", "invoke", batch_size, 2);
+
+	const auto interval = std::chrono::nanoseconds(1000000000 / rps);
+	LatencyHistogram latency;
+	std::chrono::nanoseconds late{ 0 };
+
+	for(auto _ : state) {
+		std::vector<std::future<int>> futures;
+		futures.reserve(static_cast<size_t>(requests));
+
+		const auto start = std::chrono::steady_clock::now();
+		for(int64_t i = 0; i < requests; i++) {
+			const auto scheduled = start + i * interval;
+			bench::waitUntil(scheduled);
+			late = std::max(late, std::chrono::steady_clock::now() - scheduled);
+			auto callback = [&latency, scheduled](const pybind11::object& obj) {
+				latency.record(static_cast<uint64_t>(
+					std::chrono::duration_cast<std::chrono::nanoseconds>(
+						std::chrono::steady_clock::now() - scheduled)
+						.count()));
+				return obj.cast<int>();
+			};
+			futures.push_back(
+				handler.queue_invoke(bench::commitInt, callback, static_cast<int>(i)));
+		}
+
+		int64_t checksum = 0;
+		for(auto& f : futures) {
+			checksum += f.get();
+		}
+		benchmark::DoNotOptimize(checksum);
+	}
+
+	state.SetItemsProcessed(state.iterations() * requests);
+	bench::reportPercentiles(state, latency.snapshot());
+	// Worst producer lag behind the schedule; large values mean the offered load was not met
+	state.counters["max_send_lag_us"] =
+		std::chrono::duration<double, std::micro>(late).count();
+}
+
+BENCHMARK(BM_LatencyAtOfferedLoad)
+	->ArgNames({ "rps", "n", "batch" })
+	->Args({ 1000, 2000, 64 })
+	->Args({ 10000, 20000, 64 })
+	->Args({ 50000, 50000, 256 })
+	->Args({ 100000, 100000, 1024 })
+	->Unit(benchmark::kMillisecond)
+	->UseRealTime();
@@ -1,5 +1,4 @@
-#include "pyscheduler/pyscheduler.hpp"
-#include <benchmark/benchmark.h>
+#include "bench_common.hpp"
 
 #include <cstdint>
 #include <future>
@@ -16,12 +15,9 @@
 
 using namespace pyscheduler;
 
-namespace {
-PyManager& getManager() {
-	static PyManager manager;
-	return manager;
-}
+using bench::getManager;
 
+namespace {
 #if defined(PYSCHEDULER_TEST_HAS_CUDA) && PYSCHEDULER_TEST_HAS_CUDA &&                             \
 	__has_include(<cuda_runtime.h>) && __has_include(<dlpack/dlpack.h>)
 std::vector<float> generateRandomMatrix(int rows, int cols, uint32_t seed) {
@@ -46,6 +42,8 @@ pybind11::capsule toDlpackCapsule(DLManagedTensor* managed_tensor) {
 #endif
 } // namespace
 
+/// Throughput of a single producer draining n items through one handler, swept over batch
+/// size and prefetch depth. The handler outlives the timed loop.
 static void BM_QS_CPU(benchmark::State& state) {
 	const int64_t entries = state.range(0);
 	const size_t batch_size = static_cast<size_t>(state.range(1));
@@ -54,12 +52,10 @@ static void BM_QS_CPU(benchmark::State& state) {
 	auto commit = [](int val) -> pybind11::object { return pybind11::cast(val); };
 	auto callback = [](const pybind11::object& obj) { return obj.cast<int>(); };
 
-	for(auto _ : state) {
-		state.PauseTiming();
-		PyManager::InvokeHandler reflect = getManager().loadPythonModule(
-			"tests.test_modules.identity", "invoke", batch_size, prefetch_depth);
-		state.ResumeTiming();
+	PyManager::InvokeHandler reflect = getManager().loadPythonModule(
+		"tests.test_modules.identity", "invoke", batch_size, prefetch_depth);
 
+	for(auto _ : state) {
 		std::vector<std::future<int>> futures;
 		futures.reserve(static_cast<size_t>(entries));
 
@@ -77,15 +73,14 @@ static void BM_QS_CPU(benchmark::State& state) {
 	}
 
 	state.SetItemsProcessed(state.iterations() * entries);
+	state.counters["execute_batch_ema"] = reflect.get_queue_stats().execute_batch_size_ema;
 }
 
 BENCHMARK(BM_QS_CPU)
 	->ArgNames({ "n", "batch", "prefetch" })
-	->Args({ 120000, 256, 64 })
-	->Args({ 120000, 512, 128 })
-	->Args({ 120000, 1024, 256 })
+	->ArgsProduct({ { 20000 }, { 1, 16, 256, 1024 }, { 1, 4, 64 } })
 	->Unit(benchmark::kMillisecond)
-	->Iterations(1);
+	->UseRealTime();
 
 #if defined(PYSCHEDULER_TEST_HAS_CUDA) && PYSCHEDULER_TEST_HAS_CUDA &&                             \
 	__has_include(<cuda_runtime.h>) && __has_include(<dlpack/dlpack.h>)
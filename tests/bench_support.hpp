@@ -0,0 +1,32 @@
+#pragma once
+#include "pyscheduler/pyscheduler.hpp"
+
+#include <chrono>
+
+// Helpers shared by the benchmarks and the load generator; unlike bench_common.hpp this
+// does not depend on Google Benchmark.
+namespace bench {
+
+/// @brief Process-wide manager with the source tree on sys.path, so tests.test_modules and
+/// examples resolve regardless of the working directory.
+inline pyscheduler::PyManager& getManager() {
+	static pyscheduler::PyManager manager;
+	static const bool path_added = (manager.add_path(PYSCHEDULER_SOURCE_DIR), true);
+	(void)path_added;
+	return manager;
+}
+
+inline pybind11::object commitInt(int value) {
+	return pybind11::cast(value);
+}
+
+inline int castInt(const pybind11::object& obj) {
+	return obj.cast<int>();
+}
+
+/// @brief Open-loop pacing shared with replay_traffic; see details::sleepUntil.
+inline void waitUntil(std::chrono::steady_clock::time_point deadline) {
+	pyscheduler::details::sleepUntil(deadline);
+}
+
+} // namespace bench
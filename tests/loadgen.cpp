@@ -0,0 +1,335 @@
+#include "bench_support.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace pyscheduler;
+
+// Open-loop load generator. For each offered rate, requests are issued on a fixed-rate or
+// Poisson schedule regardless of how fast earlier ones complete, and latency is measured
+// from each request's intended send time, so queueing delay behind a stalled producer or a
+// saturated handler is charged to the requests that suffered it (no coordinated omission).
+// Each request commits one item built from its sequence number (--payload): an int by
+// default, as tests.test_modules.identity expects, or bytes or a list of floats of a given
+// size. Results are not inspected, so any entry point can be driven.
+namespace {
+
+enum class Payload { kInt, kBytes, kFloats };
+
+struct Config {
+	std::string module = "tests.test_modules.identity";
+	std::string entry_point = "invoke";
+	std::vector<double> rates = { 1000, 2000, 5000, 10000, 20000 };
+	double duration_s = 2.0;
+	bool poisson = false;
+	uint64_t seed = 1;
+	Payload payload = Payload::kInt;
+	size_t payload_size = 0;
+	bool json = false;
+	std::string output;
+	std::vector<std::string> paths;
+	PyManager::HandlerOptions handler;
+	bool help = false;
+};
+
+struct RatePoint {
+	double offered_rps = 0.0;
+	size_t requests = 0;
+	size_t failed = 0;
+	double achieved_rps = 0.0;
+	HistogramSnapshot latency_ns;
+	std::chrono::nanoseconds max_send_lag{ 0 };
+};
+
+void usage() {
+	std::cerr
+		<< "Usage: pyscheduler_loadgen [MODULE [ENTRY_POINT]] [options]\n"
+		<< "Sweeps offered load against MODULE.ENTRY_POINT (default:\n"
+		<< "tests.test_modules.identity.invoke) and reports throughput and latency per rate.\n"
+		<< "  --rates R1,R2,...      offered loads in requests/s (default: 1000,...,20000)\n"
+		<< "  --duration S           seconds of load per rate (default: 2)\n"
+		<< "  --schedule fixed|poisson  arrival process (default: fixed)\n"
+		<< "  --seed N               Poisson schedule seed (default: 1)\n"
+		<< "  --payload int|bytes:N|floats:N  item committed per request (default: int)\n"
+		<< "  --batch N              handler batch_size (default: 1)\n"
+		<< "  --prefetch N           handler prefetch_depth (default: 1)\n"
+		<< "  --path DIR             add DIR to sys.path; repeatable\n"
+		<< "  --format csv|json      output format (default: csv)\n"
+		<< "  --output FILE          write results to FILE instead of stdout\n";
+}
+
+std::vector<double> parseRates(const std::string& list) {
+	std::vector<double> rates;
+	std::stringstream stream(list);
+	std::string item;
+	while(std::getline(stream, item, ',')) {
+		const double rate = std::stod(item);
+		if(!(rate > 0.0)) throw std::invalid_argument("rates must be positive");
+		rates.push_back(rate);
+	}
+	if(rates.empty()) throw std::invalid_argument("no rates given");
+	return rates;
+}
+
+void parsePayload(const std::string& spec, Config& config) {
+	if(spec == "int") {
+		config.payload = Payload::kInt;
+		return;
+	}
+	const size_t colon = spec.find(':');
+	const std::string kind = spec.substr(0, colon);
+	if(colon == std::string::npos || (kind != "bytes" && kind != "floats")) {
+		throw std::invalid_argument("unknown payload " + spec);
+	}
+	config.payload = kind == "bytes" ? Payload::kBytes : Payload::kFloats;
+	config.payload_size = std::stoul(spec.substr(colon + 1));
+}
+
+std::string payloadName(const Config& config) {
+	switch(config.payload) {
+	case Payload::kBytes: return "bytes:" + std::to_string(config.payload_size);
+	case Payload::kFloats: return "floats:" + std::to_string(config.payload_size);
+	default: return "int";
+	}
+}
+
+/// @brief The item committed for request index; runs on the handler's worker.
+pybind11::object makePayload(const Config& config, int index) {
+	switch(config.payload) {
+	case Payload::kBytes:
+		return pybind11::bytes(std::string(config.payload_size, static_cast<char>(index)));
+	case Payload::kFloats: {
+		pybind11::list values;
+		for(size_t i = 0; i < config.payload_size; i++) {
+			values.append(pybind11::float_(static_cast<double>(index)));
+		}
+		return values;
+	}
+	default: return pybind11::int_(index);
+	}
+}
+
+Config parseArgs(int argc, char** argv) {
+	Config config;
+	std::vector<std::string> positional;
+	for(int i = 1; i < argc; i++) {
+		const std::string arg = argv[i];
+		auto value = [&]() -> std::string {
+			if(i + 1 >= argc) throw std::invalid_argument("missing value for " + arg);
+			return argv[++i];
+		};
+		if(arg == "--rates") {
+			config.rates = parseRates(value());
+		} else if(arg == "--duration") {
+			config.duration_s = std::stod(value());
+		} else if(arg == "--schedule") {
+			const std::string schedule = value();
+			if(schedule != "fixed" && schedule != "poisson") {
+				throw std::invalid_argument("unknown schedule " + schedule);
+			}
+			config.poisson = schedule == "poisson";
+		} else if(arg == "--seed") {
+			config.seed = std::stoull(value());
+		} else if(arg == "--payload") {
+			parsePayload(value(), config);
+		} else if(arg == "--batch") {
+			config.handler.batch_size = std::stoul(value());
+		} else if(arg == "--prefetch") {
+			config.handler.prefetch_depth = std::stoul(value());
+		} else if(arg == "--path") {
+			config.paths.push_back(value());
+		} else if(arg == "--format") {
+			const std::string format = value();
+			if(format != "csv" && format != "json") {
+				throw std::invalid_argument("unknown format " + format);
+			}
+			config.json = format == "json";
+		} else if(arg == "--output") {
+			config.output = value();
+		} else if(arg == "-h" || arg == "--help") {
+			config.help = true;
+		} else {
+			positional.push_back(arg);
+		}
+	}
+	if(positional.size() > 2) throw std::invalid_argument("too many arguments");
+	if(positional.size() > 0) config.module = positional[0];
+	if(positional.size() > 1) config.entry_point = positional[1];
+	if(!(config.duration_s > 0.0)) throw std::invalid_argument("duration must be positive");
+	return config;
+}
+
+/// @brief Intended send times, as offsets from the start of the run.
+std::vector<std::chrono::nanoseconds> schedule(const Config& config, double rate) {
+	const size_t count = std::max<size_t>(1, static_cast<size_t>(rate * config.duration_s));
+	std::vector<std::chrono::nanoseconds> offsets;
+	offsets.reserve(count);
+	std::mt19937_64 rng(config.seed);
+	std::exponential_distribution<double> gap(rate);
+	double t = 0.0;
+	for(size_t i = 0; i < count; i++) {
+		offsets.emplace_back(static_cast<std::int64_t>(t * 1e9));
+		t += config.poisson ? gap(rng) : 1.0 / rate;
+	}
+	return offsets;
+}
+
+RatePoint run(PyManager::InvokeHandler& handler, const Config& config, double rate) {
+	const std::vector<std::chrono::nanoseconds> offsets = schedule(config, rate);
+	auto latency = std::make_unique<LatencyHistogram>();
+	std::vector<std::future<bool>> futures;
+	futures.reserve(offsets.size());
+	auto commit = [&config](int index) { return makePayload(config, index); };
+
+	RatePoint point;
+	point.offered_rps = rate;
+	point.requests = offsets.size();
+	const auto start = std::chrono::steady_clock::now();
+	for(size_t i = 0; i < offsets.size(); i++) {
+		const auto intended = start + offsets[i];
+		bench::waitUntil(intended);
+		const auto lag = std::chrono::steady_clock::now() - intended;
+		point.max_send_lag = std::max(
+			point.max_send_lag, std::chrono::duration_cast<std::chrono::nanoseconds>(lag));
+		auto callback = [&latency, intended](const pybind11::object&) {
+			latency->record(static_cast<uint64_t>(
+				std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::steady_clock::now() - intended)
+					.count()));
+			return true;
+		};
+		futures.push_back(handler.queue_invoke(commit, callback, static_cast<int>(i)));
+	}
+	for(auto& future : futures) {
+		try {
+			future.get();
+		} catch(...) {
+			point.failed++;
+		}
+	}
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	point.achieved_rps = static_cast<double>(point.requests - point.failed) / elapsed.count();
+	point.latency_ns = latency->snapshot();
+	return point;
+}
+
+double toUs(uint64_t ns) {
+	return static_cast<double>(ns) * 1e-3;
+}
+
+void writeCsv(std::ostream& out, const std::vector<RatePoint>& points) {
+	out << "offered_rps,achieved_rps,requests,failed,p50_us,p99_us,p999_us,max_us,"
+		   "max_send_lag_us\n";
+	for(const RatePoint& point : points) {
+		out << point.offered_rps << ',' << point.achieved_rps << ',' << point.requests << ','
+			<< point.failed << ',' << toUs(point.latency_ns.percentile(0.5)) << ','
+			<< toUs(point.latency_ns.percentile(0.99)) << ','
+			<< toUs(point.latency_ns.percentile(0.999)) << ',' << toUs(point.latency_ns.max)
+			<< ',' << static_cast<double>(point.max_send_lag.count()) * 1e-3 << '\n';
+	}
+}
+
+/// @brief text as a quoted JSON string.
+std::string jsonString(const std::string& text) {
+	std::string out = "\"";
+	for(char c : text) {
+		switch(c) {
+		case '"': out += "\\\""; break;
+		case '\\': out += "\\\\"; break;
+		case '\n': out += "\\n"; break;
+		case '\t': out += "\\t"; break;
+		default:
+			if(static_cast<unsigned char>(c) < 0x20) {
+				char escaped[8];
+				std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+				out += escaped;
+			} else {
+				out += c;
+			}
+		}
+	}
+	return out + "\"";
+}
+
+void writeJson(std::ostream& out, const Config& config, const std::vector<RatePoint>& points) {
+	out << "{\"module\": " << jsonString(config.module)
+		<< ", \"entry_point\": " << jsonString(config.entry_point) << ", \"schedule\": \""
+		<< (config.poisson ? "poisson" : "fixed") << "\", \"payload\": \""
+		<< payloadName(config) << "\", \"batch_size\": " << config.handler.batch_size
+		<< ", \"points\": [";
+	for(size_t i = 0; i < points.size(); i++) {
+		const RatePoint& point = points[i];
+		out << (i == 0 ? "\n" : ",\n") << "  {\"offered_rps\": " << point.offered_rps
+			<< ", \"achieved_rps\": " << point.achieved_rps << ", \"requests\": "
+			<< point.requests << ", \"failed\": " << point.failed
+			<< ", \"p50_us\": " << toUs(point.latency_ns.percentile(0.5))
+			<< ", \"p99_us\": " << toUs(point.latency_ns.percentile(0.99))
+			<< ", \"p999_us\": " << toUs(point.latency_ns.percentile(0.999))
+			<< ", \"max_us\": " << toUs(point.latency_ns.max) << ", \"max_send_lag_us\": "
+			<< static_cast<double>(point.max_send_lag.count()) * 1e-3 << "}";
+	}
+	out << "\n]}\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	Config config;
+	try {
+		config = parseArgs(argc, argv);
+	} catch(const std::exception& e) {
+		std::cerr << "Error: " << e.what() << "\n";
+		usage();
+		return 2;
+	}
+	if(config.help) {
+		usage();
+		return 0;
+	}
+
+	try {
+		PyManager& manager = bench::getManager();
+		for(const std::string& path : config.paths) {
+			manager.add_path(path);
+		}
+		PyManager::InvokeHandler handler =
+			manager.loadPythonModule(config.module, config.entry_point, config.handler);
+		handler.ready().wait();
+
+		std::vector<RatePoint> points;
+		for(double rate : config.rates) {
+			points.push_back(run(handler, config, rate));
+			const RatePoint& point = points.back();
+			std::cerr << "offered " << point.offered_rps << " rps: achieved "
+					  << point.achieved_rps << " rps, p99 "
+					  << toUs(point.latency_ns.percentile(0.99)) << " us\n";
+		}
+
+		std::ofstream file;
+		if(!config.output.empty()) {
+			file.open(config.output);
+			if(!file) throw std::runtime_error("Could not open " + config.output);
+		}
+		std::ostream& out = config.output.empty() ? std::cout : file;
+		if(config.json) {
+			writeJson(out, config, points);
+		} else {
+			writeCsv(out, points);
+		}
+	} catch(const std::exception& e) {
+		std::cerr << "Error: " << e.what() << "\n";
+		return 1;
+	}
+	return 0;
+}
@@ -1,4 +1,6 @@
 #include "pyscheduler/pyscheduler.hpp"
+#include "pyscheduler/bytes_view.hpp"
+#include "pyscheduler/shm_tensor.hpp"
 #include "pyscheduler/tensor.hpp"
 #include <catch2/catch_all.hpp>
 #include <catch2/reporters/catch_reporter_event_listener.hpp>
@@ -25,12 +27,26 @@ struct CleanExitListener : Catch::EventListenerBase {
 } // namespace
 CATCH_REGISTER_LISTENER(CleanExitListener)
 
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <cmath>
 #include <cstdint>
 #include <dlfcn.h>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <optional>
+#include <sched.h>
+#include <span>
 #include <string>
+#include <string_view>
 #include <thread>
+#include <tuple>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 #if defined(PYSCHEDULER_TEST_HAS_CUDA) && PYSCHEDULER_TEST_HAS_CUDA &&                             \
 	__has_include(<cuda_runtime.h>) && __has_include(<dlpack/dlpack.h>)
@@ -459,6 +475,1183 @@ TEST_CASE("Concurrent producers all complete and total_enqueued matches", "[conc
 			static_cast<int64_t>(kThreads * kPerThread));
 }
 
+TEST_CASE("Isolated handler runs in its own subinterpreter", "[subinterpreter]") {
+	PyManager& manager = getContext().manager;
+	PyManager::HandlerOptions options;
+	options.batch_size = 4;
+	options.isolated_interpreter = true;
+
+#if PY_VERSION_HEX < 0x030C0000
+	REQUIRE_THROWS_AS(manager.loadPythonModule("tests.test_modules.identity", "invoke", options),
+					  std::runtime_error);
+#else
+	auto commit = [](int val) -> pybind11::object { return pybind11::cast(val); };
+	auto callback = [](const pybind11::object& obj) { return obj.cast<int>(); };
+
+	const size_t base_count = PyManager::debug_subinterpreter_count();
+	{
+		PyManager::InvokeHandler isolated =
+			manager.loadPythonModule("tests.test_modules.identity", "invoke", options);
+		REQUIRE(PyManager::debug_subinterpreter_count() == base_count + 1);
+
+		std::vector<std::future<int>> futures;
+		for(int i = 0; i < 20; i++) {
+			futures.push_back(isolated.queue_invoke(commit, callback, i));
+		}
+		for(int i = 0; i < 20; i++) {
+			REQUIRE(futures[i].get() == i);
+		}
+
+		REQUIRE_THROWS_AS(isolated.invoke<int>(1), std::logic_error);
+	}
+	REQUIRE(PyManager::debug_subinterpreter_count() == base_count);
+
+	{
+		// The Python error reaches the caller as text, not as the subinterpreter's objects
+		std::future<int> failed;
+		{
+			PyManager::InvokeHandler raises =
+				manager.loadPythonModule("tests.test_modules.raises", "invoke", options);
+			failed = raises.queue_invoke(commit, callback, 1);
+			failed.wait();
+		}
+		std::string message;
+		try {
+			failed.get();
+		} catch(const std::runtime_error& e) {
+			message = e.what();
+		}
+		REQUIRE(message.find("intentional failure from raises.invoke") != std::string::npos);
+	}
+	REQUIRE(PyManager::debug_subinterpreter_count() == base_count);
+
+	REQUIRE_THROWS_AS(
+		manager.loadPythonModule("tests.test_modules.does_not_exist", "invoke", options),
+		std::invalid_argument);
+	REQUIRE(PyManager::debug_subinterpreter_count() == base_count);
+#endif
+}
+
+TEST_CASE("Process pool handler executes batches out of process", "[process]") {
+	auto commit = [](int val) -> pybind11::object { return pybind11::cast(val); };
+	auto callback = [](const pybind11::object& obj) { return obj.cast<int>(); };
+
+	PyManager& manager = getContext().manager;
+	PyManager::HandlerOptions options;
+	options.batch_size = 8;
+	options.prefetch_depth = 2;
+	options.worker_processes = 2;
+
+	PyManager::InvokeHandler reflect =
+		manager.loadPythonModule("tests.test_modules.identity", "invoke", options);
+
+	std::vector<std::future<int>> futures;
+	for(int i = 0; i < 200; i++) {
+		futures.push_back(reflect.queue_invoke(commit, callback, i));
+	}
+	for(int i = 0; i < 200; i++) {
+		REQUIRE(futures[i].get() == i);
+	}
+	REQUIRE(reflect.get_queue_stats().execute_batch_size_ema > 0.0);
+
+	// Synchronous invoke keeps running in the embedded interpreter.
+	REQUIRE(reflect.invoke<int>(5) == 5);
+
+	PyManager::InvokeHandler raises =
+		manager.loadPythonModule("tests.test_modules.raises", "invoke", options);
+	std::vector<std::future<int>> failing;
+	for(int i = 0; i < 4; i++) {
+		failing.push_back(raises.queue_invoke(commit, callback, i));
+	}
+	for(auto& f : failing) {
+		REQUIRE_THROWS_AS(f.get(), std::runtime_error);
+	}
+
+	options.max_inflight_batches = 2;
+	REQUIRE_THROWS_AS(manager.loadPythonModule("tests.test_modules.identity", "invoke", options),
+					  std::invalid_argument);
+}
+
+TEST_CASE("Handler metrics record every phase and export as OpenMetrics", "[metrics]") {
+	auto commit = [](int val) -> pybind11::object { return pybind11::cast(val); };
+	auto callback = [](const pybind11::object& obj) { return obj.cast<int>(); };
+
+	PyManager& manager = getContext().manager;
+	PyManager::HandlerOptions options;
+	options.batch_size = 4;
+	options.prefetch_depth = 2;
+	options.name = "metrics-test";
+	PyManager::InvokeHandler reflect =
+		manager.loadPythonModule("tests.test_modules.identity", "invoke", options);
+
+	std::vector<std::future<int>> futures;
+	for(int i = 0; i < 32; i++) {
+		futures.push_back(reflect.queue_invoke(commit, callback, i));
+	}
+	for(auto& future : futures) {
+		future.get();
+	}
+
+	HandlerMetricsSnapshot metrics = reflect.get_metrics();
+	REQUIRE(metrics.handler == "metrics-test");
+	REQUIRE(metrics.total_enqueued == 32);
+	REQUIRE(metrics.queue_wait_ns.count == 32);
+	REQUIRE(metrics.commit_ns.count == 32);
+	REQUIRE(metrics.hold_ns.count == 32);
+	REQUIRE(metrics.batch_size.count == metrics.execute_batch_ns.count);
+	REQUIRE(metrics.batch_size.sum == 32);
+	REQUIRE(metrics.batch_size.max <= 4);
+	REQUIRE(metrics.fanout_ns.count == metrics.execute_batch_ns.count);
+	REQUIRE(metrics.execute_batch_ns.percentile(0.99) > 0);
+	REQUIRE(metrics.oldest_item_age_ns == 0);
+
+	PyManager::InvokeHandler unnamed = manager.loadPythonModule("tests.test_modules.identity");
+	MetricsSnapshot snapshot = PyManager::metrics_snapshot();
+	bool found_named = false;
+	bool found_default = false;
+	for(const HandlerMetricsSnapshot& handler : snapshot.handlers) {
+		found_named |= handler.id == metrics.id && handler.handler == "metrics-test";
+		found_default |= handler.handler == "tests.test_modules.identity.invoke";
+	}
+	REQUIRE(found_named);
+	REQUIRE(found_default);
+
+	std::string text = renderOpenMetrics(snapshot);
+	REQUIRE(text.find("pyscheduler_enqueued_total{handler=\"metrics-test\",id=\"" +
+					  std::to_string(metrics.id) + "\"} 32") != std::string::npos);
+	REQUIRE(text.find("pyscheduler_execute_batch_seconds{handler=\"metrics-test\"") !=
+			std::string::npos);
+}
+
+TEST_CASE("Traced requests export Chrome trace spans", "[trace]") {
+	auto commit = [](int val) -> pybind11::object { return pybind11::cast(val); };
+	auto callback = [](const pybind11::object& obj) { return obj.cast<int>(); };
+
+	PyManager& manager = getContext().manager;
+	PyManager::InvokeHandler reflect =
+		manager.loadPythonModule("tests.test_modules.identity", "invoke", 4, 2);
+
+	Tracer::clear();
+	Tracer::enable();
+	std::vector<std::future<int>> futures;
+	for(int i = 0; i < 8; i++) {
+		futures.push_back(reflect.queue_invoke(commit, callback, i));
+	}
+	for(auto& future : futures) {
+		future.get();
+	}
+	Tracer::disable();
+	// An untraced request leaves no events, and once it completes the worker has finished
+	// recording the callbacks of every traced batch before it.
+	reflect.queue_invoke(commit, callback, 8).get();
+
+	auto count = [](const std::string& text, const std::string& needle) {
+		size_t found = 0;
+		for(size_t pos = text.find(needle); pos != std::string::npos;
+			pos = text.find(needle, pos + 1)) {
+			found++;
+		}
+		return found;
+	};
+
+	std::string json = Tracer::dump_chrome_json();
+	REQUIRE(json.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0) == 0);
+	REQUIRE(count(json, "\"name\":\"request\",\"cat\":\"request\",\"ph\":\"b\"") == 8);
+	REQUIRE(count(json, "\"name\":\"execute\",\"cat\":\"request\",\"ph\":\"e\"") == 8);
+	REQUIRE(count(json, "\"name\":\"queued\"") == 16);
+	REQUIRE(count(json, "\"name\":\"execute batch\"") >= 2);
+
+	Tracer::clear();
+	REQUIRE(count(Tracer::dump_chrome_json(), "\"ph\"") == 0);
+}
+
+TEST_CASE("GIL profiler charges wait and scope time to handlers and threads", "[gil]") {
+	auto commit = [](int val) -> pybind11::object { return pybind11::cast(val); };
+	auto callback = [](const pybind11::object& obj) { return obj.cast<int>(); };
+
+	PyManager& manager = getContext().manager;
+	PyManager::InvokeHandler reflect =
+		manager.loadPythonModule("tests.test_modules.identity", "invoke", 4, 2);
+
+	std::vector<std::future<int>> futures;
+	for(int i = 0; i < 16; i++) {
+		futures.push_back(reflect.queue_invoke(commit, callback, i));
+	}
+	for(auto& future : futures) {
+		future.get();
+	}
+
+	GilStats worker = reflect.get_gil_stats();
+	REQUIRE(worker.acquisitions > 0);
+	REQUIRE(worker.wait_ns.count == worker.acquisitions);
+	REQUIRE(worker.scope_ns > 0);
+	REQUIRE(reflect.get_metrics().gil.acquisitions >= worker.acquisitions);
+
+	// Synchronous invoke is charged to the handler and the calling thread
+	const uint32_t tid = static_cast<uint32_t>(::syscall(SYS_gettid));
+	auto thread_acquisitions = [tid] {
+		for(const ThreadGilStats& thread : GilProfiler::thread_stats()) {
+			if(thread.tid == tid) return thread.stats.acquisitions;
+		}
+		return uint64_t{ 0 };
+	};
+	const uint64_t before = reflect.get_gil_stats().acquisitions;
+	const uint64_t thread_before = thread_acquisitions();
+	REQUIRE(reflect.invoke<int>(1) == 1);
+	REQUIRE(reflect.get_gil_stats().acquisitions >= before + 1);
+	REQUIRE(thread_acquisitions() == thread_before + 1);
+
+	// Nested acquisitions on a thread already holding the GIL are not counted
+	{
+		pybind11::gil_scoped_acquire gil;
+		REQUIRE(reflect.invoke<int>(2) == 2);
+	}
+	REQUIRE(thread_acquisitions() == thread_before + 1);
+
+	REQUIRE(renderOpenMetrics(PyManager::metrics_snapshot()).find(
+				"pyscheduler_gil_wait_seconds_count{") != std::string::npos);
+}
+
+TEST_CASE("Python profiling produces folded stacks for the next batches", "[profile]") {
+	auto commit = [](int val) -> pybind11::object { return pybind11::cast(val); };
+	auto callback = [](const pybind11::object& obj) { return obj.cast<int>(); };
+
+	PyManager& manager = getContext().manager;
+	PyManager::HandlerOptions options;
+	options.batch_size = 4;
+	options.name = "profiled-test";
+	PyManager::InvokeHandler handler =
+		manager.loadPythonModule("tests.test_modules.profiled", "invoke", options);
+
+	REQUIRE_THROWS_AS(handler.profile_python(0), std::invalid_argument);
+	std::future<std::string> profile = handler.profile_python(2);
+	REQUIRE_THROWS_AS(handler.profile_python(1), std::logic_error);
+
+	std::vector<std::future<int>> futures;
+	for(int i = 0; i < 8; i++) {
+		futures.push_back(handler.queue_invoke(commit, callback, i));
+	}
+	for(size_t i = 0; i < futures.size(); i++) {
+		REQUIRE(futures[i].get() == static_cast<int>(i * i));
+	}
+
+	REQUIRE(profile.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+	std::string folded = profile.get();
+	REQUIRE(folded.find("profiled-test;invoke (") != std::string::npos);
+	REQUIRE(folded.find(";square (") != std::string::npos);
+	REQUIRE(folded.find("<built-in> list.append") != std::string::npos);
+	// Every line is "frames <weight>"
+	size_t line_start = 0;
+	while(line_start < folded.size()) {
+		size_t line_end = folded.find('\n', line_start);
+		REQUIRE(line_end != std::string::npos);
+		std::string line = folded.substr(line_start, line_end - line_start);
+		REQUIRE(line.rfind("profiled-test;", 0) == 0);
+		size_t space = line.rfind(' ');
+		REQUIRE(space != std::string::npos);
+		REQUIRE(std::stoull(line.substr(space + 1)) > 0);
+		line_start = line_end + 1;
+	}
+
+	// The profile is finished; another one may start
+	std::future<std::string> next = handler.profile_python(1);
+	REQUIRE(handler.queue_invoke(commit, callback, 3).get() == 9);
+	REQUIRE(next.get().find(";square (") != std::string::npos);
+
+	// Shutting down resolves a pending profile with what it recorded, possibly nothing
+	std::future<std::string> partial;
+	std::future<std::string> unstarted;
+	{
+		PyManager::InvokeHandler short_lived =
+			manager.loadPythonModule("tests.test_modules.profiled", "invoke", options);
+		partial = short_lived.profile_python(100);
+		REQUIRE(short_lived.queue_invoke(commit, callback, 2).get() == 4);
+	}
+	REQUIRE(partial.get().find(";square (") != std::string::npos);
+	{
+		PyManager::InvokeHandler idle =
+			manager.loadPythonModule("tests.test_modules.profiled", "invoke", options);
+		unstarted = idle.profile_python(1);
+	}
+	REQUIRE(unstarted.get().empty());
+}
+
+TEST_CASE("Warmup runs before the first request and reports its duration", "[warmup]") {
+	auto commit = [](int val) -> pybind11::object { return pybind11::cast(val); };
+	auto callback = [](const pybind11::object& obj) { return obj.cast<int>(); };
+
+	PyManager& manager = getContext().manager;
+	auto stats = manager.loadPythonModule("tests.test_modules.warmup", "stats");
+
+	PyManager::HandlerOptions options;
+	options.batch_size = 4;
+	options.warmup_function = "warmup";
+	options.warmup_batch_sizes = { 1, 4 };
+	PyManager::InvokeHandler warm =
+		manager.loadPythonModule("tests.test_modules.warmup", "invoke", options);
+	// Queued before the handler is warm: served after the warmup batches
+	std::future<int> early = warm.queue_invoke(commit, callback, 7);
+
+	PyManager::WarmupReport report = warm.ready().get();
+	REQUIRE(report.batches.size() == 2);
+	REQUIRE(report.batches[0].first == 1);
+	REQUIRE(report.batches[1].first == 4);
+	REQUIRE(report.total >= report.function + report.batches[0].second);
+	REQUIRE(early.get() == 7);
+
+	auto [warmup_calls, batch_sizes] = stats.invoke<std::pair<int, std::vector<int>>>();
+	REQUIRE(warmup_calls == 1);
+	REQUIRE(batch_sizes.size() >= 3);
+	REQUIRE(batch_sizes[0] == 1);
+	REQUIRE(batch_sizes[1] == 4);
+	// The warmup calls stay out of the handler's metrics
+	REQUIRE(warm.get_metrics().batch_size.sum == 1);
+
+	{ // C++ batch builder at the default batch size
+		PyManager::HandlerOptions built;
+		built.batch_size = 8;
+		built.warmup_batch = [](size_t size) {
+			pybind11::list batch;
+			for(size_t i = 0; i < size; i++) {
+				batch.append(static_cast<int>(i));
+			}
+			return batch;
+		};
+		PyManager::InvokeHandler handler =
+			manager.loadPythonModule("tests.test_modules.warmup", "invoke", built);
+		report = handler.ready().get();
+		REQUIRE(report.batches.size() == 1);
+		REQUIRE(report.batches[0].first == 8);
+		REQUIRE(report.function.count() == 0);
+	}
+
+	{ // Failures surface through ready() and the handler still serves
+		PyManager::HandlerOptions broken;
+		broken.warmup_function = "broken_warmup";
+		PyManager::InvokeHandler handler =
+			manager.loadPythonModule("tests.test_modules.warmup", "invoke", broken);
+		REQUIRE_THROWS_AS(handler.ready().get(), std::runtime_error);
+		REQUIRE(handler.queue_invoke(commit, callback, 3).get() == 3);
+	}
+
+	{ // Unknown warmup functions and process workers are rejected at load
+		PyManager::HandlerOptions missing;
+		missing.warmup_function = "does_not_exist";
+		REQUIRE_THROWS_AS(
+			manager.loadPythonModule("tests.test_modules.warmup", "invoke", missing),
+			std::invalid_argument);
+		PyManager::HandlerOptions remote;
+		remote.warmup_function = "warmup";
+		remote.worker_processes = 1;
+		REQUIRE_THROWS_AS(
+			manager.loadPythonModule("tests.test_modules.warmup", "invoke", remote),
+			std::invalid_argument);
+	}
+
+	PyManager::InvokeHandler cold = manager.loadPythonModule("tests.test_modules.identity");
+	REQUIRE(cold.ready().get().batches.empty());
+}
+
+TEST_CASE("Pipelines chain stages in Python with per-stage batch sizes", "[pipeline]") {
+	auto commit = [](int val) -> pybind11::object { return pybind11::cast(val); };
+	auto callback = [](const pybind11::object& obj) { return obj.cast<int>(); };
+
+	PyManager& manager = getContext().manager;
+	auto take_calls = manager.loadPythonModule("tests.test_modules.pipeline", "take_calls");
+	take_calls.invoke<std::vector<std::pair<std::string, size_t>>>();
+
+	PyManager::InvokeHandler pipeline =
+		manager.loadPipeline({ { "tests.test_modules.pipeline", "tokenize", 4 },
+							   { "tests.test_modules.pipeline", "model", 2 },
+							   { "tests.test_modules.pipeline", "postprocess", 0 } });
+
+	std::vector<std::future<int>> futures;
+	for(int i = 0; i < 16; i++) {
+		futures.push_back(pipeline.queue_invoke(commit, callback, i));
+	}
+	for(int i = 0; i < 16; i++) {
+		REQUIRE(futures[i].get() == 2 * i + 1);
+	}
+	REQUIRE(pipeline.get_metrics().handler ==
+			"tests.test_modules.pipeline.tokenize->tests.test_modules.pipeline.model->"
+			"tests.test_modules.pipeline.postprocess");
+
+	size_t tokenized = 0;
+	size_t modeled = 0;
+	for(const auto& [stage, size] :
+		take_calls.invoke<std::vector<std::pair<std::string, size_t>>>()) {
+		REQUIRE(size >= 1);
+		if(stage == "tokenize") {
+			REQUIRE(size <= 4);
+			tokenized += size;
+		} else if(stage == "model") {
+			REQUIRE(size <= 2);
+			modeled += size;
+		} else {
+			REQUIRE(stage == "postprocess");
+			REQUIRE(size <= 4);
+		}
+	}
+	REQUIRE(tokenized == 16);
+	REQUIRE(modeled == 16);
+
+	// The handler owns the only reference to the pipeline callable; dropping it and moving
+	// over it must release that reference with the GIL held
+	for(int i = 0; i < 32; i++) {
+		PyManager::InvokeHandler transient =
+			manager.loadPipeline({ { "tests.test_modules.pipeline", "tokenize" },
+								   { "tests.test_modules.pipeline", "model" } });
+		REQUIRE(transient.queue_invoke(commit, callback, i).get() == 2 * i);
+		transient = manager.loadPipeline({ { "tests.test_modules.pipeline", "tokenize" } });
+	}
+
+	// A stage that drops items fails the whole batch
+	PyManager::HandlerOptions options;
+	options.batch_size = 2;
+	PyManager::InvokeHandler broken =
+		manager.loadPipeline({ { "tests.test_modules.pipeline", "tokenize" },
+							   { "tests.test_modules.pipeline", "drop_first" } },
+							 options);
+	std::future<int> lost = broken.queue_invoke(commit, callback, 1);
+	REQUIRE_THROWS(lost.get());
+
+	REQUIRE_THROWS_AS(manager.loadPipeline({ }), std::invalid_argument);
+	REQUIRE_THROWS_AS(manager.loadPipeline({ { "tests.test_modules.pipeline", "missing" } }),
+					  std::invalid_argument);
+	options.worker_processes = 1;
+	REQUIRE_THROWS_AS(
+		manager.loadPipeline({ { "tests.test_modules.pipeline", "tokenize" } }, options),
+		std::invalid_argument);
+}
+
+TEST_CASE("Keyed batching groups items of one key per batch", "[keyed]") {
+	auto castKey = [](const pybind11::object& obj) { return obj.cast<int>(); };
+	using Batches = std::vector<std::vector<int>>;
+
+	PyManager& manager = getContext().manager;
+	auto take_batches = manager.loadPythonModule("tests.test_modules.keyed", "take_batches");
+	take_batches.invoke<Batches>();
+
+	// Every batch the entry point saw holds one key; batches hold at most 4 items
+	auto requireHomogeneous = [&](size_t items) {
+		Batches batches = take_batches.invoke<Batches>();
+		REQUIRE(batches.size() >= items / 4);
+		for(const auto& keys : batches) {
+			REQUIRE(keys.size() == 1);
+		}
+	};
+
+	{ // Key extractor registered on the handler
+		PyManager::HandlerOptions options;
+		options.batch_size = 4;
+		options.prefetch_depth = 8;
+		options.batch_key = [](const pybind11::object& obj) {
+			return static_cast<uint64_t>(pybind11::len(obj));
+		};
+		PyManager::InvokeHandler handler =
+			manager.loadPythonModule("tests.test_modules.keyed", "invoke", options);
+
+		auto commitStr = [](size_t length) -> pybind11::object {
+			return pybind11::str(std::string(length, 'x'));
+		};
+		std::vector<std::future<int>> futures;
+		for(size_t i = 0; i < 48; i++) {
+			futures.push_back(handler.queue_invoke(commitStr, castKey, 1 + i % 3));
+		}
+		for(size_t i = 0; i < futures.size(); i++) {
+			REQUIRE(futures[i].get() == static_cast<int>(1 + i % 3));
+		}
+		requireHomogeneous(futures.size());
+	}
+
+	{ // Keys given per item
+		PyManager::HandlerOptions options;
+		options.batch_size = 4;
+		options.prefetch_depth = 8;
+		PyManager::InvokeHandler handler =
+			manager.loadPythonModule("tests.test_modules.keyed", "invoke", options);
+
+		auto commit = [](int val) -> pybind11::object { return pybind11::cast(val); };
+		std::vector<std::future<int>> futures;
+		for(int i = 0; i < 48; i++) {
+			futures.push_back(handler.queue_invoke_keyed(
+				static_cast<uint64_t>(i % 3), commit, castKey, i));
+		}
+		for(int i = 0; i < 48; i++) {
+			REQUIRE(futures[i].get() == i % 3);
+		}
+		requireHomogeneous(futures.size());
+	}
+}
+
+TEST_CASE("Replicated handlers spread requests over their replicas", "[replicated]") {
+	auto commit = [](int val) -> pybind11::object { return pybind11::cast(val); };
+	auto callback = [](const pybind11::object& obj) { return obj.cast<int>(); };
+
+	PyManager& manager = getContext().manager;
+	PyManager::HandlerOptions options;
+	options.batch_size = 2;
+	PyManager::ReplicatedHandler handler =
+		manager.loadReplicated("tests.test_modules.replicated", "invoke", 3, options);
+	REQUIRE(handler.size() == 3);
+	REQUIRE(handler.replica(2).get_metrics().handler == "tests.test_modules.replicated.invoke[2]");
+
+	std::vector<std::future<int>> futures;
+	for(int i = 0; i < 30; i++) {
+		futures.push_back(handler.queue_invoke(commit, callback, i));
+	}
+	for(int i = 0; i < 30; i++) {
+		REQUIRE(futures[i].get() == 2 * i);
+	}
+
+	for(const auto& stats : handler.get_replica_stats()) {
+		REQUIRE(stats.total_enqueued > 0);
+	}
+	auto total = handler.get_queue_stats();
+	REQUIRE(total.total_enqueued == 30);
+	REQUIRE(total.total_completed == 30);
+	for(size_t i = 0; i < handler.size(); i++) {
+		REQUIRE(handler.replica(i).outstanding() == 0);
+	}
+
+	// The entry point sleeps without the GIL, so replicas overlap
+	auto peak = manager.loadPythonModule("tests.test_modules.replicated", "peak_concurrency");
+	REQUIRE(peak.invoke<int>() > 1);
+
+	REQUIRE_THROWS_AS(manager.loadReplicated("tests.test_modules.replicated", "invoke", 0),
+					  std::invalid_argument);
+}
+
+TEST_CASE("Handler workers run on their configured CPUs", "[affinity]") {
+	cpu_set_t allowed;
+	REQUIRE(sched_getaffinity(0, sizeof(allowed), &allowed) == 0);
+	int cpu = 0;
+	while(!CPU_ISSET(cpu, &allowed)) {
+		cpu++;
+	}
+
+	PyManager& manager = getContext().manager;
+	PyManager::HandlerOptions options;
+	options.worker_affinity.cpus = { cpu };
+	PyManager::InvokeHandler handler =
+		manager.loadPythonModule("tests.test_modules.identity", "invoke", options);
+
+	// The callback runs on the worker thread
+	auto commit = [](int val) -> pybind11::object { return pybind11::cast(val); };
+	auto pinned = [cpu](const pybind11::object&) {
+		cpu_set_t set;
+		sched_getaffinity(0, sizeof(set), &set);
+		return CPU_COUNT(&set) == 1 && CPU_ISSET(cpu, &set);
+	};
+	REQUIRE(handler.queue_invoke(commit, pinned, 1).get());
+
+	REQUIRE(numaNodeCpus(-1).empty());
+	REQUIRE_THROWS_AS(resolveAffinityCpus(ThreadAffinity{ { -1 } }), std::invalid_argument);
+	REQUIRE_THROWS_AS(resolveAffinityCpus(ThreadAffinity{ { }, 4096 }), std::invalid_argument);
+	REQUIRE_THROWS_AS(resolveAffinityCpus(ThreadAffinity{ { }, -1, true }),
+					  std::invalid_argument);
+	options.worker_affinity.cpus = { -1 };
+	REQUIRE_THROWS_AS(manager.loadPythonModule("tests.test_modules.identity", "invoke", options),
+					  std::invalid_argument);
+}
+
+TEST_CASE("Generator entry points stream partial results", "[stream]") {
+	auto commit = [](int val) -> pybind11::object { return pybind11::cast(val); };
+	auto toString = [](const pybind11::object& obj) { return obj.cast<std::string>(); };
+
+	PyManager& manager = getContext().manager;
+	PyManager::InvokeHandler generate =
+		manager.loadPythonModule("tests.test_modules.streaming", "generate", 4);
+
+	ResultStream<std::string> stream = generate.queue_invoke_stream(commit, toString, 3);
+	std::future<std::string> last = generate.queue_invoke(commit, toString, 2);
+	std::vector<std::string> tokens;
+	for(const std::string& token : stream) {
+		tokens.push_back(token);
+	}
+	REQUIRE(tokens == std::vector<std::string>{ "3:0", "3:1", "3:2" });
+	REQUIRE(stream.done());
+	REQUIRE_FALSE(stream.next().has_value());
+	// Plain requests complete with their last partial result
+	REQUIRE(last.get() == "2:1");
+
+	// The generator's exception ends the stream after the partials before it
+	PyManager::InvokeHandler broken =
+		manager.loadPythonModule("tests.test_modules.streaming", "broken");
+	ResultStream<std::string> failing = broken.queue_invoke_stream(commit, toString, 1);
+	REQUIRE(failing.next() == "first");
+	REQUIRE_THROWS(failing.next());
+
+	// A list-returning entry point delivers each result as a single partial
+	PyManager::InvokeHandler identity =
+		manager.loadPythonModule("tests.test_modules.identity", "invoke");
+	auto castInt = [](const pybind11::object& obj) { return obj.cast<int>(); };
+	ResultStream<int> single = identity.queue_invoke_stream(commit, castInt, 7);
+	REQUIRE(single.next() == 7);
+	REQUIRE_FALSE(single.next().has_value());
+}
+
+TEST_CASE("async def entry points keep several batches in flight", "[async]") {
+	auto commit = [](int val) -> pybind11::object { return pybind11::cast(val); };
+	auto callback = [](const pybind11::object& obj) { return obj.cast<int>(); };
+
+	PyManager& manager = getContext().manager;
+	PyManager::HandlerOptions options;
+	options.batch_size = 2;
+	options.max_inflight_batches = 4;
+	PyManager::InvokeHandler handler =
+		manager.loadPythonModule("tests.test_modules.async_io", "invoke", options);
+
+	std::vector<std::future<int>> futures;
+	for(int i = 0; i < 16; i++) {
+		futures.push_back(handler.queue_invoke(commit, callback, i));
+	}
+	for(int i = 0; i < 16; i++) {
+		REQUIRE(futures[i].get() == i + 1);
+	}
+	REQUIRE(handler.get_queue_stats().total_completed == 16);
+
+	auto peak = manager.loadPythonModule("tests.test_modules.async_io", "peak_inflight");
+	int inflight = peak.invoke<int>();
+	REQUIRE(inflight > 1);
+	REQUIRE(inflight <= 4);
+
+	PyManager::InvokeHandler broken =
+		manager.loadPythonModule("tests.test_modules.async_io", "broken");
+	std::future<int> failed = broken.queue_invoke(commit, callback, 1);
+	REQUIRE_THROWS(failed.get());
+
+	options.max_inflight_batches = 0;
+	REQUIRE_THROWS_AS(manager.loadPythonModule("tests.test_modules.async_io", "invoke", options),
+					  std::invalid_argument);
+}
+
+TEST_CASE("Byte buffers cross into Python and back without copies", "[bytes]") {
+	PyManager& manager = getContext().manager;
+	PyManager::InvokeHandler describe =
+		manager.loadPythonModule("tests.test_modules.blobs", "describe", 4);
+
+	// Tracks when Python releases the committed storage
+	struct TrackedBytes {
+		std::string bytes;
+		std::shared_ptr<int> alive = std::make_shared<int>(0);
+		const char* data() const {
+			return bytes.data();
+		}
+		size_t size() const {
+			return bytes.size();
+		}
+	};
+	std::weak_ptr<int> alive;
+	bool zero_copy = false;
+	auto commit = [&](size_t size) -> pybind11::object {
+		TrackedBytes blob{ std::string(size, 'x') };
+		alive = blob.alive;
+		const char* storage = blob.bytes.data();
+		pybind11::memoryview view = makeBytesView(std::move(blob));
+		zero_copy = bytesView(view).data() == storage;
+		return view;
+	};
+	using Description = std::tuple<std::string, bool, size_t, int>;
+	auto callback = [](const pybind11::object& obj) { return obj.cast<Description>(); };
+
+	auto description = describe.queue_invoke(commit, callback, size_t{ 1 } << 20).get();
+	REQUIRE(description == Description{ "memoryview", true, size_t{ 1 } << 20, 'x' });
+	REQUIRE(zero_copy);
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while(!alive.expired() && std::chrono::steady_clock::now() < deadline) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	REQUIRE(alive.expired());
+
+	// Reverse path: read a bytes result in place
+	PyManager::InvokeHandler make = manager.loadPythonModule("tests.test_modules.blobs", "make");
+	auto commitSize = [](size_t size) -> pybind11::object { return pybind11::cast(size); };
+	auto zeros = [](const pybind11::object& obj) {
+		std::string_view bytes = bytesView(obj);
+		return bytes.size() == 4096 && bytes.find_first_not_of('\0') == std::string_view::npos;
+	};
+	REQUIRE(make.queue_invoke(commitSize, zeros, size_t{ 4096 }).get());
+	PyManager::InvokeHandler lengths =
+		manager.loadPythonModule("tests.test_modules.blobs", "lengths");
+	auto notBytes = [](const pybind11::object& obj) { return bytesView(obj).size(); };
+	REQUIRE_THROWS_AS(lengths.queue_invoke(commit, notBytes, size_t{ 16 }).get(),
+					  std::invalid_argument);
+}
+
+// Heap allocations made by the calling thread; operator new is replaced for the whole test
+// binary so the worker's steady state can be checked for allocations.
+static thread_local size_t t_allocations = 0;
+
+void* operator new(std::size_t size) {
+	t_allocations++;
+	if(void* ptr = std::malloc(size == 0 ? 1 : size)) return ptr;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+
+TEST_CASE("Worker loop does not allocate in steady state", "[alloc]") {
+	PyManager& manager = getContext().manager;
+
+	// Allocations the worker made since the previous batch, one slot per batch
+	std::array<size_t, 512> allocations{ };
+	std::atomic<size_t> batches{ 0 };
+	size_t last_count = 0;
+	PyManager::HandlerOptions options;
+	options.batch_size = 4;
+	options.prefetch_depth = 2;
+	options.batch_hook = [&](size_t) {
+		const size_t index = batches.load(std::memory_order_relaxed);
+		if(index < allocations.size()) allocations[index] = t_allocations - last_count;
+		last_count = t_allocations;
+		batches.store(index + 1, std::memory_order_release);
+	};
+	PyManager::InvokeHandler handler =
+		manager.loadPythonModule("tests.test_modules.identity", "invoke", options);
+
+	auto commitInt = [](int n) -> pybind11::object { return pybind11::int_(n); };
+	auto castInt = [](const pybind11::object& obj) { return obj.cast<int>(); };
+	std::vector<std::future<int>> futures;
+	futures.reserve(8);
+	for(int round = 0; round < 64; round++) {
+		futures.clear();
+		for(int i = 0; i < 8; i++) {
+			futures.push_back(handler.queue_invoke(commitInt, castInt, round * 8 + i));
+		}
+		for(int i = 0; i < 8; i++) {
+			REQUIRE(futures[i].get() == round * 8 + i);
+		}
+	}
+
+	// The first batches size the reusable containers; every later one reuses them
+	const size_t recorded = std::min(batches.load(std::memory_order_acquire), allocations.size());
+	REQUIRE(recorded >= 64 * 8 / 4);
+	for(size_t i = 8; i < recorded; i++) {
+		INFO("batch " << i);
+		REQUIRE(allocations[i] == 0);
+	}
+}
+
+TEST_CASE("Failed batches are bisected down to the poison item", "[bisect]") {
+	PyManager& manager = getContext().manager;
+	PyManager::HandlerOptions options;
+	options.batch_size = 8;
+	options.warmup_function = "warmup";
+	options.bisect_failed_batches = true;
+	PyManager::InvokeHandler handler =
+		manager.loadPythonModule("tests.test_modules.poison", "invoke", options);
+
+	auto commitInt = [](int n) -> pybind11::object { return pybind11::int_(n); };
+	auto castInt = [](const pybind11::object& obj) { return obj.cast<int>(); };
+	std::vector<std::future<int>> futures;
+	for(int i = 0; i < 8; i++) {
+		futures.push_back(handler.queue_invoke(commitInt, castInt, i == 3 ? -1 : i));
+	}
+	for(int i = 0; i < 8; i++) {
+		if(i == 3) {
+			REQUIRE_THROWS_AS(futures[i].get(), pybind11::error_already_set);
+		} else {
+			REQUIRE(futures[i].get() == 2 * i);
+		}
+	}
+
+	// 8 -> {0..3} fails -> {2, 3} fails -> {3}: two calls per level
+	auto stats = handler.get_queue_stats();
+	REQUIRE(stats.bisected_batches == 1);
+	REQUIRE(stats.bisect_retries == 6);
+	REQUIRE(stats.bisect_failed_items == 1);
+	REQUIRE(stats.bisect_python_ns > 0);
+}
+
+TEST_CASE("Batch results are written into caller-provided rows", "[into]") {
+	PyManager& manager = getContext().manager;
+	auto commitInt = [](int n) -> pybind11::object { return pybind11::int_(n); };
+	constexpr size_t kRows = 16;
+	constexpr size_t kWidth = 4;
+
+	for(const char* entry : { "scaled", "scaled_list" }) {
+		PyManager::InvokeHandler handler =
+			manager.loadPythonModule("tests.test_modules.rows", entry, 8);
+		std::vector<float> output(kRows * kWidth, -1.0f);
+		CompletionGroup group;
+		for(size_t row = 0; row < kRows; row++) {
+			handler.queue_invoke_into(commitInt,
+									  std::span<float>(output).subspan(row * kWidth, kWidth),
+									  group,
+									  static_cast<int>(row));
+		}
+		group.wait();
+		REQUIRE(group.pending() == 0);
+		for(size_t row = 0; row < kRows; row++) {
+			for(size_t col = 0; col < kWidth; col++) {
+				REQUIRE(output[row * kWidth + col] == static_cast<float>(row * col));
+			}
+		}
+	}
+
+	// A row that does not fit fails the group; the group is reusable afterwards
+	PyManager::InvokeHandler short_rows =
+		manager.loadPythonModule("tests.test_modules.rows", "short");
+	std::vector<float> output(kWidth);
+	CompletionGroup group;
+	short_rows.queue_invoke_into(commitInt, std::span<float>(output), group, 1);
+	REQUIRE_THROWS_AS(group.wait(), std::invalid_argument);
+	REQUIRE_NOTHROW(group.wait());
+	REQUIRE(group.wait_for(std::chrono::milliseconds(1)));
+
+	// int32 rows have the width of float but must not be reinterpreted as floats
+	PyManager::InvokeHandler int_rows = manager.loadPythonModule("tests.test_modules.rows", "ints");
+	std::vector<int32_t> ints(kWidth);
+	int_rows.queue_invoke_into(commitInt, std::span<float>(output), group, 3);
+	REQUIRE_THROWS_AS(group.wait(), std::invalid_argument);
+	int_rows.queue_invoke_into(commitInt, std::span<int32_t>(ints), group, 3);
+	group.wait();
+	REQUIRE(ints == std::vector<int32_t>{ 0, 3, 6, 9 });
+}
+
+TEST_CASE("PyManager can be constructed without blocking", "[startup]") {
+	getContext();
+
+	// The interpreter is already up: later startup options other than preimport are ignored
+	// and the boot future is ready at once
+	PyManager::StartupOptions options;
+	options.optimization_level = 2;
+	std::shared_future<void> ready = PyManager::start_interpreter(options);
+	REQUIRE(ready.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+	REQUIRE_NOTHROW(ready.get());
+
+	// A failing preimport fails its own call only; the interpreter stays usable and the
+	// preimport can be retried
+	PyManager::StartupOptions missing;
+	missing.preimport = { "tests.test_modules.does_not_exist" };
+	REQUIRE_THROWS_AS(PyManager::start_interpreter(missing).get(), std::runtime_error);
+	REQUIRE_THROWS_AS(PyManager::start_interpreter(missing).get(), std::runtime_error);
+	PyManager::StartupOptions present;
+	present.preimport = { "tests.test_modules.startup" };
+	REQUIRE_NOTHROW(PyManager::start_interpreter(present).get());
+
+	const uint64_t base_arc = PyManager::debug_arc_count();
+	{
+		std::future<std::unique_ptr<PyManager>> pending = PyManager::create_async();
+		std::unique_ptr<PyManager> manager = pending.get();
+		REQUIRE(PyManager::debug_arc_count() == base_arc + 1);
+
+		PyManager::InvokeHandler flags = manager->loadPythonModule("tests.test_modules.startup");
+		REQUIRE(flags.invoke<int>() == 0);
+	}
+	REQUIRE(PyManager::debug_arc_count() == base_arc);
+}
+
+TEST_CASE("Shared handlers feed one queue per entry point and config", "[shared-handler]") {
+	PyManager& manager = getContext().manager;
+	auto commitInt = [](int n) -> pybind11::object { return pybind11::int_(n); };
+	auto castInt = [](const pybind11::object& obj) { return obj.cast<int>(); };
+
+	{
+		PyManager::SharedHandler first =
+			manager.loadShared("tests.test_modules.identity", "invoke", 8, 2);
+		PyManager::SharedHandler second =
+			manager.loadShared("tests.test_modules.identity", "invoke", 8, 2);
+		PyManager::SharedHandler copy = second;
+		REQUIRE(&*first == &*second);
+		REQUIRE(first.use_count() == 3);
+
+		// A different config gets its own handler
+		PyManager::SharedHandler other =
+			manager.loadShared("tests.test_modules.identity", "invoke", 4, 2);
+		REQUIRE(&*other != &*first);
+
+		std::vector<std::future<int>> futures;
+		for(int i = 0; i < 16; i++) {
+			auto& producer = i % 2 == 0 ? first : copy;
+			futures.push_back(producer->queue_invoke(commitInt, castInt, i));
+		}
+		for(int i = 0; i < 16; i++) {
+			REQUIRE(futures[i].get() == i);
+		}
+		REQUIRE(second->get_queue_stats().total_enqueued == 16);
+		REQUIRE(other->get_queue_stats().total_enqueued == 0);
+	}
+
+	// Released with its last handle; the next use starts a fresh handler
+	PyManager::SharedHandler fresh =
+		manager.loadShared("tests.test_modules.identity", "invoke", 8, 2);
+	REQUIRE(fresh.use_count() == 1);
+	REQUIRE(fresh->get_queue_stats().total_enqueued == 0);
+
+	// A keyed handler batches differently, so it is never shared with an unkeyed one
+	PyManager::HandlerOptions keyed;
+	keyed.batch_size = 8;
+	keyed.prefetch_depth = 2;
+	keyed.batch_key = [](const pybind11::object& obj) { return obj.cast<uint64_t>() % 2; };
+	PyManager::SharedHandler keyed_handler =
+		manager.loadShared("tests.test_modules.identity", "invoke", keyed);
+	REQUIRE(&*keyed_handler != &*fresh);
+
+	// A caller holding the GIL waits for a concurrent first load without deadlocking it
+	PyManager::HandlerOptions options;
+	options.batch_size = 3;
+	{
+		pybind11::gil_scoped_acquire gil;
+		std::optional<PyManager::SharedHandler> loaded_elsewhere;
+		std::thread loader([&] {
+			loaded_elsewhere.emplace(
+				manager.loadShared("tests.test_modules.identity", "invoke", options));
+		});
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		PyManager::SharedHandler here =
+			manager.loadShared("tests.test_modules.identity", "invoke", options);
+		{
+			pybind11::gil_scoped_release release;
+			loader.join();
+		}
+		REQUIRE(&*here == &**loaded_elsewhere);
+	}
+}
+
+TEST_CASE("Embedded pyscheduler module exposes buffers and cross-handler submit", "[embedded]") {
+	PyManager& manager = getContext().manager;
+	auto commitStr = [](const std::string& s) -> pybind11::object { return pybind11::str(s); };
+	auto commitInt = [](int n) -> pybind11::object { return pybind11::int_(n); };
+	auto castInt = [](const pybind11::object& obj) { return obj.cast<int>(); };
+
+	{
+		auto values = std::make_shared<std::vector<float>>(std::vector<float>{ 1.5f, 2.5f, 4.0f });
+		PyManager::register_buffer("embedded-test", values);
+		PyManager::InvokeHandler sums =
+			manager.loadPythonModule("tests.test_modules.embedded", "buffer_sums");
+		auto sum = sums.queue_invoke(
+			commitStr,
+			[](const pybind11::object& obj) { return obj.cast<double>(); },
+			std::string("embedded-test"));
+		REQUIRE(sum.get() == 8.0);
+		REQUIRE(PyManager::unregister_buffer("embedded-test"));
+		REQUIRE_FALSE(PyManager::unregister_buffer("embedded-test"));
+	}
+
+	{
+		PyManager::HandlerOptions options;
+		options.batch_size = 4;
+		options.name = "doubler";
+		PyManager::InvokeHandler doubler =
+			manager.loadPythonModule("tests.test_modules.embedded", "double", options);
+		PyManager::InvokeHandler fan_out =
+			manager.loadPythonModule("tests.test_modules.embedded", "fan_out", 4, 1);
+
+		std::vector<std::future<int>> futures;
+		for(int i = 0; i < 16; i++) {
+			futures.push_back(fan_out.queue_invoke(commitInt, castInt, i));
+		}
+		for(int i = 0; i < 16; i++) {
+			REQUIRE(futures[i].get() == 2 * i + 1);
+		}
+		REQUIRE(doubler.get_queue_stats().total_enqueued == 16);
+	}
+
+	{
+		// No running handler carries the name any more
+		PyManager::InvokeHandler errors =
+			manager.loadPythonModule("tests.test_modules.embedded", "submit_error");
+		auto castStr = [](const pybind11::object& obj) { return obj.cast<std::string>(); };
+		REQUIRE(errors.queue_invoke(commitStr, castStr, std::string("doubler")).get() == "key");
+	}
+
+	{
+		// Items submitted while the target shuts down still resolve, as results or errors
+		PyManager::InvokeHandler submitter =
+			manager.loadPythonModule("tests.test_modules.embedded", "submit_until_gone");
+		for(int round = 0; round < 5; round++) {
+			std::future<int> unresolved;
+			{
+				PyManager::HandlerOptions options;
+				options.name = "doomed";
+				PyManager::InvokeHandler doomed =
+					manager.loadPythonModule("tests.test_modules.embedded", "double", options);
+				unresolved = submitter.queue_invoke(commitStr, castInt, std::string("doomed"));
+				std::this_thread::sleep_for(std::chrono::milliseconds(5));
+			}
+			REQUIRE(unresolved.get() == 0);
+		}
+	}
+}
+
+TEST_CASE("Recorded traffic reads back and replays against a handler", "[record]") {
+	PyManager& manager = getContext().manager;
+	auto commitInt = [](int n) -> pybind11::object { return pybind11::int_(n); };
+	auto castInt = [](const pybind11::object& obj) { return obj.cast<int>(); };
+	const std::filesystem::path path =
+		std::filesystem::temp_directory_path() / "pyscheduler_test_recording.bin";
+
+	{
+		PyManager::InvokeHandler handler =
+			manager.loadPythonModule("tests.test_modules.identity", "invoke", 4, 2);
+		auto recorder = std::make_shared<TrafficRecorder>(path.string());
+		handler.start_recording(recorder);
+		std::vector<std::future<int>> futures;
+		for(int i = 0; i < 20; i++) {
+			futures.push_back(handler.queue_invoke(commitInt, castInt, i));
+		}
+		for(auto& future : futures) {
+			future.get();
+		}
+		handler.stop_recording();
+
+		// Each request is written right after its callback returns
+		const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+		while(recorder->recorded() < 20 && std::chrono::steady_clock::now() < deadline) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		REQUIRE(recorder->recorded() == 20);
+		REQUIRE(recorder->dropped() == 0);
+		recorder->flush();
+	}
+
+	std::vector<RecordedRequest> requests = read_traffic(path.string());
+	REQUIRE(requests.size() == 20);
+	for(const RecordedRequest& request : requests) {
+		REQUIRE_FALSE(request.failed);
+		REQUIRE(request.batch_size >= 1);
+		REQUIRE(request.batch_size <= 4);
+		REQUIRE_FALSE(request.payload.empty());
+	}
+
+	PyManager::InvokeHandler target =
+		manager.loadPythonModule("tests.test_modules.identity", "invoke", 8, 2);
+	ReplayOptions options;
+	options.rate_scale = 4.0;
+	ReplayReport report = replay_traffic(target, requests, options);
+	REQUIRE(report.requests == 20);
+	REQUIRE(report.failed == 0);
+	REQUIRE(report.latency_ns.count == 20);
+	REQUIRE(report.recorded_latency_ns.count == 20);
+	REQUIRE(target.get_queue_stats().total_enqueued == 20);
+
+	{
+		std::ofstream bad(path, std::ios::binary | std::ios::trunc);
+		bad << "not a recording";
+	}
+	REQUIRE_THROWS_AS(read_traffic(path.string()), std::runtime_error);
+	std::filesystem::remove(path);
+}
+
+TEST_CASE("Synchronous invoke routed through the worker joins batches", "[invoke-worker]") {
+	PyManager& manager = getContext().manager;
+	PyManager::HandlerOptions options;
+	options.batch_size = 8;
+	options.invoke_via_worker = true;
+
+	{
+		// Several arguments arrive as one tuple item of the batch
+		PyManager::InvokeHandler add =
+			manager.loadPythonModule("tests.test_modules.add", "add", options);
+		REQUIRE(add.invoke<int>(3, 4) == 7);
+		REQUIRE(add.invoke([](const pybind11::object& obj) { return obj.cast<int>() * 2; },
+						   10,
+						   -4) == 12);
+	}
+
+	{
+		PyManager::InvokeHandler identity =
+			manager.loadPythonModule("tests.test_modules.identity", "invoke", options);
+		std::vector<std::thread> callers;
+		std::atomic<int> mismatches{ 0 };
+		for(int t = 0; t < 8; t++) {
+			callers.emplace_back([&, t] {
+				for(int i = 0; i < 50; i++) {
+					const int value = t * 1000 + i;
+					if(identity.invoke<int>(value) != value) mismatches++;
+				}
+			});
+		}
+		for(auto& caller : callers) {
+			caller.join();
+		}
+		REQUIRE(mismatches.load() == 0);
+		REQUIRE(identity.get_queue_stats().total_enqueued == 400);
+	}
+
+	{
+		// Each batch sleeps, so callers blocked meanwhile share the next one
+		PyManager::InvokeHandler hole =
+			manager.loadPythonModule("tests.test_modules.black_hole", "invoke", options);
+		std::vector<std::thread> callers;
+		std::atomic<int> mismatches{ 0 };
+		for(int t = 0; t < 8; t++) {
+			callers.emplace_back([&, t] {
+				for(int i = 0; i < 4; i++) {
+					const int value = t * 1000 + i;
+					if(hole.invoke<int>(value, 0.02) != value) mismatches++;
+				}
+			});
+		}
+		for(auto& caller : callers) {
+			caller.join();
+		}
+		REQUIRE(mismatches.load() == 0);
+		REQUIRE(hole.get_metrics().batch_size.max > 1);
+		REQUIRE(hole.get_queue_stats().execute_batch_size_ema > 1.0);
+	}
+
+	{
+		// A synchronous call overtakes a backlog of queued items
+		PyManager::HandlerOptions lane_options = options;
+		lane_options.batch_size = 2;
+		PyManager::InvokeHandler hole =
+			manager.loadPythonModule("tests.test_modules.black_hole", "invoke", lane_options);
+		auto commitDelayed = [](int value, double delay) -> pybind11::object {
+			return pybind11::make_tuple(value, delay);
+		};
+		auto castInt = [](const pybind11::object& obj) { return obj.cast<int>(); };
+		std::vector<std::future<int>> backlog;
+		for(int i = 0; i < 20; i++) {
+			backlog.push_back(hole.queue_invoke(commitDelayed, castInt, i, 0.02));
+		}
+		REQUIRE(hole.invoke<int>(-1, 0.02) == -1);
+		REQUIRE(backlog.back().wait_for(std::chrono::seconds(0)) != std::future_status::ready);
+		for(int i = 0; i < 20; i++) {
+			REQUIRE(backlog[i].get() == i);
+		}
+	}
+
+	{
+		PyManager::InvokeHandler raises =
+			manager.loadPythonModule("tests.test_modules.raises", "invoke", options);
+		REQUIRE_THROWS(raises.invoke<int>(1));
+	}
+}
+
+TEST_CASE("Python mutates shared-memory tensors in place via DLPack", "[shm][dlpack]") {
+	PyManager& manager = getContext().manager;
+	auto has_torch = manager.loadPythonModule("tests.test_modules.shm_tensor", "has_torch");
+	if(!has_torch.invoke<bool>()) {
+		SKIP("PyTorch is unavailable in the Python environment");
+	}
+	auto scale = manager.loadPythonModule("tests.test_modules.shm_tensor", "scale_in_place");
+
+	auto arena = ShmArena::create(4096);
+	DLManagedTensor* tensor = createShmTensorDlpack<float>(arena, { 2, 2 });
+	float* data = static_cast<float*>(tensor->dl_tensor.data);
+	std::iota(data, data + 4, 1.f);
+	DLManagedTensor* view = importShmTensorDlpack(describeShmTensor(tensor));
+
+	double total = 0;
+	{
+		pybind11::gil_scoped_acquire gil;
+		total = scale.invoke<double>(makeDlpackCapsule(view), 2.0);
+	}
+
+	REQUIRE(total == 20.0);
+	REQUIRE(data[3] == 8.f);
+	tensor->deleter(tensor);
+}
+
 TEST_CASE("Two plugin DSOs share one PyManager global state", "[shared-state][plugin]") {
 	auto base_arc = PyManager::debug_arc_count();
 
@@ -505,6 +1698,21 @@ TEST_CASE("Two plugin DSOs share one PyManager global state", "[shared-state][pl
 	REQUIRE(arc_a() == base_arc + 2);
 	REQUIRE(arc_b() == base_arc + 2);
 
+	// Both DSOs and the executable attach to the same shared handler
+	auto shared_a =
+		reinterpret_cast<uintptr_t (*)()>(load_symbol(plugin_a, "plugin_load_shared"));
+	auto shared_b =
+		reinterpret_cast<uintptr_t (*)()>(load_symbol(plugin_b, "plugin_load_shared"));
+	const uintptr_t handler_a = shared_a();
+	REQUIRE(shared_b() == handler_a);
+	{
+		PyManager manager;
+		PyManager::SharedHandler local =
+			manager.loadShared("tests.test_modules.identity", "invoke", 8, 2);
+		REQUIRE(reinterpret_cast<uintptr_t>(&*local) == handler_a);
+		REQUIRE(local.use_count() == 3);
+	}
+
 	stop_b();
 	REQUIRE(arc_a() == base_arc + 1);
 
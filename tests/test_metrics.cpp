@@ -0,0 +1,86 @@
+#include "pyscheduler/metrics.hpp"
+#include <catch2/catch_all.hpp>
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace pyscheduler;
+
+TEST_CASE("Histogram buckets cover every value with bounded relative error", "[metrics]") {
+	for(uint64_t value : { uint64_t{ 0 },
+						   uint64_t{ 15 },
+						   uint64_t{ 16 },
+						   uint64_t{ 1000 },
+						   uint64_t{ 123456789 },
+						   UINT64_MAX }) {
+		size_t index = LatencyHistogram::bucket_index(value);
+		REQUIRE(index < LatencyHistogram::kBucketCount);
+		REQUIRE(LatencyHistogram::bucket_lower_bound(index) <= value);
+		REQUIRE(LatencyHistogram::bucket_upper_bound(index) >= value);
+		uint64_t width = LatencyHistogram::bucket_upper_bound(index) -
+						 LatencyHistogram::bucket_lower_bound(index);
+		REQUIRE(width <= value / LatencyHistogram::kSubBuckets);
+	}
+	REQUIRE(LatencyHistogram::bucket_index(UINT64_MAX) == LatencyHistogram::kBucketCount - 1);
+}
+
+TEST_CASE("Histogram percentiles track recorded samples", "[metrics]") {
+	LatencyHistogram histogram;
+	for(uint64_t i = 1; i <= 1000; i++) {
+		histogram.record(i * 1000);
+	}
+
+	HistogramSnapshot snapshot = histogram.snapshot();
+	REQUIRE(snapshot.count == 1000);
+	REQUIRE(snapshot.max == 1000000);
+	REQUIRE(snapshot.mean() == 500500.0);
+	// Percentiles report the top of their bucket, at most 1/16 above the true value.
+	REQUIRE(snapshot.percentile(0.5) >= 500000);
+	REQUIRE(snapshot.percentile(0.5) <= 500000 + 500000 / 16);
+	REQUIRE(snapshot.percentile(0.99) >= 990000);
+	REQUIRE(snapshot.percentile(0.99) <= 990000 + 990000 / 16);
+	REQUIRE(snapshot.percentile(1.0) == 1000000);
+	REQUIRE(HistogramSnapshot{ }.percentile(0.99) == 0);
+}
+
+TEST_CASE("Histogram records concurrently without losing samples", "[metrics][concurrent]") {
+	LatencyHistogram histogram;
+	std::vector<std::thread> threads;
+	for(int t = 0; t < 4; t++) {
+		threads.emplace_back([&histogram, t] {
+			for(uint64_t i = 0; i < 10000; i++) {
+				histogram.record(i * static_cast<uint64_t>(t + 1));
+			}
+		});
+	}
+	for(auto& thread : threads) {
+		thread.join();
+	}
+	REQUIRE(histogram.snapshot().count == 40000);
+}
+
+TEST_CASE("OpenMetrics rendering emits summaries and escaped labels", "[metrics]") {
+	LatencyHistogram execute;
+	execute.record(2000000);
+
+	MetricsSnapshot snapshot;
+	HandlerMetricsSnapshot handler;
+	handler.handler = "mod.\"entry\"";
+	handler.id = 7;
+	handler.total_enqueued = 3;
+	handler.execute_batch_ns = execute.snapshot();
+	snapshot.handlers.push_back(handler);
+
+	std::string text = renderOpenMetrics(snapshot);
+	REQUIRE(text.find("# TYPE pyscheduler_enqueued counter\n") != std::string::npos);
+	REQUIRE(text.find("pyscheduler_enqueued_total{handler=\"mod.\\\"entry\\\"\",id=\"7\"} 3\n") !=
+			std::string::npos);
+	REQUIRE(text.find("# TYPE pyscheduler_execute_batch_seconds summary\n") != std::string::npos);
+	REQUIRE(text.find("pyscheduler_execute_batch_seconds_count{handler=\"mod.\\\"entry\\\"\","
+					  "id=\"7\"} 1\n") != std::string::npos);
+	REQUIRE(text.find("quantile=\"0.999\"} 0.002") != std::string::npos);
+	REQUIRE(text.size() >= 6);
+	REQUIRE(text.compare(text.size() - 6, 6, "# EOF\n") == 0);
+}
@@ -0,0 +1,22 @@
+import asyncio
+
+running = 0
+peak = 0
+
+
+async def invoke(items):
+    global running, peak
+    running += 1
+    peak = max(peak, running)
+    await asyncio.sleep(0.02)  # stands in for a request to a model server
+    running -= 1
+    return [item + 1 for item in items]
+
+
+async def broken(items):
+    await asyncio.sleep(0)
+    raise RuntimeError("upstream unavailable")
+
+
+def peak_inflight():
+    return peak
@@ -0,0 +1,19 @@
+"""Pure-Python baselines for tests/bench_baseline.cpp.
+
+run_sleep replays examples/multithreaded/main.py; run_identity is the same per-request
+call pattern on the identity handler used by the CPU benchmarks.
+"""
+
+from examples.multithreaded.python_modules.module_a import invoke as invoke_a
+from examples.multithreaded.python_modules.module_b import invoke as invoke_b
+from tests.test_modules.identity import invoke as identity
+
+
+def run_sleep(num_requests: int, sleep_seconds: float) -> int:
+    results_a = [invoke_a([sleep_seconds])[0] for _ in range(num_requests)]
+    results_b = [invoke_b([sleep_seconds])[0] for _ in range(num_requests)]
+    return len(results_a) + len(results_b)
+
+
+def run_identity(num_requests: int) -> int:
+    return sum(identity([i])[0] for i in range(num_requests))
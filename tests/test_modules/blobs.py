@@ -0,0 +1,11 @@
+def describe(items):
+    # (type, readonly, size, first byte) of each committed payload
+    return [(type(item).__name__, memoryview(item).readonly, len(item), item[0]) for item in items]
+
+
+def lengths(items):
+    return [len(item) for item in items]
+
+
+def make(sizes):
+    return [bytes(size) for size in sizes]
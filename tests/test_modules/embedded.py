@@ -0,0 +1,53 @@
+import concurrent.futures
+
+import pyscheduler
+
+
+def buffer_sums(names):
+    # Each name refers to a float32 buffer registered from C++; nothing is copied
+    return [sum(memoryview(pyscheduler.buffer(name)).cast("f")) for name in names]
+
+
+def double(items):
+    return [2 * n for n in items]
+
+
+def fan_out(items):
+    # Hands every item to the "doubler" handler and gathers the results
+    futures = [pyscheduler.submit("doubler", n) for n in items]
+    return [future.result() + 1 for future in futures]
+
+
+def submit_error(items):
+    results = []
+    for name in items:
+        try:
+            pyscheduler.submit(name, 0)
+            results.append("ok")
+        except KeyError:
+            results.append("key")
+        except ValueError:
+            results.append("value")
+    return results
+
+
+def submit_until_gone(names):
+    # Submits until the named handler is gone; every future must still resolve
+    results = []
+    for name in names:
+        futures = []
+        while True:
+            try:
+                futures.append(pyscheduler.submit(name, len(futures)))
+            except KeyError:
+                break
+        unresolved = 0
+        for future in futures:
+            try:
+                future.result(timeout=10)
+            except concurrent.futures.TimeoutError:
+                unresolved += 1
+            except Exception:
+                pass
+        results.append(unresolved)
+    return results
@@ -0,0 +1,16 @@
+batches = []
+
+
+def key_of(item):
+    return len(item) if isinstance(item, str) else item % 3
+
+
+def invoke(items):
+    batches.append(sorted({key_of(item) for item in items}))
+    return [key_of(item) for item in items]
+
+
+def take_batches():
+    taken = list(batches)
+    batches.clear()
+    return taken
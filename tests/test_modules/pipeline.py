@@ -0,0 +1,26 @@
+calls = []
+
+
+def tokenize(items):
+    calls.append(("tokenize", len(items)))
+    return [str(item) for item in items]
+
+
+def model(tokens):
+    calls.append(("model", len(tokens)))
+    return [int(token) * 2 for token in tokens]
+
+
+def postprocess(values):
+    calls.append(("postprocess", len(values)))
+    return [value + 1 for value in values]
+
+
+def drop_first(items):
+    return items[1:]
+
+
+def take_calls():
+    taken = list(calls)
+    calls.clear()
+    return taken
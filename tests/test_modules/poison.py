@@ -0,0 +1,13 @@
+import time
+
+
+def warmup():
+    # Holds the worker back so the test's requests form a single batch
+    time.sleep(0.2)
+
+
+def invoke(items):
+    for item in items:
+        if item < 0:
+            raise ValueError(f"poison item {item}")
+    return [item * 2 for item in items]
@@ -0,0 +1,9 @@
+def square(x):
+    return x * x
+
+
+def invoke(items):
+    out = []
+    for item in items:
+        out.append(square(item))
+    return out
@@ -0,0 +1,21 @@
+import threading
+import time
+
+lock = threading.Lock()
+running = 0
+peak = 0
+
+
+def invoke(items):
+    global running, peak
+    with lock:
+        running += 1
+        peak = max(peak, running)
+    time.sleep(0.01)  # releases the GIL, like a torch or numpy kernel
+    with lock:
+        running -= 1
+    return [item * 2 for item in items]
+
+
+def peak_concurrency():
+    return peak
@@ -0,0 +1,18 @@
+import array
+
+
+def scaled(items):
+    # One float32 row per item, exported through the buffer protocol
+    return [array.array("f", [float(n * i) for i in range(4)]) for n in items]
+
+
+def scaled_list(items):
+    return [[float(n * i) for i in range(4)] for n in items]
+
+
+def short(items):
+    return [array.array("f", [float(n)]) for n in items]
+
+
+def ints(items):
+    return [array.array("i", [n * i for i in range(4)]) for n in items]
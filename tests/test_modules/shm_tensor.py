@@ -0,0 +1,14 @@
+try:
+    import torch
+except ImportError:
+    torch = None
+
+
+def has_torch() -> bool:
+    return torch is not None
+
+
+def scale_in_place(capsule, factor):
+    tensor = torch.utils.dlpack.from_dlpack(capsule)
+    tensor.mul_(factor)
+    return float(tensor.sum())
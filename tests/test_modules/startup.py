@@ -0,0 +1,5 @@
+import sys
+
+
+def invoke():
+    return sys.flags.optimize
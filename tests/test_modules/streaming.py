@@ -0,0 +1,11 @@
+def generate(items):
+    # Item n yields n tokens, one per step, interleaved across the batch
+    for step in range(max(items, default=0)):
+        for index, count in enumerate(items):
+            if step < count:
+                yield index, f"{count}:{step}"
+
+
+def broken(items):
+    yield 0, "first"
+    raise RuntimeError("generation failed")
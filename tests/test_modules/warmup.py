@@ -0,0 +1,21 @@
+warmup_calls = 0
+batch_sizes = []
+
+
+def warmup():
+    global warmup_calls
+    warmup_calls += 1
+    return [10, 20, 30]
+
+
+def broken_warmup():
+    raise RuntimeError("cold start failed")
+
+
+def invoke(items):
+    batch_sizes.append(len(items))
+    return items
+
+
+def stats():
+    return warmup_calls, list(batch_sizes)
@@ -1,11 +1,13 @@
 #include <pyscheduler/pyscheduler.hpp>
 
 #include <memory>
+#include <optional>
 
 using namespace pyscheduler;
 
 namespace {
 std::unique_ptr<PyManager> g_manager;
+std::optional<PyManager::SharedHandler> g_shared;
 }
 
 extern "C" void plugin_start() {
@@ -15,6 +17,7 @@ extern "C" void plugin_start() {
 }
 
 extern "C" void plugin_stop() {
+	g_shared.reset();
 	g_manager.reset();
 }
 
@@ -25,3 +28,9 @@ extern "C" uint64_t plugin_arc_count() {
 extern "C" uintptr_t plugin_shared_state_address() {
 	return PyManager::debug_shared_state_address();
 }
+
+/// @brief Attaches to the process-wide identity handler; returns its address.
+extern "C" uintptr_t plugin_load_shared() {
+	g_shared.emplace(g_manager->loadShared("tests.test_modules.identity", "invoke", 8, 2));
+	return reinterpret_cast<uintptr_t>(&**g_shared);
+}
@@ -0,0 +1,114 @@
+#include "pyscheduler/shm_tensor.hpp"
+#include <catch2/catch_all.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace pyscheduler;
+
+namespace {
+float* floatData(DLManagedTensor* tensor) {
+	return static_cast<float*>(tensor->dl_tensor.data);
+}
+} // namespace
+
+TEST_CASE("Shared-memory tensors carve aligned storage from an arena", "[shm]") {
+	auto arena = ShmArena::create(4096);
+	DLManagedTensor* a = createShmTensorDlpack<float>(arena, { 2, 3 });
+	DLManagedTensor* b = createShmTensorDlpack<int64_t>(arena, { 4 });
+
+	REQUIRE(a->dl_tensor.device.device_type == kDLCPU);
+	REQUIRE(a->dl_tensor.ndim == 2);
+	REQUIRE(a->dl_tensor.shape[0] == 2);
+	REQUIRE(a->dl_tensor.shape[1] == 3);
+	REQUIRE(reinterpret_cast<uintptr_t>(a->dl_tensor.data) % 64 == 0);
+	REQUIRE(reinterpret_cast<uintptr_t>(b->dl_tensor.data) % 64 == 0);
+	REQUIRE(a->dl_tensor.data != b->dl_tensor.data);
+
+	ShmTensorDescriptor descriptor = describeShmTensor(b);
+	REQUIRE(descriptor.fd == arena->fd());
+	REQUIRE(descriptor.nbytes() == 4 * sizeof(int64_t));
+	REQUIRE(descriptor.dtype.code == kDLInt);
+	REQUIRE(descriptor.dtype.bits == 64);
+
+	REQUIRE_THROWS_AS(createShmTensorDlpack<float>(arena, { 4096 }), std::bad_alloc);
+
+	a->deleter(a);
+	b->deleter(b);
+}
+
+TEST_CASE("Imported shared-memory tensors alias the exporter's bytes", "[shm]") {
+	auto arena = ShmArena::create(1 << 16);
+	// Push the tensor off a page boundary so the importer has to align its mapping.
+	(void)arena->allocate(5000);
+	DLManagedTensor* source = createShmTensorDlpack<float>(arena, { 8 });
+	std::iota(floatData(source), floatData(source) + 8, 0.f);
+
+	DLManagedTensor* view = importShmTensorDlpack(describeShmTensor(source));
+	REQUIRE(view->dl_tensor.data != source->dl_tensor.data);
+	REQUIRE(floatData(view)[7] == 7.f);
+
+	floatData(view)[0] = 42.f;
+	REQUIRE(floatData(source)[0] == 42.f);
+
+	// Imported tensors can be re-exported and outlive the original tensor and arena.
+	ShmTensorDescriptor again = describeShmTensor(view);
+	REQUIRE(again.offset == describeShmTensor(source).offset);
+	source->deleter(source);
+	arena.reset();
+	REQUIRE(floatData(view)[7] == 7.f);
+	view->deleter(view);
+
+	auto small = ShmArena::create(64);
+	ShmTensorDescriptor past_end;
+	past_end.fd = small->fd();
+	past_end.offset = 128;
+	REQUIRE_THROWS_AS(importShmTensorDlpack(past_end), std::invalid_argument);
+}
+
+TEST_CASE("Shared-memory tensor descriptors cross process boundaries", "[shm]") {
+	int sockets[2];
+	REQUIRE(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets) == 0);
+
+	auto arena = ShmArena::create(4096);
+	DLManagedTensor* tensor = createShmTensorDlpack<float>(arena, { 3, 4 });
+	std::fill(floatData(tensor), floatData(tensor) + 12, 1.f);
+
+	pid_t child = fork();
+	REQUIRE(child >= 0);
+	if(child == 0) {
+		// The child only touches the socket and its own mapping, never the interpreter.
+		close(sockets[0]);
+		int status = 1;
+		try {
+			ShmTensorDescriptor received = receiveShmTensorDescriptor(sockets[1]);
+			DLManagedTensor* view = importShmTensorDlpack(received);
+			close(received.fd);
+			for(int i = 0; i < 12; i++) {
+				floatData(view)[i] *= static_cast<float>(i);
+			}
+			view->deleter(view);
+			status = 0;
+		} catch(...) {
+		}
+		_exit(status);
+	}
+
+	close(sockets[1]);
+	sendShmTensorDescriptor(sockets[0], describeShmTensor(tensor));
+	int status = 0;
+	REQUIRE(waitpid(child, &status, 0) == child);
+	close(sockets[0]);
+	REQUIRE(WIFEXITED(status));
+	REQUIRE(WEXITSTATUS(status) == 0);
+
+	for(int i = 0; i < 12; i++) {
+		REQUIRE(floatData(tensor)[i] == static_cast<float>(i));
+	}
+	tensor->deleter(tensor);
+}
@@ -0,0 +1,100 @@
+#include <pyscheduler/pyscheduler.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace pyscheduler;
+
+namespace {
+void usage() {
+	std::cerr
+		<< "Usage: pyscheduler_replay RECORDING MODULE [ENTRY_POINT] [options]\n"
+		<< "Re-drives MODULE.ENTRY_POINT (default: invoke) with a recording made by\n"
+		<< "InvokeHandler::start_recording with the default pickle serializer.\n"
+		<< "  --batch N        handler batch_size (default: 1)\n"
+		<< "  --prefetch N     handler prefetch_depth (default: 1)\n"
+		<< "  --rate-scale X   replay X times faster than recorded (default: 1)\n"
+		<< "  --path DIR       add DIR to sys.path; repeatable (default: .)\n";
+}
+
+void printPercentiles(const char* label, const HistogramSnapshot& snapshot) {
+	constexpr double kNsToUs = 1e-3;
+	std::printf("%-10s p50 %10.1f us  p99 %10.1f us  p99.9 %10.1f us  max %10.1f us\n",
+				label,
+				static_cast<double>(snapshot.percentile(0.5)) * kNsToUs,
+				static_cast<double>(snapshot.percentile(0.99)) * kNsToUs,
+				static_cast<double>(snapshot.percentile(0.999)) * kNsToUs,
+				static_cast<double>(snapshot.max) * kNsToUs);
+}
+} // namespace
+
+int main(int argc, char** argv) {
+	std::vector<std::string> positional;
+	std::vector<std::string> paths;
+	PyManager::HandlerOptions handler_options;
+	ReplayOptions replay_options;
+	try {
+		for(int i = 1; i < argc; i++) {
+			const std::string arg = argv[i];
+			auto value = [&]() -> std::string {
+				if(i + 1 >= argc) throw std::invalid_argument("missing value for " + arg);
+				return argv[++i];
+			};
+			if(arg == "--batch") {
+				handler_options.batch_size = std::stoul(value());
+			} else if(arg == "--prefetch") {
+				handler_options.prefetch_depth = std::stoul(value());
+			} else if(arg == "--rate-scale") {
+				replay_options.rate_scale = std::stod(value());
+			} else if(arg == "--path") {
+				paths.push_back(value());
+			} else if(arg == "-h" || arg == "--help") {
+				usage();
+				return 0;
+			} else {
+				positional.push_back(arg);
+			}
+		}
+	} catch(const std::exception& e) {
+		std::cerr << "Error: " << e.what() << "\n";
+		usage();
+		return 2;
+	}
+	if(positional.size() < 2 || positional.size() > 3) {
+		usage();
+		return 2;
+	}
+	if(paths.empty()) paths.push_back(".");
+
+	try {
+		std::vector<RecordedRequest> requests = read_traffic(positional[0]);
+		PyManager manager;
+		for(const std::string& path : paths) {
+			manager.add_path(path);
+		}
+		PyManager::InvokeHandler handler = manager.loadPythonModule(
+			positional[1], positional.size() > 2 ? positional[2] : "invoke", handler_options);
+		handler.ready().wait();
+
+		ReplayReport report = replay_traffic(handler, requests, replay_options);
+		const PyManager::InvokeHandler::QueueStats stats = handler.get_queue_stats();
+		std::printf("requests   %zu (%zu failed) in %.3f s, max send lag %.1f us\n",
+					report.requests,
+					report.failed,
+					static_cast<double>(report.duration.count()) * 1e-9,
+					static_cast<double>(report.max_send_lag.count()) * 1e-3);
+		printPercentiles("replayed", report.latency_ns);
+		printPercentiles("recorded", report.recorded_latency_ns);
+		std::printf("batch size %.1f avg, execute %.1f us per batch\n",
+					stats.execute_batch_size_ema,
+					stats.execute_ns_per_batch_ema * 1e-3);
+	} catch(const std::exception& e) {
+		std::cerr << "Error: " << e.what() << "\n";
+		return 1;
+	}
+	return 0;
+}